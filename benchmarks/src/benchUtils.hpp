@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Allocation counting */
+/***********************/
+
+// Heap allocations made by the benchmark executable. Counted by the global
+//  `operator new` replacements below, so this header must only be included
+//  by the translation unit holding `main`.
+std::atomic<std::size_t> allocCount{0};
+
+void * operator new(std::size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void * ptr = std::malloc(size != 0 ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+void operator delete[](void * ptr) noexcept { std::free(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void * ptr, std::size_t) noexcept { std::free(ptr); }
+
+/* Benchmark settings */
+/**********************/
+
+struct BenchOptions
+{
+    double minSeconds = 0.2;  // Minimum measured time of each benchmark
+    std::string filter;       // Only run benchmarks whose name contains it
+};
+
+/**
+ * @brief Parse `--min-time=<seconds>` and `--filter=<substring>`.
+ *  Other arguments are passed to `parseArg`, which returns whether it
+ *  accepted them, and `extraUsage` documents them.
+ *
+ */
+BenchOptions parseBenchOptions(
+    int argc, char ** argv,
+    std::function<bool(std::string const &)> const & parseArg = nullptr,
+    std::string const & extraUsage = "")
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg = argv[i];
+        if (arg.rfind("--min-time=", 0) == 0)
+            options.minSeconds = std::atof(arg.c_str() + 11);
+        else if (arg.rfind("--filter=", 0) == 0)
+            options.filter = arg.substr(9);
+        else if (!parseArg || !parseArg(arg))
+        {
+            std::fprintf(
+                stderr,
+                "Usage: %s [--min-time=<seconds>] [--filter=<substring>]%s\n",
+                argv[0], extraUsage.c_str());
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    return options;
+}
+
+/* Measurement */
+/***************/
+
+typedef std::vector<std::pair<std::string, std::string>> BenchParams;
+
+// Results are accumulated here so that the measured calls are not elided
+volatile double benchSink = 0;
+
+/**
+ * @brief Time and heap allocations of the calls of a measurement.
+ *
+ */
+struct BenchResult
+{
+    double nDocs = 0;
+    double seconds = 0;
+    std::size_t nAllocs = 0;
+
+    double docsPerSec() const { return this->nDocs / this->seconds; }
+    double nsPerDoc() const { return this->seconds * 1e9 / this->nDocs; }
+
+    double allocsPerDoc() const
+    {
+        return static_cast<double>(this->nAllocs) / this->nDocs;
+    }
+};
+
+/**
+ * @brief Call `fun` once to warm up, then as many times as needed for at
+ *  least `minSeconds` to elapse, `fun` handling `docsPerCall` documents per
+ *  call.
+ *
+ */
+template <class Fun>
+BenchResult measureBenchmark(
+    double const minSeconds, std::size_t const docsPerCall, Fun && fun)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    fun();  // Warm up
+
+    std::size_t nCalls = 1;
+    while (true)
+    {
+        std::size_t const allocsBefore = allocCount.load();
+        auto const start = Clock::now();
+
+        for (std::size_t i = 0; i < nCalls; ++i) fun();
+
+        BenchResult result;
+        result.seconds =
+            std::chrono::duration<double>(Clock::now() - start).count();
+        result.nAllocs = allocCount.load() - allocsBefore;
+        result.nDocs = static_cast<double>(nCalls * docsPerCall);
+
+        if (result.seconds >= minSeconds || nCalls >= (std::size_t(1) << 40))
+            return result;
+
+        nCalls *= 2;
+    }
+}
+
+/**
+ * @brief Measure `fun` for at least `minSeconds`, then print one JSON line
+ *  with the time and allocations per document, `fun` handling
+ *  `docsPerCall` documents per call. If `queriesPerCall` is given, the
+ *  document and query throughputs are printed as well.
+ *
+ */
+template <class Fun>
+void runBenchmark(
+    BenchOptions const & options, std::string const & name,
+    BenchParams const & params, std::size_t const docsPerCall, Fun && fun,
+    std::size_t const queriesPerCall = 0)
+{
+    if (name.find(options.filter) == std::string::npos) return;
+
+    BenchResult const result = measureBenchmark(
+        options.minSeconds, docsPerCall, std::forward<Fun>(fun));
+
+    std::printf("{\"benchmark\":\"%s\"", name.c_str());
+    for (auto const & [key, value] : params)
+        std::printf(",\"%s\":%s", key.c_str(), value.c_str());
+    std::printf(
+        ",\"docs\":%.0f,\"ns_per_doc\":%.3f,\"allocs_per_doc\":%.3f",
+        result.nDocs, result.nsPerDoc(), result.allocsPerDoc());
+    if (queriesPerCall != 0)
+    {
+        double const nQueries =
+            result.nDocs / static_cast<double>(docsPerCall) *
+            static_cast<double>(queriesPerCall);
+        std::printf(
+            ",\"docs_per_sec\":%.1f,\"queries_per_sec\":%.3f",
+            result.docsPerSec(), nQueries / result.seconds);
+    }
+    std::printf("}\n");
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Quote a string as a JSON value.
+ *
+ */
+std::string jsonString(std::string const & value)
+{
+    return '"' + value + '"';
+}
@@ -0,0 +1,191 @@
+#include <lowletorfeats/LMIR.hpp>
+#include <lowletorfeats/Okapi.hpp>
+#include <lowletorfeats/Tfidf.hpp>
+#include <lowletorfeats/utils.hpp>
+#include <random>
+
+#include "benchUtils.hpp"
+
+using namespace lowletorfeats;
+
+// Number of documents scored per measured call
+std::size_t const DOCS_PER_CALL = 64;
+
+std::size_t const NUM_DOCS = 100000;
+
+/**
+ * @brief Synthetic documents and query statistics for a query length and a
+ *  document term frequency map size.
+ *
+ */
+template <class TfMap, class StructuredTfMap>
+struct ScorerData
+{
+    std::vector<TfMap> docTfMaps;
+    std::vector<StructuredTfMap> structDocTfMaps;
+    std::vector<std::size_t> docLens;
+    std::vector<std::size_t> docMaxTfs;
+
+    TfMap queryTfMap;
+    base::StrSizeMap docsWithTermMap;
+    base::StructuredTermFrequencyMap structDocsWithTermMap;
+    base::StrFltMap avgDocLenMap;
+    std::unordered_map<std::string, base::WeightType> sectionWeights = {
+        {"full", 0.3}, {"title", 1}, {"body", 0.4}};
+
+    LMIR lime;
+    float avgDocLen = 0;
+
+    ScorerData(std::size_t const queryLen, std::size_t const tfMapSize)
+    {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(
+            queryLen * 7919 + tfMapSize));
+
+        // Documents draw their terms from a vocabulary of 4 times their size
+        std::size_t const vocabSize = 4 * tfMapSize;
+        auto const term = [](std::size_t const termIdx) {
+            return "t" + std::to_string(termIdx);
+        };
+
+        base::StrSizeMap corpusTfMap;
+        std::size_t docLenSum = 0;
+        for (std::size_t docIdx = 0; docIdx < DOCS_PER_CALL; ++docIdx)
+        {
+            base::StrSizeMap bodyTfMap;
+            base::StrSizeMap titleTfMap;
+            while (bodyTfMap.size() < tfMapSize)
+                bodyTfMap[term(rng() % vocabSize)] = 1 + rng() % 8;
+            while (titleTfMap.size() < tfMapSize / 8 + 1)
+                titleTfMap[term(rng() % vocabSize)] = 1 + rng() % 2;
+
+            base::StrSizeMap fullTfMap = bodyTfMap;
+            utils::additiveMergeInplace(fullTfMap, titleTfMap);
+
+            std::size_t const docLen = utils::mapValueSum(fullTfMap);
+            docLenSum += docLen;
+            utils::additiveMergeInplace(corpusTfMap, fullTfMap);
+
+            this->docTfMaps.emplace_back(fullTfMap.begin(), fullTfMap.end());
+            this->docLens.push_back(docLen);
+            this->docMaxTfs.push_back(
+                utils::findMaxValuePair(fullTfMap).second);
+
+            StructuredTfMap & structTfMap =
+                this->structDocTfMaps.emplace_back();
+            structTfMap["body"].insert(bodyTfMap.begin(), bodyTfMap.end());
+            structTfMap["title"].insert(titleTfMap.begin(), titleTfMap.end());
+            structTfMap["full"].insert(fullTfMap.begin(), fullTfMap.end());
+        }
+        this->avgDocLen = static_cast<float>(docLenSum) /
+                          static_cast<float>(DOCS_PER_CALL);
+
+        // Query terms are spread over the whole vocabulary
+        while (this->queryTfMap.size() < queryLen)
+        {
+            std::string const queryTerm = term(rng() % vocabSize);
+            this->queryTfMap.insert({queryTerm, 1});
+
+            std::size_t const df = 1 + rng() % (NUM_DOCS / 10);
+            this->docsWithTermMap[queryTerm] = df;
+            for (auto const & section : {"body", "title", "full"})
+                this->structDocsWithTermMap[section][queryTerm] = df;
+        }
+
+        for (auto const & section : {"body", "title", "full"})
+            this->avgDocLenMap[section] = this->avgDocLen;
+
+        this->lime = LMIR(corpusTfMap);
+    }
+};
+
+template <class TfMap, class StructuredTfMap>
+void benchmarkScorers(
+    BenchOptions const & options, std::string const & mapType)
+{
+    for (std::size_t const queryLen : {1, 4, 16})
+    {
+        for (std::size_t const tfMapSize : {8, 64, 512})
+        {
+            ScorerData<TfMap, StructuredTfMap> const data(queryLen, tfMapSize);
+
+            BenchParams const params = {
+                {"map_type", jsonString(mapType)},
+                {"query_len", std::to_string(queryLen)},
+                {"tf_map_size", std::to_string(tfMapSize)}};
+
+            // Run a scorer over every document of `data`
+            auto const run = [&](std::string const & name, auto && scorer) {
+                runBenchmark(options, name, params, DOCS_PER_CALL, [&]() {
+                    base::FValType sum = 0;
+                    for (std::size_t docIdx = 0; docIdx < DOCS_PER_CALL;
+                         ++docIdx)
+                        sum += scorer(docIdx);
+                    benchSink = benchSink + sum;
+                });
+            };
+
+            run("Tfidf::sumTfLogNorm", [&](std::size_t const docIdx) {
+                return Tfidf::sumTfLogNorm(data.docTfMaps[docIdx]);
+            });
+            run("Tfidf::sumTfDoubleNorm", [&](std::size_t const docIdx) {
+                return Tfidf::sumTfDoubleNorm(
+                    data.docTfMaps[docIdx], data.docMaxTfs[docIdx]);
+            });
+            run("Tfidf::queryTfidf", [&](std::size_t const docIdx) {
+                return Tfidf::queryTfidf(
+                    data.docTfMaps[docIdx], data.docMaxTfs[docIdx], NUM_DOCS,
+                    data.docsWithTermMap, data.queryTfMap);
+            });
+            run("Okapi::queryBm25", [&](std::size_t const docIdx) {
+                return Okapi::queryBm25(
+                    data.docTfMaps[docIdx], NUM_DOCS, data.docsWithTermMap,
+                    data.avgDocLen, data.queryTfMap);
+            });
+            run("Okapi::queryBm25plus", [&](std::size_t const docIdx) {
+                return Okapi::queryBm25plus(
+                    data.docTfMaps[docIdx], NUM_DOCS, data.docsWithTermMap,
+                    data.avgDocLen, data.queryTfMap);
+            });
+            run("Okapi::queryBm25f", [&](std::size_t const docIdx) {
+                return Okapi::queryBm25f(
+                    data.structDocTfMaps[docIdx], NUM_DOCS,
+                    data.structDocsWithTermMap, data.avgDocLenMap,
+                    data.queryTfMap, data.sectionWeights);
+            });
+            run("Okapi::queryBm25fplus", [&](std::size_t const docIdx) {
+                return Okapi::queryBm25fplus(
+                    data.structDocTfMaps[docIdx], NUM_DOCS,
+                    data.structDocsWithTermMap, data.avgDocLenMap,
+                    data.queryTfMap, data.sectionWeights);
+            });
+            run("LMIR::absolute_discount", [&](std::size_t const docIdx) {
+                return data.lime.absolute_discount(
+                    data.docTfMaps[docIdx], data.docLens[docIdx],
+                    data.queryTfMap);
+            });
+            run("LMIR::dirichlet", [&](std::size_t const docIdx) {
+                return data.lime.dirichlet(
+                    data.docTfMaps[docIdx], data.docLens[docIdx],
+                    data.queryTfMap);
+            });
+            run("LMIR::jelinek_mercer", [&](std::size_t const docIdx) {
+                return data.lime.jelinek_mercer(
+                    data.docTfMaps[docIdx], data.docLens[docIdx],
+                    data.queryTfMap);
+            });
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    BenchOptions const options = parseBenchOptions(argc, argv);
+
+    benchmarkScorers<
+        base::FlatStrSizeMap, base::StructuredFlatTermFrequencyMap>(
+        options, "FlatStrSizeMap");
+    benchmarkScorers<base::StrSizeMap, base::StructuredTermFrequencyMap>(
+        options, "StrSizeMap");
+
+    return 0;
+}
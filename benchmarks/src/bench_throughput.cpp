@@ -0,0 +1,215 @@
+#include <atomic>
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <sstream>
+#include <thread>
+
+#include "benchUtils.hpp"
+#include "syntheticCorpus.hpp"
+
+using namespace lowletorfeats;
+
+// Distinct candidate lists per candidate size, assigned to queries in turn
+std::size_t const NUM_CANDIDATE_LISTS = 4;
+
+struct ThroughputOptions
+{
+    CorpusOptions corpus;
+
+    std::vector<std::size_t> threadCounts;
+    std::vector<std::size_t> candidateSizes = {10, 100, 1000};
+    std::size_t numQueries = 32;  // Queries per measured call
+
+    bool rawText = false;  // Include text analysis in the measurement
+};
+
+/**
+ * @brief Candidate documents of a query, preanalyzed or as raw text.
+ *
+ */
+struct CandidateList
+{
+    std::vector<base::StrSizeMap> docLenMaps;
+    std::vector<base::StructuredTermFrequencyMap> docTfMaps;
+    std::vector<base::StrStrMap> docTexts;
+};
+
+std::vector<std::size_t> parseSizeList(std::string const & str)
+{
+    std::vector<std::size_t> sizeVect;
+
+    std::stringstream strStream(str);
+    std::string item;
+    while (std::getline(strStream, item, ','))
+        sizeVect.push_back(std::stoul(item));
+
+    return sizeVect;
+}
+
+/**
+ * @brief Parse `name:meanLen` section specifications.
+ *
+ */
+std::vector<SectionSpec> parseSections(std::string const & str)
+{
+    std::vector<SectionSpec> sectionVect;
+
+    std::stringstream strStream(str);
+    std::string item;
+    while (std::getline(strStream, item, ','))
+    {
+        auto const sepPos = item.find(':');
+        sectionVect.push_back(
+            {item.substr(0, sepPos), std::stod(item.substr(sepPos + 1))});
+    }
+
+    return sectionVect;
+}
+
+int main(int argc, char ** argv)
+{
+    ThroughputOptions opts;
+
+    BenchOptions const options = parseBenchOptions(
+        argc, argv,
+        [&](std::string const & arg) {
+            auto const value = [&](std::string const & name) {
+                return arg.substr(name.size());
+            };
+
+            if (arg.rfind("--threads=", 0) == 0)
+                opts.threadCounts = parseSizeList(value("--threads="));
+            else if (arg.rfind("--candidates=", 0) == 0)
+                opts.candidateSizes = parseSizeList(value("--candidates="));
+            else if (arg.rfind("--queries=", 0) == 0)
+                opts.numQueries = std::stoul(value("--queries="));
+            else if (arg.rfind("--vocab=", 0) == 0)
+                opts.corpus.vocabSize = std::stoul(value("--vocab="));
+            else if (arg.rfind("--zipf=", 0) == 0)
+                opts.corpus.zipfExponent = std::stod(value("--zipf="));
+            else if (arg.rfind("--sections=", 0) == 0)
+                opts.corpus.sections = parseSections(value("--sections="));
+            else if (arg.rfind("--length-sigma=", 0) == 0)
+                opts.corpus.lengthSigma = std::stod(value("--length-sigma="));
+            else if (arg.rfind("--seed=", 0) == 0)
+                opts.corpus.seed =
+                    static_cast<std::uint32_t>(std::stoul(value("--seed=")));
+            else if (arg == "--raw-text")
+                opts.rawText = true;
+            else
+                return false;
+
+            return true;
+        },
+        " [--threads=1,2,..] [--candidates=10,100,..] [--queries=<n>]"
+        " [--vocab=<n>] [--zipf=<s>] [--sections=title:8,body:300,..]"
+        " [--length-sigma=<sigma>] [--seed=<n>] [--raw-text]");
+
+    // Default to powers of two up to the hardware concurrency
+    if (opts.threadCounts.empty())
+    {
+        std::size_t const maxThreads =
+            std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t nThreads = 1; nThreads < maxThreads; nThreads *= 2)
+            opts.threadCounts.push_back(nThreads);
+        opts.threadCounts.push_back(maxThreads);
+    }
+
+    std::string sectionsStr;
+    for (auto const & section : opts.corpus.sections)
+    {
+        if (!sectionsStr.empty()) sectionsStr += ',';
+        sectionsStr += section.name + ':' + std::to_string(section.meanLen);
+    }
+
+    for (std::size_t const candidateSize : opts.candidateSizes)
+    {
+        // Every candidate size sees the same queries
+        SyntheticCorpus corpus(opts.corpus);
+
+        std::vector<base::StrSizeMap> queryTfMaps;
+        std::vector<std::string> queryTexts;
+        for (std::size_t i = 0; i < opts.numQueries; ++i)
+        {
+            if (opts.rawText)
+                queryTexts.push_back(corpus.generateQueryText());
+            else
+                queryTfMaps.push_back(corpus.generateQuery());
+        }
+
+        std::vector<CandidateList> candidateLists(NUM_CANDIDATE_LISTS);
+        for (auto & candidateList : candidateLists)
+        {
+            for (std::size_t i = 0; i < candidateSize; ++i)
+            {
+                if (opts.rawText)
+                {
+                    candidateList.docTexts.push_back(corpus.generateDocText());
+                    continue;
+                }
+
+                corpus.generateDoc(
+                    candidateList.docLenMaps.emplace_back(),
+                    candidateList.docTfMaps.emplace_back());
+            }
+        }
+
+        // Collect the preset features of one query
+        auto const processQuery = [&](std::size_t const queryIdx) {
+            CandidateList const & candidateList =
+                candidateLists[queryIdx % NUM_CANDIDATE_LISTS];
+
+            if (opts.rawText)
+            {
+                FeatureCollector fc(
+                    candidateList.docTexts, queryTexts[queryIdx]);
+                fc.collectPresetFeatures();
+                return fc.getFeatureMatrix().at(0, 0);
+            }
+
+            FeatureCollector fc(
+                candidateList.docLenMaps, candidateList.docTfMaps,
+                queryTfMaps[queryIdx]);
+            fc.collectPresetFeatures();
+            return fc.getFeatureMatrix().at(0, 0);
+        };
+
+        for (std::size_t const nThreads : opts.threadCounts)
+        {
+            BenchParams const params = {
+                {"threads", std::to_string(nThreads)},
+                {"candidates", std::to_string(candidateSize)},
+                {"raw_text", opts.rawText ? "true" : "false"},
+                {"vocab", std::to_string(opts.corpus.vocabSize)},
+                {"zipf", std::to_string(opts.corpus.zipfExponent)},
+                {"sections", jsonString(sectionsStr)}};
+
+            runBenchmark(
+                options, "FeatureCollector", params,
+                opts.numQueries * candidateSize,
+                [&]() {
+                    std::atomic<std::size_t> nextQueryIdx{0};
+                    std::vector<base::FValType> threadSums(nThreads, 0);
+
+                    // Threads take the next unprocessed query
+                    auto const worker = [&](std::size_t const threadIdx) {
+                        for (std::size_t queryIdx = nextQueryIdx++;
+                             queryIdx < opts.numQueries;
+                             queryIdx = nextQueryIdx++)
+                            threadSums[threadIdx] += processQuery(queryIdx);
+                    };
+
+                    std::vector<std::thread> threads;
+                    for (std::size_t i = 1; i < nThreads; ++i)
+                        threads.emplace_back(worker, i);
+                    worker(0);
+                    for (auto & thread : threads) thread.join();
+
+                    for (auto const sum : threadSums)
+                        benchSink = benchSink + sum;
+                },
+                opts.numQueries);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <algorithm>  // max
+#include <fstream>
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include "benchUtils.hpp"
+#include "syntheticCorpus.hpp"
+
+using namespace lowletorfeats;
+
+// Exit code making CTest report the test as skipped
+int const SKIP_RETURN_CODE = 77;
+
+std::size_t const NUM_QUERIES = 16;
+
+/**
+ * @brief Fixed workload collecting the preset features of `NUM_QUERIES`
+ *  queries over synthetic candidate lists.
+ *
+ */
+struct Workload
+{
+    std::string name;
+    std::size_t candidateSize;
+    bool rawText;
+};
+
+std::vector<Workload> const WORKLOADS = {
+    {"preanalyzed_100", 100, false},
+    {"preanalyzed_1000", 1000, false},
+    {"raw_text_100", 100, true}};
+
+/**
+ * @brief Baseline or measured throughput and allocations of a workload.
+ *
+ */
+struct PerfRecord
+{
+    double docsPerSec = 0;
+    double allocsPerDoc = 0;
+};
+
+struct RegressionOptions
+{
+    std::string baselinePath;       // Baseline to compare against
+    std::string writeBaselinePath;  // Where to write a new baseline
+
+    double tolerance = 0.3;        // Allowed relative throughput drop
+    double allocTolerance = 0.02;  // Allowed relative allocation increase
+
+    std::size_t repetitions = 3;  // The best throughput is kept
+};
+
+/**
+ * @brief Read a baseline of `name docs_per_sec allocs_per_doc` lines.
+ *  Empty lines and lines starting with '#' are ignored.
+ *
+ */
+std::map<std::string, PerfRecord> readBaseline(std::string const & path)
+{
+    std::ifstream inStream(path);
+    if (!inStream)
+        throw std::runtime_error("Could not open baseline '" + path + "'");
+
+    std::map<std::string, PerfRecord> baselineMap;
+
+    std::string line;
+    while (std::getline(inStream, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::stringstream lineStream(line);
+        std::string name;
+        PerfRecord record;
+        if (!(lineStream >> name >> record.docsPerSec >> record.allocsPerDoc))
+            throw std::runtime_error("Malformed baseline line '" + line + "'");
+
+        baselineMap[name] = record;
+    }
+
+    return baselineMap;
+}
+
+void writeBaseline(
+    std::string const & path,
+    std::map<std::string, PerfRecord> const & recordMap)
+{
+    std::ofstream outStream(path);
+    if (!outStream)
+        throw std::runtime_error("Could not open baseline '" + path + "'");
+
+    outStream << "# Written by --write-baseline from a Release build, regenerate"
+                 " it on the\n# machine running the test\n"
+                 "# workload docs_per_sec allocs_per_doc\n";
+    for (auto const & [name, record] : recordMap)
+        outStream << name << ' ' << record.docsPerSec << ' '
+                  << record.allocsPerDoc << '\n';
+}
+
+/**
+ * @brief Measure a workload, keeping the best throughput of the
+ *  repetitions.
+ *
+ */
+PerfRecord measureWorkload(
+    Workload const & workload, BenchOptions const & options,
+    RegressionOptions const & opts)
+{
+    SyntheticCorpus corpus{CorpusOptions()};
+
+    std::vector<base::StrSizeMap> queryTfMaps;
+    std::vector<std::string> queryTexts;
+    std::vector<base::StrSizeMap> docLenMaps;
+    std::vector<base::StructuredTermFrequencyMap> docTfMaps;
+    std::vector<base::StrStrMap> docTexts;
+    for (std::size_t i = 0; i < NUM_QUERIES; ++i)
+    {
+        if (workload.rawText)
+            queryTexts.push_back(corpus.generateQueryText());
+        else
+            queryTfMaps.push_back(corpus.generateQuery());
+    }
+    for (std::size_t i = 0; i < workload.candidateSize; ++i)
+    {
+        if (workload.rawText)
+            docTexts.push_back(corpus.generateDocText());
+        else
+            corpus.generateDoc(
+                docLenMaps.emplace_back(), docTfMaps.emplace_back());
+    }
+
+    auto const run = [&]() {
+        for (std::size_t queryIdx = 0; queryIdx < NUM_QUERIES; ++queryIdx)
+        {
+            if (workload.rawText)
+            {
+                FeatureCollector fc(docTexts, queryTexts[queryIdx]);
+                fc.collectPresetFeatures();
+                benchSink = benchSink + fc.getFeatureMatrix().at(0, 0);
+                continue;
+            }
+
+            FeatureCollector fc(
+                docLenMaps, docTfMaps, queryTfMaps[queryIdx]);
+            fc.collectPresetFeatures();
+            benchSink = benchSink + fc.getFeatureMatrix().at(0, 0);
+        }
+    };
+
+    PerfRecord record;
+    for (std::size_t i = 0; i < opts.repetitions; ++i)
+    {
+        BenchResult const result = measureBenchmark(
+            options.minSeconds, NUM_QUERIES * workload.candidateSize, run);
+
+        record.docsPerSec = std::max(record.docsPerSec, result.docsPerSec());
+        record.allocsPerDoc = result.allocsPerDoc();
+    }
+
+    return record;
+}
+
+/**
+ * @brief Measure every workload, compare it to the baseline and write the
+ *  new baseline, as requested.
+ *
+ * @return int The exit code, failure on any regression.
+ */
+int compareWorkloads(
+    BenchOptions const & options, RegressionOptions const & opts)
+{
+    std::map<std::string, PerfRecord> baselineMap;
+    if (!opts.baselinePath.empty())
+        baselineMap = readBaseline(opts.baselinePath);
+
+    std::map<std::string, PerfRecord> recordMap;
+    bool hasRegressed = false;
+
+    for (auto const & workload : WORKLOADS)
+    {
+        if (workload.name.find(options.filter) == std::string::npos) continue;
+
+        PerfRecord const record = measureWorkload(workload, options, opts);
+        recordMap[workload.name] = record;
+
+        std::printf(
+            "{\"workload\":\"%s\",\"docs_per_sec\":%.1f,"
+            "\"allocs_per_doc\":%.3f",
+            workload.name.c_str(), record.docsPerSec, record.allocsPerDoc);
+
+        if (opts.baselinePath.empty())
+        {
+            std::printf("}\n");
+            continue;
+        }
+
+        auto const baselineIt = baselineMap.find(workload.name);
+        if (baselineIt == baselineMap.end())
+        {
+            std::printf("}\n");
+            std::fprintf(
+                stderr, "REGRESSION %s: no baseline, regenerate it\n",
+                workload.name.c_str());
+            hasRegressed = true;
+            continue;
+        }
+
+        PerfRecord const & baseline = baselineIt->second;
+        double const throughputRatio =
+            record.docsPerSec / baseline.docsPerSec;
+        double const allocRatio =
+            (baseline.allocsPerDoc > 0)
+                ? record.allocsPerDoc / baseline.allocsPerDoc
+                : (record.allocsPerDoc > 0 ? 2 : 1);
+        std::printf(
+            ",\"throughput_ratio\":%.3f,\"alloc_ratio\":%.3f}\n",
+            throughputRatio, allocRatio);
+
+        if (throughputRatio < 1 - opts.tolerance)
+        {
+            std::fprintf(
+                stderr,
+                "REGRESSION %s: %.1f docs/s, baseline %.1f docs/s "
+                "(%.1f%% slower, tolerance %.1f%%)\n",
+                workload.name.c_str(), record.docsPerSec, baseline.docsPerSec,
+                (1 - throughputRatio) * 100, opts.tolerance * 100);
+            hasRegressed = true;
+        }
+        if (allocRatio > 1 + opts.allocTolerance)
+        {
+            std::fprintf(
+                stderr,
+                "REGRESSION %s: %.3f allocations/doc, baseline %.3f "
+                "(tolerance %.1f%%)\n",
+                workload.name.c_str(), record.allocsPerDoc,
+                baseline.allocsPerDoc, opts.allocTolerance * 100);
+            hasRegressed = true;
+        }
+    }
+    std::fflush(stdout);
+
+    if (!opts.writeBaselinePath.empty())
+        writeBaseline(opts.writeBaselinePath, recordMap);
+
+    return hasRegressed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char ** argv)
+{
+    RegressionOptions opts;
+
+    BenchOptions const options = parseBenchOptions(
+        argc, argv,
+        [&](std::string const & arg) {
+            auto const value = [&](std::string const & name) {
+                return arg.substr(name.size());
+            };
+
+            if (arg.rfind("--baseline=", 0) == 0)
+                opts.baselinePath = value("--baseline=");
+            else if (arg.rfind("--write-baseline=", 0) == 0)
+                opts.writeBaselinePath = value("--write-baseline=");
+            else if (arg.rfind("--tolerance=", 0) == 0)
+                opts.tolerance = std::stod(value("--tolerance="));
+            else if (arg.rfind("--alloc-tolerance=", 0) == 0)
+                opts.allocTolerance = std::stod(value("--alloc-tolerance="));
+            else if (arg.rfind("--repetitions=", 0) == 0)
+                opts.repetitions = std::stoul(value("--repetitions="));
+            else
+                return false;
+
+            return true;
+        },
+        " (--baseline=<file> | --write-baseline=<file>) [--tolerance=<f>]"
+        " [--alloc-tolerance=<f>] [--repetitions=<n>]");
+
+    if (opts.baselinePath.empty() == opts.writeBaselinePath.empty())
+    {
+        std::fprintf(
+            stderr, "Exactly one of --baseline and --write-baseline needed\n");
+        return EXIT_FAILURE;
+    }
+
+#ifndef NDEBUG
+    // Unoptimized builds are slower and allocate more, in assertions
+    std::printf("Skipped, performance is only compared in Release builds\n");
+    return SKIP_RETURN_CODE;
+#else
+    return compareWorkloads(options, opts);
+#endif
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Section of the synthetic documents and its mean length in terms.
+ *
+ */
+struct SectionSpec
+{
+    std::string name;
+    double meanLen;
+};
+
+struct CorpusOptions
+{
+    std::size_t vocabSize = 50000;
+    double zipfExponent = 1.0;  // Term of rank r drawn with weight 1 / r^s
+
+    std::vector<SectionSpec> sections = {{"title", 8}, {"body", 300}};
+
+    // Section lengths are log-normal around their mean, fixed if 0
+    double lengthSigma = 0.5;
+
+    std::size_t minQueryLen = 1;
+    std::size_t maxQueryLen = 5;
+
+    std::uint32_t seed = 42;
+};
+
+/**
+ * @brief Deterministic generator of documents and queries over a Zipfian
+ *  vocabulary. The same options always generate the same sequence.
+ *
+ */
+class SyntheticCorpus
+{
+public:
+    explicit SyntheticCorpus(CorpusOptions const & options)
+        : options(options), rng(options.seed)
+    {
+        // Cumulative weight of every term rank
+        this->termCdf.reserve(options.vocabSize);
+        double weightSum = 0;
+        for (std::size_t rank = 1; rank <= options.vocabSize; ++rank)
+        {
+            weightSum +=
+                1 / std::pow(static_cast<double>(rank), options.zipfExponent);
+            this->termCdf.push_back(weightSum);
+        }
+
+        this->terms.reserve(options.vocabSize);
+        for (std::size_t rank = 0; rank < options.vocabSize; ++rank)
+            this->terms.push_back(SyntheticCorpus::makeTerm(rank));
+    }
+
+    /**
+     * @brief Generate the next preanalyzed document.
+     *
+     */
+    void generateDoc(
+        lowletorfeats::base::StrSizeMap & docLenMap,
+        lowletorfeats::base::StructuredTermFrequencyMap & docTfMap)
+    {
+        for (auto const & section : this->options.sections)
+        {
+            std::size_t const sectionLen =
+                this->drawSectionLen(section.meanLen);
+            docLenMap[section.name] = sectionLen;
+
+            auto & sectionTfMap = docTfMap[section.name];
+            for (std::size_t i = 0; i < sectionLen; ++i)
+                ++sectionTfMap[this->drawTerm()];
+        }
+    }
+
+    /**
+     * @brief Generate the next document as raw text, one term per word.
+     *
+     */
+    lowletorfeats::base::StrStrMap generateDocText()
+    {
+        lowletorfeats::base::StrStrMap docTextMap;
+        for (auto const & section : this->options.sections)
+        {
+            std::size_t const sectionLen =
+                this->drawSectionLen(section.meanLen);
+
+            std::string & sectionText = docTextMap[section.name];
+            for (std::size_t i = 0; i < sectionLen; ++i)
+            {
+                if (i != 0) sectionText += ' ';
+                sectionText += this->drawTerm();
+            }
+        }
+
+        return docTextMap;
+    }
+
+    /**
+     * @brief Generate the next preanalyzed query.
+     *
+     */
+    lowletorfeats::base::StrSizeMap generateQuery()
+    {
+        lowletorfeats::base::StrSizeMap queryTfMap;
+
+        std::size_t const queryLen = this->drawQueryLen();
+        for (std::size_t i = 0; i < queryLen; ++i)
+            ++queryTfMap[this->drawTerm()];
+
+        return queryTfMap;
+    }
+
+    /**
+     * @brief Generate the next query as raw text.
+     *
+     */
+    std::string generateQueryText()
+    {
+        std::string queryText;
+
+        std::size_t const queryLen = this->drawQueryLen();
+        for (std::size_t i = 0; i < queryLen; ++i)
+        {
+            if (i != 0) queryText += ' ';
+            queryText += this->drawTerm();
+        }
+
+        return queryText;
+    }
+
+private:
+    CorpusOptions options;
+
+    std::mt19937 rng;
+
+    std::vector<double> termCdf;
+    std::vector<std::string> terms;  // By rank
+
+    /**
+     * @brief Draw uniformly from [0, 1). Not using the standard
+     *  distributions, whose output differs between standard libraries.
+     *
+     */
+    double drawUniform()
+    {
+        return (static_cast<double>(this->rng()) + 0.5) / 4294967296.0;
+    }
+
+    std::string const & drawTerm()
+    {
+        double const target = this->drawUniform() * this->termCdf.back();
+        auto const it = std::upper_bound(
+            this->termCdf.begin(), this->termCdf.end(), target);
+
+        return this->terms[std::min(
+            static_cast<std::size_t>(it - this->termCdf.begin()),
+            this->terms.size() - 1)];
+    }
+
+    std::size_t drawSectionLen(double const meanLen)
+    {
+        if (this->options.lengthSigma <= 0)
+            return std::max<std::size_t>(1, std::llround(meanLen));
+
+        // Box-Muller standard normal
+        double const normal =
+            std::sqrt(-2 * std::log(this->drawUniform())) *
+            std::cos(2 * M_PI * this->drawUniform());
+
+        // Log-normal with the given mean
+        double const sigma = this->options.lengthSigma;
+        double const len =
+            meanLen * std::exp(sigma * normal - sigma * sigma / 2);
+
+        return std::max<std::size_t>(1, std::llround(len));
+    }
+
+    std::size_t drawQueryLen()
+    {
+        std::size_t const nLens =
+            this->options.maxQueryLen - this->options.minQueryLen + 1;
+
+        return this->options.minQueryLen + this->rng() % nLens;
+    }
+
+    /**
+     * @brief Spell a term rank as a lowercase pseudo-word.
+     *
+     */
+    static std::string makeTerm(std::size_t rank)
+    {
+        std::string term = "w";
+        do
+        {
+            term += static_cast<char>('a' + rank % 26);
+            rank /= 26;
+        } while (rank != 0);
+
+        return term;
+    }
+};
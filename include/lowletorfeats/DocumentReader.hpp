@@ -0,0 +1,133 @@
+#pragma once
+
+#include <lowletorfeats/base/stdDef.hpp>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Streams query groups from a memory-mapped JSON Lines file of
+ *  documents, one object per line:
+ *
+ *  `{"qid": "1", "docid": "d1", "label": 1, "query": "text",
+ *   "sections": {"title": "text", "body": "text"}}`
+ *
+ *  Only "qid" is required, other members are ignored. The documents of a
+ *  query are consecutive lines, and the query text is taken from the first
+ *  of them that has one. Strings are viewed in the file unless they have
+ *  escapes. Pages behind the current group are released, so memory stays
+ *  bounded by the largest group rather than the file.
+ *
+ */
+class DocumentReader
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    /**
+     * @brief Documents of a query, valid until the next call of `next`.
+     *
+     */
+    struct QueryGroup
+    {
+        std::string_view qid;
+        std::string_view query;
+
+        std::vector<std::string_view> docIds;
+        std::vector<base::FValType> labels;
+        std::vector<base::StrViewPairVector> docs;  // See `addDocs`
+
+        std::size_t getNumDocs() const { return this->docs.size(); }
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Map the file at the given path.
+     *  Throws `std::runtime_error` if it cannot be mapped.
+     *
+     * @param path
+     */
+    explicit DocumentReader(std::string const & path);
+
+    DocumentReader(DocumentReader const & other) = delete;
+    DocumentReader & operator=(DocumentReader const & other) = delete;
+
+    ~DocumentReader();
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Read the next query group. Throws `std::runtime_error` on a
+     *  malformed line. A malformed line after the documents of a group
+     *  ends it, and is reported by the next call.
+     *
+     * @param group Cleared and filled, its buffers are reused.
+     * @return true If a group was read.
+     * @return false At the end of the file.
+     */
+    bool next(QueryGroup & group);
+
+    /* Getter methods */
+    /******************/
+
+    /**
+     * @brief Get the number of the last line read, from 1.
+     *
+     */
+    std::size_t getLineNum() const { return this->lineNum; }
+
+private:
+    /* Private type definitions */
+    /****************************/
+
+    // Members of a line besides its sections
+    struct LineFields
+    {
+        std::string_view qid;
+        std::string_view docId;
+        std::string_view query;
+        base::FValType label;
+    };
+
+    /* Private member variables */
+    /****************************/
+
+    char const * data = nullptr;
+    std::size_t size = 0;
+
+    std::size_t pos = 0;      // Start of the next line
+    std::size_t lineNum = 0;  // Number of the line at `pos - 1`
+
+    // Start of the pages not released yet
+    std::size_t releasedPos = 0;
+
+    // Unescaped strings of the current group, a deque keeps them in place
+    std::deque<std::string> unescapedStrs;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Parse a line into its fields and sections.
+     *  Throws `std::runtime_error` if it is malformed.
+     *
+     */
+    void parseLine(
+        std::string_view const line, LineFields & fields,
+        base::StrViewPairVector & sections);
+
+    /**
+     * @brief Release the mapped pages before `pos`.
+     *
+     */
+    void releasePages();
+};
+
+}  // namespace lowletorfeats
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <functional>
+#include <lowletorfeats/FeaturePlan.hpp>
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <lowletorfeats/LMIR.hpp>
+#include <lowletorfeats/base/FlatMap.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Exhaustive scoring of every indexed document containing at least
+ *  one query term.
+ *  Postings cursors over every query term of every section are traversed
+ *  document-at-a-time, and the features of a `FeaturePlan` are evaluated
+ *  straight from them against the statistics of the whole index. Each
+ *  feature row is streamed to a sink as soon as it is computed, so memory
+ *  does not grow with the number of matching documents.
+ *  Features match those of a `FeatureCollector` holding every indexed
+ *  document, up to the summation order of `bm25f` over the sections.
+ *
+ */
+class ExhaustiveScorer
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    /**
+     * @brief Receives the docId and the feature row of a matching document,
+     *  ordered as `getFeatureKeys`. The row is only valid during the call.
+     *
+     */
+    typedef std::function<void(
+        base::DocId const, std::vector<base::FValType> const &)>
+        RowSink;
+
+    /**
+     * @brief The matched query terms of the document under the cursors,
+     *  evaluated by `FeaturePlan` in place of a `StructuredDocument`.
+     *
+     */
+    class DocumentView
+    {
+    public:
+        typedef base::FlatMap<std::string_view, std::size_t>
+            TermFrequencyMap;
+
+        std::size_t getDocLen() const;
+        std::size_t getDocLen(std::string const & section) const;
+
+        /**
+         * @brief Get the highest term frequency of the "full" section.
+         *
+         */
+        std::size_t getMaxTF() const;
+
+        /**
+         * @brief Get the matched query terms of a section, empty if the
+         *  document does not have the section.
+         *
+         */
+        TermFrequencyMap const & getTermFrequencyMap(
+            std::string const & section) const;
+
+        std::vector<std::pair<std::string, TermFrequencyMap>> const &
+            getStructuredTermFrequencyMap() const;
+
+    private:
+        friend class ExhaustiveScorer;
+
+        InvertedIndex const * index = nullptr;
+        base::DocId docId = 0;
+
+        std::size_t fullDocLen = 0;
+        std::size_t maxTF = 0;
+
+        // Matched query terms of every indexed section, in query term order
+        std::vector<std::pair<std::string, TermFrequencyMap>> sectionTfMaps;
+        TermFrequencyMap emptyTfMap;
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct a scorer of the plan's features over an index.
+     *  The index must outlive the scorer.
+     *
+     * @param index
+     * @param plan
+     */
+    ExhaustiveScorer(InvertedIndex const & index, FeaturePlan const & plan);
+
+    /**
+     * @brief Construct a scorer of the given features over an index.
+     *  Throws `std::runtime_error` for an unsupported feature.
+     *
+     * @param index
+     * @param fKeyVect
+     */
+    ExhaustiveScorer(
+        InvertedIndex const & index,
+        std::vector<base::FeatureKey> const & fKeyVect);
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Stream the features of every document containing a query term
+     *  to the sink, in increasing docId.
+     *
+     * @param queryText Raw unanalyzed query string.
+     * @param sink
+     * @return std::size_t The number of documents streamed.
+     */
+    std::size_t score(
+        std::string const & queryText, RowSink const & sink) const;
+
+    /**
+     * @brief Stream the features of every document containing a term of a
+     *  preanalyzed query, see above.
+     *
+     */
+    std::size_t score(
+        base::StrSizeMap const & queryTfMap, RowSink const & sink) const;
+
+    /**
+     * @brief Stream the features of the given documents to the sink, in the
+     *  given order, against the statistics of the whole index. Documents
+     *  without a query term are streamed too.
+     *  Throws `std::runtime_error` for a docId out of the index.
+     *
+     * @param queryText Raw unanalyzed query string.
+     * @param docIds
+     * @param sink
+     * @return std::size_t The number of documents streamed.
+     */
+    std::size_t score(
+        std::string const & queryText, std::vector<base::DocId> const & docIds,
+        RowSink const & sink) const;
+
+    /**
+     * @brief Stream the features of the given documents for a preanalyzed
+     *  query, see above.
+     *
+     */
+    std::size_t score(
+        base::StrSizeMap const & queryTfMap,
+        std::vector<base::DocId> const & docIds, RowSink const & sink) const;
+
+    /* Setter methods */
+    /******************/
+
+    /**
+     * @brief Set the section weights used by `bm25f` and `bm25fplus`.
+     *
+     * @param sectionWeights
+     */
+    void setSectionWeights(
+        std::unordered_map<std::string, base::WeightType> const &
+            sectionWeights);
+
+    /**
+     * @brief Set the smoothing parameters of the LMIR features.
+     *
+     * @param lamb Jelinek-Mercer lambda.
+     * @param mu Dirichlet mu.
+     * @param delta Absolute discount delta.
+     */
+    void setLMIRParameters(
+        float const lamb, ushort const mu, float const delta);
+
+    /* Getter methods */
+    /******************/
+
+    std::vector<base::FeatureKey> const & getFeatureKeys() const;
+
+private:
+    /* Private type definitions */
+    /****************************/
+
+    struct Cursor
+    {
+        InvertedIndex::TermPostings const * termPostings;
+        std::size_t pos;
+        std::size_t sectionIdx;  // Into `DocumentView::sectionTfMaps`
+        std::string_view term;
+
+        base::DocId docId() const;
+    };
+
+    /**
+     * @brief Collection statistics of a query and the cursors over its
+     *  postings. The views point into it, so it is neither copied nor moved.
+     *
+     */
+    struct QueryState
+    {
+        base::FlatStrSizeMap queryFlatMap;
+
+        // As kept by `FeatureCollector` for query filtered documents
+        base::StructuredTermFrequencyMap nDocsWithTermPerSection;
+        base::StrFltMap avgDocLenPerSection;
+        base::StrSizeMap nTermsPerSection;
+        std::unordered_map<std::string, LMIR> lmirCalculators;
+        CollectionStatsView stats;
+
+        DocumentView doc;
+        std::size_t fullSectionIdx = 0;
+        std::vector<Cursor> cursors;
+
+        QueryState() = default;
+        QueryState(QueryState const &) = delete;
+        QueryState & operator=(QueryState const &) = delete;
+    };
+
+    /* Private member variables */
+    /****************************/
+
+    InvertedIndex const * index;
+    FeaturePlan plan;
+
+    // Defaults match `FeatureCollector`
+    std::unordered_map<std::string, base::WeightType> sectionWeights = {
+        {"full", 0.3},   {"title", 1},    {"body", 0.4},
+        {"author", 0.9}, {"anchor", 0.5}, {"url", 0.7}};
+
+    float lmirLamb = 0.1f;
+    ushort lmirMu = 2000;
+    float lmirDelta = 0.7f;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Gather the statistics of a query over the whole index and open
+     *  a cursor on the postings of every query term in every section.
+     *
+     */
+    void initQueryState(
+        base::StrSizeMap const & queryTfMap, QueryState & state) const;
+
+    /**
+     * @brief Set the document of `state.doc` once its matched query terms
+     *  are gathered, and stream its features to the sink.
+     *
+     */
+    void scoreDocument(
+        base::DocId const docId, QueryState & state,
+        FeaturePlan::Context & ctx, std::vector<base::FValType> & fValVect,
+        RowSink const & sink) const;
+};
+
+}  // namespace lowletorfeats
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <lowletorfeats/DocumentReader.hpp>
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/FeaturePlan.hpp>
+#include <lowletorfeats/Instrumentation.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Extracts the features of a stream of queries in four stages:
+ *  reading query groups, analysis (`setQuery` and `addDocs`), feature
+ *  collection and writing. The stages run concurrently on their own
+ *  threads, connected by bounded queues, so reading and writing overlap
+ *  with computation and throughput approaches the one of the slowest stage.
+ *  Queries are held in a fixed pool of tasks reused from the writer back to
+ *  the reader, which keeps memory flat and applies backpressure.
+ *
+ */
+class ExtractionPipeline
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    /**
+     * @brief A query and its documents as it goes through the stages.
+     *  Tasks are reused, so a reading function must assign every member it
+     *  uses.
+     *
+     */
+    struct QueryTask
+    {
+        std::size_t seqNum = 0;  // Position in the input, set by `run`
+
+        std::string qid;
+        std::string query;
+
+        std::vector<std::string> docIds;
+        std::vector<base::FValType> labels;
+        std::vector<base::StrViewPairVector> docs;  // Views into `docText`
+        std::string docText;
+
+        // Created for the analysis stage, released after writing
+        std::unique_ptr<FeatureCollector> fc;
+    };
+
+    // Fill the next task, false at the end of the input
+    typedef std::function<bool(QueryTask &)> ReadFunction;
+
+    // Add the query and documents of a task to its collector
+    typedef std::function<void(QueryTask &)> AnalyzeFunction;
+
+    // Write the features of a task
+    typedef std::function<void(QueryTask &)> WriteFunction;
+
+    enum class Stage
+    {
+        read,
+        analyze,
+        score,
+        write,
+        count  // Number of stages
+    };
+
+    struct Options
+    {
+        // Threads of each stage, reading is sequential. Tasks are written in
+        //  input order only with a single writing thread, otherwise the
+        //  writing function is called concurrently.
+        std::size_t analyzeThreads = 1;
+        std::size_t scoreThreads = 1;
+        std::size_t writeThreads = 1;
+
+        std::size_t queueCapacity = 4;  // Tasks waiting between two stages
+
+        // Traces the collector of every task, if not null
+        TraceRecorder * traceRecorder = nullptr;
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct a pipeline collecting the features of a plan, with a
+     *  thread per stage.
+     *
+     * @param plan
+     */
+    explicit ExtractionPipeline(FeaturePlan const & plan);
+
+    /**
+     * @brief Construct a pipeline collecting the features of a plan.
+     *
+     * @param plan
+     * @param options
+     */
+    ExtractionPipeline(FeaturePlan const & plan, Options const & options);
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Run every stage until the input is exhausted.
+     *  The first exception thrown by a stage stops the pipeline and is
+     *  rethrown.
+     *
+     * @param readFun Called from a single thread.
+     * @param writeFun
+     */
+    void run(ReadFunction const & readFun, WriteFunction const & writeFun);
+
+    /**
+     * @brief Per-stage timings and throughput of the last run as JSON.
+     *
+     */
+    std::string toJson() const;
+
+    /* Getter methods */
+    /******************/
+
+    /**
+     * @brief Get the busy time of a stage in the last run, summed over its
+     *  threads, with a call per query.
+     *
+     */
+    TimingStat const & getStageTiming(Stage const stage) const;
+
+    std::size_t getNumQueries() const { return this->numQueries; }
+    std::size_t getNumDocs() const { return this->numDocs; }
+
+    /**
+     * @brief Get the wall time of the last run in seconds.
+     *
+     */
+    double getSeconds() const { return this->seconds; }
+
+    static std::string const & getStageName(Stage const stage);
+
+    /* Setter methods */
+    /******************/
+
+    /**
+     * @brief Replace the analysis, `analyzeTexts` by default, to fill the
+     *  collectors from another source such as an `InvertedIndex`.
+     *
+     */
+    void setAnalyzeFunction(AnalyzeFunction const & analyzeFunction)
+    {
+        this->analyzeFun = analyzeFunction;
+    }
+
+    /* Static methods */
+    /******************/
+
+    /**
+     * @brief Read tasks from the query groups of a `DocumentReader`,
+     *  copying their texts into the task.
+     *
+     * @param reader Must outlive the returned function.
+     * @return ReadFunction
+     */
+    static ReadFunction readDocuments(DocumentReader & reader);
+
+    /**
+     * @brief Set the query text and add the document texts of a task.
+     *
+     */
+    static void analyzeTexts(QueryTask & task);
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    FeaturePlan plan;
+    Options options;
+    AnalyzeFunction analyzeFun = ExtractionPipeline::analyzeTexts;
+
+    // Statistics of the last run
+    std::array<TimingStat, static_cast<std::size_t>(Stage::count)>
+        stageTimings;
+    std::size_t numQueries = 0;
+    std::size_t numDocs = 0;
+    double seconds = 0;
+};
+
+}  // namespace lowletorfeats
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <functional>
+#include <limits>
+#include <lowletorfeats/FeatureMatrix.hpp>
+#include <lowletorfeats/FeaturePlan.hpp>
+#include <lowletorfeats/Instrumentation.hpp>
+#include <lowletorfeats/InvertedIndex.hpp>
 #include <lowletorfeats/LMIR.hpp>
 #include <lowletorfeats/base/Document.hpp>
 #include <textalyzer/Analyzer.hpp>
@@ -14,6 +20,35 @@ namespace lowletorfeats
 class FeatureCollector
 {
 public:
+    /* Public type definitions */
+    /***************************/
+
+    typedef uint8_t DependencyMask;
+
+    /**
+     * @brief Inputs a feature's value depends on. Changing an input
+     *  invalidates every collected feature that depends on it.
+     *
+     */
+    enum class Dependency : DependencyMask
+    {
+        none = 0,
+        sectionWeights = 1 << 0,
+        lmirParameters = 1 << 1,
+        query = 1 << 2,
+        documents = 1 << 3,
+        sectionStats = 1 << 4,
+        all = (1 << 5) - 1
+    };
+
+    /**
+     * @brief Scores a document for a feature cascade from its cheap features,
+     *  ordered as requested.
+     *
+     */
+    typedef std::function<base::FValType(std::vector<base::FValType> const &)>
+        CascadeScoreFunction;
+
     /* Constructors */
     /****************/
 
@@ -23,25 +58,40 @@ class FeatureCollector
      */
     FeatureCollector();
 
+    /**
+     * @brief Construct an empty Feature Collector allocating its per-query
+     *  state from the given memory resource.
+     *
+     * @param resource Memory resource backing the documents, statistics and
+     *  feature maps. Must outlive the collector.
+     */
+    explicit FeatureCollector(std::pmr::memory_resource * resource);
+
     /**
      * @brief Construct a new Feature Collector from raw full text documents.
      *
      * @param docTextMapVect Multiple structured documents of raw text.
      * @param queryText Raw unanalyzed query string.
+     * @param resource Memory resource backing the per-query state.
      */
     FeatureCollector(
         std::vector<base::StrStrMap> const & docTextMapVect,
-        std::string const & queryText);
+        std::string const & queryText,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
 
     /**
      * @brief Construct a new Feature Collector from raw full text documents.
      *
      * @param docTextMapVect Multiple structured documents of raw text.
      * @param queryTfMap Preanalyzed query string.
+     * @param resource Memory resource backing the per-query state.
      */
     FeatureCollector(
         std::vector<base::StrStrMap> const & docTextMapVect,
-        base::StrSizeMap const & queryTfMap);
+        base::StrSizeMap const & queryTfMap,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
 
     /**
      * @brief Construct a new Feature Collector from preanalyzed structured
@@ -52,11 +102,14 @@ class FeatureCollector
      * @param docTfMapVect Multiple structured documents with analyzed tokens
      * for each section.
      * @param queryText Raw unanalyzed query string.
+     * @param resource Memory resource backing the per-query state.
      */
     FeatureCollector(
         std::vector<base::StrSizeMap> const & docLenMapVect,
         std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect,
-        std::string const & queryText);
+        std::string const & queryText,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
 
     /**
      * @brief Construct a new Feature Collector from preanalyzed structured
@@ -67,11 +120,61 @@ class FeatureCollector
      * @param docTfMapVect Multiple structured documentds with analyzed tokens
      * for each section.
      * @param queryTfMap Preanalyzed query string.
+     * @param resource Memory resource backing the per-query state.
      */
     FeatureCollector(
         std::vector<base::StrSizeMap> const & docLenMapVect,
         std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect,
-        base::StrSizeMap const & queryTfMap);
+        base::StrSizeMap const & queryTfMap,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
+
+    /**
+     * @brief Copy constructor.
+     *  The copy allocates from the default memory resource so that it may
+     *  outlive the resource of `other`.
+     *
+     * @param other
+     */
+    FeatureCollector(FeatureCollector const & other);
+
+    /**
+     * @brief Copy constructor allocating from the given memory resource.
+     *
+     * @param other
+     * @param resource Memory resource backing the per-query state of the
+     *  copy.
+     */
+    FeatureCollector(
+        FeatureCollector const & other, std::pmr::memory_resource * resource);
+
+    /**
+     * @brief Move constructor. Keeps the memory resource of `other`.
+     *
+     * @param other
+     */
+    FeatureCollector(FeatureCollector && other) = default;
+
+    /* Assignment operators */
+    /************************/
+
+    /**
+     * @brief Copy the state of `other` into this collector's memory resource.
+     *  Memory resources do not propagate on assignment: a collector keeps
+     *  allocating from the resource it was constructed with.
+     *
+     * @param other
+     */
+    FeatureCollector & operator=(FeatureCollector const & other);
+
+    /**
+     * @brief Take the state of `other` if both collectors share a memory
+     *  resource, otherwise copy it into this collector's resource, see
+     *  above.
+     *
+     * @param other
+     */
+    FeatureCollector & operator=(FeatureCollector && other);
 
     /* Public class methods */
     /************************/
@@ -86,6 +189,7 @@ class FeatureCollector
 
     /**
      * @brief Get a string of per-document features.
+     *  Computes any pending lazy features.
      *
      */
     std::string getFeatureString() const;
@@ -99,13 +203,27 @@ class FeatureCollector
 
     /**
      * @brief Recollect the existing feature set.
-     *  Recollect the features for the existing keys in the `featureMapVect`.
-     *  Will delete the existing values of `featureMapVect`.
+     *  Only the features invalidated since they were last computed are
+     *  recomputed, see `invalidateFeatures`. With lazy evaluation enabled
+     *  they are left pending instead.
      */
     void reCollectFeatures();
 
     /**
-     * @brief Collect the named feature for every document
+     * @brief Mark every collected feature depending on any of the given
+     *  inputs as needing recomputation.
+     *  Called by the setters, call it directly with `Dependency::all` to
+     *  force `reCollectFeatures` to recompute everything.
+     *
+     * @param dependencies Bitwise or of `Dependency` values.
+     */
+    void invalidateFeatures(DependencyMask const dependencies);
+    void invalidateFeatures(Dependency const dependency);
+
+    /**
+     * @brief Collect the named feature for every document.
+     *  With lazy evaluation enabled the feature is only requested, and is
+     *  computed on first access.
      *
      * @param fName The feature to collect.
      */
@@ -118,26 +236,315 @@ class FeatureCollector
      */
     void collectFeatures(std::vector<base::FeatureKey> const & fKeyVect);
 
+    /**
+     * @brief Collect the features of a compiled plan.
+     *  Compiling once and collecting the same plan for every query avoids
+     *  re-planning the feature set.
+     *
+     * @param plan
+     */
+    void collectFeatures(FeaturePlan const & plan);
+
+    /**
+     * @brief Collect features in two stages. The cheap features are computed
+     *  for every document and scored, then the expensive features are only
+     *  computed for the `topN` best scoring documents scoring at least
+     *  `minScore`. The expensive features of the other documents are 0 and
+     *  these documents are marked as pruned, see `isPruned`.
+     *  Documents added later are not pruned.
+     *
+     * @param cheapKeys Features computed for every document.
+     * @param expensiveKeys Features computed for the surviving documents.
+     * @param scoreFunction Scores a document from its cheap features.
+     * @param topN Maximum number of surviving documents.
+     * @param minScore Minimum score of a surviving document.
+     * @return std::vector<std::size_t> The surviving documents, by decreasing
+     *  score.
+     */
+    std::vector<std::size_t> collectCascadeFeatures(
+        std::vector<base::FeatureKey> const & cheapKeys,
+        std::vector<base::FeatureKey> const & expensiveKeys,
+        CascadeScoreFunction const & scoreFunction, std::size_t const topN,
+        base::FValType const minScore =
+            std::numeric_limits<base::FValType>::lowest());
+
+    /**
+     * @brief Append raw full text documents to the collection.
+     *  The collection statistics are updated incrementally. Features of the
+     *  existing documents are recomputed only if they use collection
+     *  statistics, the appended documents get every collected feature.
+     *
+     * @param docTextMapVect Multiple structured documents of raw text.
+     */
+    void addDocs(std::vector<base::StrStrMap> const & docTextMapVect);
+
+    /**
+     * @brief Append raw full text documents viewed in a caller's buffer, such
+     *  as the query groups of a `DocumentReader`, see above.
+     *
+     * @param docTextVect Multiple documents of section keys and raw texts.
+     */
+    void addDocs(std::vector<base::StrViewPairVector> const & docTextVect);
+
+    /**
+     * @brief Append preanalyzed structured documents to the collection.
+     *  The collection statistics are updated incrementally. Features of the
+     *  existing documents are recomputed only if they use collection
+     *  statistics, the appended documents get every collected feature.
+     *
+     * @param docLenMapVect Multiple structured documents with their length for
+     *  each section.
+     * @param docTfMapVect Multiple structured documents with analyzed tokens
+     * for each section.
+     */
+    void addDocs(
+        std::vector<base::StrSizeMap> const & docLenMapVect,
+        std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect);
+
+    /**
+     * @brief Append indexed documents to the collection, such as the results
+     *  of a `TopKRetriever`, see above.
+     *
+     * @param index
+     * @param docIdVect The documents to append, in order.
+     */
+    void addDocs(
+        InvertedIndex const & index,
+        std::vector<base::DocId> const & docIdVect);
+
     /* Getter methods */
     /******************/
 
     std::size_t getNumDocs() const;
     std::size_t getNumFeatures() const;
 
+    /**
+     * @brief Get the requested feature keys, in the order they were first
+     *  collected. Includes features that are pending lazy evaluation.
+     *
+     * @return std::vector<base::FeatureKey> const&
+     */
+    std::vector<base::FeatureKey> const & getFeatureKeys() const;
+
     std::vector<StructuredDocument> const & getDocVect() const;
 
+    /**
+     * @brief Get the feature vector of every document.
+     *  Computes any pending lazy features.
+     *
+     * @return std::vector<std::vector<base::FValType>> const
+     */
     std::vector<std::vector<base::FValType>> const getFeatureVects() const;
 
+    /**
+     * @brief Get the features with the same value for every document of the
+     *  query. These are stored once here instead of in the feature map of
+     *  every document. Computes any pending lazy features.
+     *
+     * @return base::FeatureMap const&
+     */
+    base::FeatureMap const & getConstantFeatureMap() const;
+
+    /**
+     * @brief Get the value of a feature for a document.
+     *  The feature column is computed on first access if it is pending or
+     *  was never collected.
+     *
+     * @param docIdx
+     * @param fKey
+     * @return base::FValType
+     */
+    base::FValType getFeatureValue(
+        std::size_t const docIdx, base::FeatureKey const & fKey);
+
+    /**
+     * @brief Get the feature vector of a document, ordered as
+     *  `getFeatureKeys`. Computes any pending lazy features.
+     *
+     * @param docIdx
+     * @return std::vector<base::FValType>
+     */
+    std::vector<base::FValType> getFeatureVector(
+        std::size_t const docIdx) const;
+
+    /**
+     * @brief Copy the feature vector of a document to `out`, ordered as
+     *  `getFeatureKeys`, without allocating. Computes any pending lazy
+     *  features.
+     *
+     * @param docIdx
+     * @param out Room for `getNumFeatures` values.
+     */
+    void copyFeatureVector(
+        std::size_t const docIdx, base::FValType * out) const;
+
+    /**
+     * @brief Get the values of a feature for every document.
+     *  Only this feature's column is computed if it is pending.
+     *
+     * @param fKey
+     * @return std::vector<base::FValType>
+     */
+    std::vector<base::FValType> getFeatureColumn(
+        base::FeatureKey const & fKey);
+
+    /**
+     * @brief Get a documents by features matrix view over the collector.
+     *
+     * @return FeatureMatrix
+     */
+    FeatureMatrix getFeatureMatrix();
+
+    /**
+     * @brief Whether the feature has the same value for every document of a
+     *  query, and is stored in `getConstantFeatureMap`.
+     *
+     * @param fKey
+     */
+    static bool isConstantFeature(base::FeatureKey const & fKey);
+
+    /**
+     * @brief Whether the expensive features of a document were skipped by the
+     *  last `collectCascadeFeatures`. Documents are no longer pruned once
+     *  every expensive feature is computed for every document again, e.g.
+     *  after an invalidation, or the features are cleared by
+     *  `collectPresetFeatures`.
+     *
+     * @param docIdx
+     */
+    bool isPruned(std::size_t const docIdx) const;
+
+    /**
+     * @brief Get the pruned flag of every document, see `isPruned`.
+     *
+     * @return std::vector<bool> const&
+     */
+    std::vector<bool> const & getPrunedDocs() const;
+
+    /**
+     * @brief Get the wall time and call counts recorded per pipeline stage
+     *  and per feature since construction or the last `resetStats`.
+     *  Empty unless the library was built with `ENABLE_INSTRUMENTATION`.
+     *
+     * @return PipelineStats const&
+     */
+    PipelineStats const & getStats() const { return this->pipelineStats; }
+
+    /**
+     * @brief Estimate the memory held by the collector, per section: the
+     *  term frequency maps and retained term vectors of the documents, the
+     *  collection statistics, the feature values, the LMIR models and the
+     *  term strings they own. Walks every map, without allocating per
+     *  entry.
+     *
+     * @return MemoryStats
+     */
+    MemoryStats getMemoryStats() const;
+
+    bool isLazyEvaluation() const { return this->lazyEvaluation; }
+    bool isRetainTermVectors() const { return this->retainTermVectors; }
+
     /* Setter methods */
     /******************/
 
+    /**
+     * @brief Replace the query, re-deriving the filtered documents and the
+     *  collection statistics from the retained term vectors instead of the
+     *  raw text. Requires `setRetainTermVectors(true)` before any document
+     *  was added, unless the collector is empty.
+     *  Features depending on the query are recomputed, or left pending with
+     *  lazy evaluation.
+     *
+     * @param queryText Raw unanalyzed query string.
+     */
+    void setQuery(std::string const & queryText);
+
+    /**
+     * @brief Replace the query with a preanalyzed one, see above.
+     *
+     * @param queryTfMap Preanalyzed query string.
+     */
+    void setQuery(base::StrSizeMap const & queryTfMap);
+
+    /**
+     * @brief Clear the recorded pipeline statistics, see `getStats`.
+     *
+     */
+    void resetStats();
+
+    /**
+     * @brief Record the spans of the collector's pipeline stages to a trace,
+     *  tagged with the given query id. Features are then computed one
+     *  family at a time, each family in its own span. The recorder must
+     *  outlive the collector or the next `setTrace`; null stops tracing.
+     *
+     * @param traceRecorder
+     * @param qid
+     */
+    void setTrace(
+        TraceRecorder * const traceRecorder, std::string const & qid);
+
+    /**
+     * @brief Retain the interned term vector of every document section
+     *  added from now on, so that `setQuery` can re-filter them.
+     *  Must be set before adding documents. Disabling it frees the retained
+     *  term vectors.
+     *
+     * @param retainTermVectors
+     */
+    void setRetainTermVectors(bool const retainTermVectors);
+
+    /**
+     * @brief Set the section weights used by `bm25f` and `bm25fplus`.
+     *  Invalidates only those features.
+     *
+     * @param sectionWeights
+     */
     void setSectionWeights(
         std::unordered_map<std::string, base::WeightType> const &
-            sectionWeights)
+            sectionWeights);
+
+    /**
+     * @brief Set the smoothing parameters of the LMIR features.
+     *  Invalidates only the LMIR features.
+     *
+     * @param lamb Jelinek-Mercer lambda.
+     * @param mu Dirichlet mu.
+     * @param delta Absolute discount delta.
+     */
+    void setLMIRParameters(
+        float const lamb, ushort const mu, float const delta);
+
+    /**
+     * @brief Enable or disable lazy evaluation.
+     *  When enabled, collected features are computed a whole column at a time
+     *  on first access, then memoized. Disabling it does not compute the
+     *  pending features.
+     *
+     * @param lazyEvaluation
+     */
+    void setLazyEvaluation(bool const lazyEvaluation)
     {
-        this->sectionWeights = sectionWeights;
+        this->lazyEvaluation = lazyEvaluation;
     }
 
+    /* Static getter methods */
+    /*************************/
+
+    /**
+     * @brief Get the inputs the given feature depends on.
+     *
+     * @param fKey
+     * @return DependencyMask Bitwise or of `Dependency` values.
+     */
+    static DependencyMask getDependencies(base::FeatureKey const & fKey);
+
+    /**
+     * @brief Get the feature set of `collectPresetFeatures`.
+     *
+     */
+    static std::vector<base::FeatureKey> const & getPresetFeatureKeys();
+
     /* Static setter methods */
     /*************************/
 
@@ -151,12 +558,18 @@ class FeatureCollector
     /* Private member variables */
     /****************************/
 
+    // Backs the per-query documents, statistics and feature maps
+    std::pmr::memory_resource * resource;
+
     std::unordered_map<std::string, base::WeightType> sectionWeights = {
         {"full", 0.3},   {"title", 1},    {"body", 0.4},
         {"author", 0.9}, {"anchor", 0.5}, {"url", 0.7}};
 
     // `TermFrequencyMap` for the query string
-    base::StrSizeMap queryTfMap;
+    base::FlatStrSizeMap queryTfMap;
+
+    // Scratch counts per query term, indexed by position in `queryTfMap`
+    std::vector<std::size_t> queryTermCounts;
 
     // Number of documents in the collection
     std::size_t numDocs;
@@ -164,8 +577,12 @@ class FeatureCollector
     // Set of the section keys
     std::unordered_set<std::string> sectionKeys;
 
-    // Vector of term frequencies of structured documents
-    std::vector<StructuredDocument> docVect;
+    // Vector of term frequencies of structured documents. Mutable because
+    //  their feature maps memoize the features computed on const access.
+    mutable std::vector<StructuredDocument> docVect;
+
+    // Total document length per section
+    base::StrSizeMap docLenSumPerSection;
 
     // Average document length per section
     base::StrFltMap avgDocLenPerSection;
@@ -179,8 +596,54 @@ class FeatureCollector
     // Total number of terms per section
     base::StrSizeMap nTermsPerSection;
 
-    // For calculating LMIR features
-    std::unordered_map<std::string, LMIR> lmirCalculators;
+    // For calculating LMIR features, constructed on first use
+    mutable std::unordered_map<std::string, LMIR> lmirCalculators;
+
+    // LMIR smoothing parameters, defaults match `LMIR`
+    float lmirLamb = 0.1f;
+    ushort lmirMu = 2000;
+    float lmirDelta = 0.7f;
+
+    // Requested features in the order they were first collected
+    std::vector<base::FeatureKey> featureKeys;
+
+    // Requested features that have not been computed yet, or whose inputs
+    //  changed since they were computed, mapped to the first document
+    //  needing the computation
+    mutable std::unordered_map<base::FeatureKey, std::size_t> pendingFeatures;
+
+    // Requested features with the same value for every document
+    mutable base::FeatureMap constantFeatureMap;
+
+    // Documents whose expensive features the last cascade skipped, and these
+    //  features while they still hold 0 for the pruned documents
+    mutable std::vector<bool> prunedDocs;
+    mutable std::vector<base::FeatureKey> prunedKeys;
+
+    // Whether to defer computing features until first access
+    bool lazyEvaluation = false;
+
+    // Whether to retain the interned term vectors of every document
+    bool retainTermVectors = false;
+
+    // Interned id of every term seen while retaining term vectors
+    std::unordered_map<std::string, base::TermId> termIds;
+
+    // Interned term vectors of every document section, for `setQuery`
+    std::vector<base::StructuredTermCountVector> docTermVects;
+
+    // Scratch term ids used while interning a token stream
+    std::vector<base::TermId> termIdScratch;
+
+    // Scratch copy of a viewed text for the analyzer
+    std::string textScratch;
+
+    // Timings of the pipeline stages and features, see `getStats`
+    mutable PipelineStats pipelineStats;
+
+    // Trace receiving the spans of the pipeline stages, see `setTrace`
+    TraceRecorder * traceRecorder = nullptr;
+    std::string traceQid;
 
     /* Private static member variables */
 
@@ -191,15 +654,51 @@ class FeatureCollector
     /* Private class methods */
     /*************************/
 
+    /**
+     * @brief Assign every member from another collector, keeping
+     *  `resource`. Documents are copied into `resource`, or moved if
+     *  `other` is an rvalue sharing it.
+     *
+     * @tparam Other `FeatureCollector const &` or `FeatureCollector`.
+     */
+    template <class Other>
+    void assignState(Other && other);
+
+    /**
+     * @brief Start a span of the attached trace, a no-op without one.
+     *
+     */
+    TraceSpan traceSpan(
+        std::string_view const name, std::string_view const category) const;
+
+    /**
+     * @brief Analyze a query or section text with `analyzerFun`.
+     *
+     * @return std::pair<std::vector<std::string>, std::size_t> The tokens
+     *  and the length of the text.
+     */
+    std::pair<std::vector<std::string>, std::size_t> analyzeText(
+        std::string const & text);
+    std::pair<std::vector<std::string>, std::size_t> analyzeText(
+        std::string_view const text);
+
+    /**
+     * @brief Append raw text documents, see `addDocs`.
+     *
+     * @tparam DocText `base::StrStrMap` or `base::StrViewPairVector`.
+     */
+    template <class DocText>
+    void addTextDocs(std::vector<DocText> const & docTextVect);
+
     /**
      * @brief Construct the lmirCalculator if it is not already constructed.
      *
      */
-    void constructLMIR(std::string const & sectionKey);
+    void constructLMIR(std::string const & sectionKey) const;
 
     /**
      * @brief Add the given document to the docVect.
-     *  TODO: Add protections so this can only be called from initDocs.
+     *  TODO: Add protections so this can only be called from addDocs.
      *
      * @param newDoc
      */
@@ -213,25 +712,83 @@ class FeatureCollector
      */
     void addDoc(
         base::StrSizeMap const & docLenMap,
-        base::StructuredTermFrequencyMap const & strucDocTfMap);
+        base::StructuredFlatTermFrequencyMap const & strucDocTfMap);
 
     /**
-     * @brief Initialize unanalyzed structured documents.
-     *  TODO: Add protection so it can only be called from a constructor
+     * @brief Update the collection statistics after appending documents and
+     *  invalidate the features they affect.
      *
-     * @param docTextMapVect
+     * @param firstNewDocIdx Index of the first appended document.
      */
-    void initDocs(std::vector<base::StrStrMap> const & docTextMapVect);
+    void updateCollectionStats(std::size_t const firstNewDocIdx);
 
     /**
-     * @brief Initialize preanalyzed structured documents.
+     * @brief Count the occurrences of each query term in a token stream into
+     *  `queryTermCounts`. Each token is binary searched in the sorted query
+     *  terms, so no map of the full document vocabulary is built.
      *
-     * @param docLenMapVect
-     * @param docTfMapVect
+     * @param tokenVect
      */
-    void initDocs(
-        std::vector<base::StrSizeMap> const & docLenMapVect,
-        std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect);
+    void countQueryTerms(std::vector<std::string> const & tokenVect);
+
+    /**
+     * @brief Count the occurrences of each query term in a preanalyzed
+     *  section into `queryTermCounts` by probing the section once per query
+     *  term.
+     *
+     * @param sectionTfMap
+     */
+    void countQueryTerms(base::StrSizeMap const & sectionTfMap);
+
+    /**
+     * @brief Intern a token stream into a sorted term count vector.
+     *
+     * @param tokenVect
+     * @param termVect Output, must be empty.
+     */
+    void retainTerms(
+        std::vector<std::string> const & tokenVect,
+        base::TermCountVector & termVect);
+
+    /**
+     * @brief Intern a preanalyzed section into a sorted term count vector.
+     *
+     * @param sectionTfMap
+     * @param termVect Output, must be empty.
+     */
+    void retainTerms(
+        base::StrSizeMap const & sectionTfMap,
+        base::TermCountVector & termVect);
+
+    /**
+     * @brief Get the id of a term, interning it if it is new.
+     *
+     * @param term
+     * @return base::TermId
+     */
+    base::TermId internTerm(std::string const & term);
+
+    /**
+     * @brief Re-filter every document against the current `queryTfMap` from
+     *  the retained term vectors and rebuild the query dependent statistics.
+     *
+     */
+    void refilterDocs();
+
+    /**
+     * @brief Throw if documents were added without retaining their term
+     *  vectors.
+     *
+     */
+    void assertRetainedTermVectors() const;
+
+    /**
+     * @brief Move the nonzero `queryTermCounts` into the given map and reset
+     *  the counts.
+     *
+     * @param sectionTfMap
+     */
+    void flushQueryTermCounts(base::FlatStrSizeMap & sectionTfMap);
 
     /**
      * @brief Initialize the `nDocsWithTermPerSection` and `tfMapPerSection`
@@ -240,7 +797,8 @@ class FeatureCollector
      * @param sectionTfMap
      */
     void initNDocsWithTermPerSection(
-        std::string const & sectionKey, base::StrSizeMap const & sectionTfMap);
+        std::string const & sectionKey,
+        base::FlatStrSizeMap const & sectionTfMap);
 
     /**
      * @brief Calculate the total number of terms per section in the
@@ -256,32 +814,70 @@ class FeatureCollector
     void initFullFromOthers();
 
     /**
-     * @brief Clear the feature maps of every document.
+     * @brief Compute the named feature for every document from
+     *  `firstDocIdx` on.
      *
+     * @param fKey
+     * @param firstDocIdx
      */
-    void clearFeatureMaps();
+    void computeFeature(
+        base::FeatureKey const & fKey, std::size_t const firstDocIdx) const;
 
     /**
-     * @brief Assert required properties of the feature collector to ensure
-     *  acceptable operations.
+     * @brief Add the features of the plan to `featureKeys` as computed, i.e.
+     *  not pending lazy evaluation.
      *
+     * @param plan
      */
-    void assertProperties();
+    void requestFeatures(FeaturePlan const & plan);
+
+    /**
+     * @brief Compute every feature of the plan for every document from
+     *  `firstDocIdx` on.
+     *
+     * @param plan
+     * @param firstDocIdx
+     */
+    void computeFeatures(
+        FeaturePlan const & plan, std::size_t const firstDocIdx) const;
+
+    /**
+     * @brief Compute every feature of the plan for the given documents.
+     *
+     * @param plan
+     * @param docIdxVect
+     */
+    void computeFeatures(
+        FeaturePlan const & plan,
+        std::vector<std::size_t> const & docIdxVect) const;
+
+    /**
+     * @brief Compute every feature pending lazy evaluation, in request order.
+     *
+     */
+    void computePendingFeatures() const;
 
-    /* Private static class methods */
-    /********************************/
+    /**
+     * @brief Clear the feature maps of every document and the constant
+     *  features. No document is pruned anymore.
+     *
+     */
+    void clearFeatureMaps();
 
     /**
-     * @brief Throw an error for an unsupported feature type.
+     * @brief Get a computed feature value of a document, from the constant
+     *  features or the document's feature map.
      *
      */
-    void static throwUnsupportedFeatureType(std::string const & fType);
+    base::FValType const & getStoredFeatureValue(
+        StructuredDocument const & doc, base::FeatureKey const & fKey) const;
 
     /**
-     * @brief Throw an error for an unsupported feature name.
+     * @brief Assert required properties of the feature collector to ensure
+     *  acceptable operations.
      *
      */
-    void static throwUnsupportedFeatureName(std::string const & fName);
+    void assertProperties();
 };
 
 }  // namespace lowletorfeats
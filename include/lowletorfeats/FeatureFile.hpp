@@ -0,0 +1,325 @@
+#pragma once
+
+#include <lowletorfeats/FeatureMatrix.hpp>
+#include <lowletorfeats/base/FeatureKey.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <cstdint>  // uint32_t, uint64_t
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Binary columnar feature file, in the byte order of the host.
+ *
+ *  - `Header`
+ *  - Schema: string table of the feature keys
+ *  - Queries: `numQueries + 1` document offsets of the query groups, then a
+ *   string table of the query ids
+ *  - Document ids: string table
+ *  - Labels: a column
+ *  - Features: `numFeatures` columns
+ *
+ *  A string table is `n + 1` character offsets followed by the characters.
+ *  A column is the `numDocs` values of a feature. Every section starts at a
+ *  multiple of 8 bytes.
+ *
+ */
+namespace featurefile
+{
+enum class ValueType : std::uint32_t
+{
+    float32 = 4,
+    float64 = 8
+};
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t byteOrder;  // `BYTE_ORDER_MARK` as written by the host
+    std::uint32_t version;
+    ValueType valueType;
+    std::uint32_t reserved;
+
+    std::uint64_t numFeatures;
+    std::uint64_t numDocs;
+    std::uint64_t numQueries;
+
+    // Byte offsets of the sections from the start of the file
+    std::uint64_t schemaOffset;
+    std::uint64_t queryOffset;
+    std::uint64_t docIdOffset;
+    std::uint64_t labelOffset;
+    std::uint64_t columnOffset;
+};
+
+extern char const MAGIC[8];
+std::uint32_t const BYTE_ORDER_MARK = 0x01020304;
+std::uint32_t const VERSION = 1;
+
+}  // namespace featurefile
+
+/**
+ * @brief Writes feature vectors to a binary columnar feature file.
+ *  Rows are spooled to an unlinked file next to the output and transposed
+ *  into columns block by block on `close`, so memory does not grow with the
+ *  number of documents beyond their ids and labels.
+ *
+ */
+class FeatureFileWriter
+{
+public:
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Create or truncate the file at the given path.
+     *  Throws `std::runtime_error` if it cannot be opened.
+     *
+     * @param path
+     * @param fKeys Schema every written row follows.
+     * @param valueType Stored width of the values.
+     */
+    FeatureFileWriter(
+        std::string const & path, std::vector<base::FeatureKey> const & fKeys,
+        featurefile::ValueType const valueType =
+            featurefile::ValueType::float64);
+
+    FeatureFileWriter(FeatureFileWriter const & other) = delete;
+    FeatureFileWriter & operator=(FeatureFileWriter const & other) = delete;
+
+    /**
+     * @brief Close the file if not closed yet. Errors are ignored here, call
+     *  `close` to have them thrown.
+     *
+     */
+    ~FeatureFileWriter();
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Write every document of a query as a new query group.
+     *  Throws `std::runtime_error` if the features differ from the schema.
+     *
+     * @param fMatrix Computes any pending features.
+     * @param qid
+     * @param labels Relevance label of every document, 0 if empty.
+     * @param docIds Id of every document, empty if empty.
+     */
+    void writeQuery(
+        FeatureMatrix & fMatrix, std::string_view const qid,
+        std::vector<base::FValType> const & labels = {},
+        std::vector<std::string> const & docIds = {});
+
+    /**
+     * @brief Write a single document. Starts a new query group unless the
+     *  query id is the one of the previous document.
+     *
+     * @param label
+     * @param qid
+     * @param fValues `getNumFeatures` feature values.
+     * @param docId
+     */
+    void writeRow(
+        base::FValType const label, std::string_view const qid,
+        base::FValType const * fValues, std::string_view const docId = {});
+
+    /**
+     * @brief Write the header, ids and columns and close the file.
+     *  Throws `std::runtime_error` on a write error.
+     *
+     */
+    void close();
+
+    /* Getter methods */
+    /******************/
+
+    std::size_t getNumDocs() const;
+    std::size_t getNumFeatures() const;
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    std::string path;
+    int fd = -1;
+    int spoolFd = -1;  // Unlinked once opened
+
+    std::vector<base::FeatureKey> fKeys;
+    featurefile::ValueType valueType;
+
+    std::vector<std::uint64_t> queryOffsets;
+    std::vector<std::string> qids;
+    std::vector<std::string> docIds;
+    std::vector<base::FValType> labels;
+
+    // Row-major values waiting to be spooled
+    std::vector<char> rowBuffer;
+
+    // Scratch row of `writeQuery`
+    std::vector<base::FValType> rowScratch;
+
+    /* Private static member variables */
+    /***********************************/
+
+    static std::size_t const BUFFER_SIZE;
+
+    /* Private class methods */
+    /*************************/
+
+    void startQuery(std::string_view const qid);
+
+    void appendRow(
+        base::FValType const label, base::FValType const * fValues,
+        std::string_view const docId);
+
+    void flushRows();
+
+    /**
+     * @brief Write the header and the sections up to the columns.
+     *
+     */
+    void writeSections(featurefile::Header & header);
+
+    /**
+     * @brief Transpose the spooled rows into the columns.
+     *
+     */
+    void writeColumns(std::uint64_t const columnOffset);
+};
+
+/**
+ * @brief Memory-maps a binary columnar feature file. Columns are read in
+ *  place, without parsing, and sliced by query group.
+ *
+ */
+class FeatureFileReader
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    /**
+     * @brief Contiguous documents of a query.
+     *
+     */
+    struct QueryGroup
+    {
+        std::string_view qid;
+        std::size_t firstDoc;  // Index of the first document of the group
+        std::size_t numDocs;
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Map the file at the given path. Throws `std::runtime_error` if
+     *  it cannot be mapped or is not a valid feature file.
+     *
+     * @param path
+     */
+    explicit FeatureFileReader(std::string const & path);
+
+    FeatureFileReader(FeatureFileReader const & other) = delete;
+    FeatureFileReader & operator=(FeatureFileReader const & other) = delete;
+
+    ~FeatureFileReader();
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Get the value of a single cell, converted to `base::FValType`.
+     *
+     * @param docIdx
+     * @param featureIdx
+     * @return base::FValType
+     */
+    base::FValType at(
+        std::size_t const docIdx, std::size_t const featureIdx) const;
+
+    /**
+     * @brief Get the values of a feature for every document, in place.
+     *  Throws `std::runtime_error` if `T` is not the stored value type.
+     *  Offset by `QueryGroup::firstDoc` to slice a query group.
+     *
+     * @tparam T `float` or `double`.
+     * @param featureIdx
+     * @return T const*
+     */
+    template <typename T>
+    T const * getColumnData(std::size_t const featureIdx) const;
+
+    /**
+     * @brief Get the labels of every document, in place.
+     *
+     * @tparam T `float` or `double`.
+     * @return T const*
+     */
+    template <typename T>
+    T const * getLabelData() const;
+
+    /* Getter methods */
+    /******************/
+
+    std::size_t getNumDocs() const;
+    std::size_t getNumFeatures() const;
+    std::size_t getNumQueries() const;
+
+    featurefile::ValueType getValueType() const;
+
+    std::vector<base::FeatureKey> const & getFeatureKeys() const;
+
+    QueryGroup getQueryGroup(std::size_t const queryIdx) const;
+
+    std::string_view getDocId(std::size_t const docIdx) const;
+
+    base::FValType getLabel(std::size_t const docIdx) const;
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    char const * data = nullptr;
+    std::size_t size = 0;
+
+    featurefile::Header header;
+    std::vector<base::FeatureKey> fKeys;
+
+    std::uint64_t const * queryOffsets = nullptr;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Throw `std::runtime_error` unless `nBytes` from the aligned
+     *  `offset` lie in the file.
+     *
+     */
+    void checkRange(
+        std::uint64_t const offset, std::uint64_t const nBytes) const;
+
+    /**
+     * @brief Throw `std::runtime_error` unless a string table of `n` strings
+     *  lies in the file.
+     *
+     */
+    void checkStringTable(
+        std::uint64_t const offset, std::size_t const n) const;
+
+    std::string_view getString(
+        std::uint64_t const tableOffset, std::size_t const n,
+        std::size_t const idx) const;
+
+    base::FValType getValue(
+        std::uint64_t const offset, std::size_t const valueIdx) const;
+
+    template <typename T>
+    T const * getValueData(
+        std::uint64_t const offset, std::size_t const valueIdx) const;
+};
+
+}  // namespace lowletorfeats
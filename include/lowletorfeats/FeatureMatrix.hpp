@@ -0,0 +1,85 @@
+#pragma once
+
+#include <lowletorfeats/base/FeatureKey.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <vector>
+
+namespace lowletorfeats
+{
+class FeatureCollector;
+
+/**
+ * @brief Non-owning documents by features view over a `FeatureCollector`.
+ *  Columns are ordered as `FeatureCollector::getFeatureKeys`. Reading a cell
+ *  computes its feature column if it is pending lazy evaluation.
+ *  The collector must outlive the view.
+ *
+ */
+class FeatureMatrix
+{
+public:
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct a view over the given collector.
+     *
+     * @param fc
+     */
+    explicit FeatureMatrix(FeatureCollector & fc);
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Get the value of a single cell.
+     *
+     * @param docIdx Row index.
+     * @param featureIdx Column index.
+     * @return base::FValType
+     */
+    base::FValType at(std::size_t const docIdx, std::size_t const featureIdx);
+
+    /**
+     * @brief Get the feature vector of a document.
+     *  Computes every pending column.
+     *
+     * @param docIdx
+     * @return std::vector<base::FValType>
+     */
+    std::vector<base::FValType> getRow(std::size_t const docIdx);
+
+    /**
+     * @brief Copy the feature vector of a document to `out` without
+     *  allocating. Computes every pending column.
+     *
+     * @param docIdx
+     * @param out Room for `getNumFeatures` values.
+     */
+    void copyRow(std::size_t const docIdx, base::FValType * out);
+
+    /**
+     * @brief Get the values of a feature for every document.
+     *  Computes only this column.
+     *
+     * @param featureIdx
+     * @return std::vector<base::FValType>
+     */
+    std::vector<base::FValType> getColumn(std::size_t const featureIdx);
+
+    /* Getter methods */
+    /******************/
+
+    std::size_t getNumDocs() const;
+    std::size_t getNumFeatures() const;
+
+    std::vector<base::FeatureKey> const & getFeatureKeys() const;
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    FeatureCollector * fc;
+};
+
+}  // namespace lowletorfeats
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <lowletorfeats/Instrumentation.hpp>
+#include <lowletorfeats/LMIR.hpp>
+#include <lowletorfeats/base/FeatureKey.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Non-owning view of the query and collection statistics a
+ *  `FeaturePlan` is evaluated against. Every pointer must outlive the
+ *  `FeaturePlan::Context` bound to it.
+ *
+ */
+struct CollectionStatsView
+{
+    std::size_t numDocs = 0;
+
+    base::FlatStrSizeMap const * queryTfMap = nullptr;
+
+    base::StructuredTermFrequencyMap const * nDocsWithTermPerSection = nullptr;
+    base::StrFltMap const * avgDocLenPerSection = nullptr;
+    base::StrSizeMap const * nTermsPerSection = nullptr;
+
+    std::unordered_map<std::string, base::WeightType> const * sectionWeights =
+        nullptr;
+
+    // Must hold a model for every section of `FeaturePlan::getLMIRSections`
+    std::unordered_map<std::string, LMIR> const * lmirCalculators = nullptr;
+};
+
+/**
+ * @brief Execution plan for a list of `FeatureKey`s.
+ *  Features are grouped by section so that the intermediates they share are
+ *  computed once: the section statistics, the idf and term probability
+ *  tables of the query terms and the LMIR model per query, and the term
+ *  frequency map, its intersection with the query and its sum per document.
+ *  A plan does not depend on the query or the documents, so it can be
+ *  compiled once and reused for every query with the same feature set.
+ *
+ */
+class FeaturePlan
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    /**
+     * @brief Per-query state of a plan bound to a `CollectionStatsView`.
+     *  Also holds the scratch buffers used while evaluating documents, so it
+     *  must not be shared between threads.
+     *
+     */
+    class Context
+    {
+    public:
+        Context() {}
+
+        // The section contexts are referenced by pointer
+        Context(Context const & other) = delete;
+        Context(Context && other) = default;
+        Context & operator=(Context const & other) = delete;
+        Context & operator=(Context && other) = default;
+
+    private:
+        friend class FeaturePlan;
+
+        struct SectionContext
+        {
+            float avgDocLen = 0;
+            std::size_t totalTerms = 0;
+
+            // Idf of every query term, in `queryTfMap` order
+            std::vector<base::FValType> idfTable;
+
+            // LMIR model and corpus probability of every query term
+            LMIR const * lime = nullptr;
+            std::vector<double> termProbTable;
+        };
+
+        CollectionStatsView stats;
+
+        // Contexts of every section present in the collection and needed by
+        //  the plan
+        std::unordered_map<std::string, SectionContext> sectionContexts;
+
+        // Context of each section step, null if the section does not exist
+        std::vector<SectionContext const *> stepContexts;
+
+        // Context and weight of every weighted section, for `bm25f`
+        std::unordered_map<
+            std::string, std::pair<SectionContext const *, base::WeightType>>
+            weightedContexts;
+
+        // Whether the section of each structured feature exists
+        std::vector<bool> structuredSectionExists;
+
+        // Values of the features that are constant for the query
+        std::vector<base::FValType> constantValues;
+
+        // `bm25f` idf over every term of the "full" section
+        base::FValType fullIdf = 0;
+
+        // Scratch indices of the query terms matched in a document section
+        std::vector<std::size_t> queryIdxVect;
+        std::vector<std::size_t> docIdxVect;
+
+        // Evaluation time of every feature, only recorded when built with
+        //  `ENABLE_INSTRUMENTATION`
+        std::vector<TimingStat> featureTimings;
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct an empty plan.
+     *
+     */
+    FeaturePlan();
+
+    /**
+     * @brief Compile a plan for the given features.
+     *  Duplicate keys are computed once. Throws `std::runtime_error` for an
+     *  unsupported feature type or name.
+     *
+     * @param fKeyVect
+     */
+    explicit FeaturePlan(std::vector<base::FeatureKey> const & fKeyVect);
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Compute the per-query intermediates of the plan.
+     *
+     * @param stats
+     * @return Context
+     */
+    Context bind(CollectionStatsView const & stats) const;
+
+    /**
+     * @brief Evaluate every feature of the plan for a single document.
+     *  Instantiated for `StructuredDocument` and
+     *  `ExhaustiveScorer::DocumentView`.
+     *
+     * @tparam Doc
+     * @param ctx Context bound to the collection of the document.
+     * @param doc
+     * @param outRow Receives the values, ordered as `getFeatureKeys`.
+     */
+    template <class Doc>
+    void evaluate(
+        Context & ctx, Doc const & doc, base::FValType * outRow) const;
+
+    /**
+     * @brief Whether the feature at the given index has the same value for
+     *  every document of a query.
+     *
+     * @param featureIdx
+     */
+    bool isConstant(std::size_t const featureIdx) const;
+
+    /**
+     * @brief Get the value of a constant feature for the bound query.
+     *
+     * @param ctx
+     * @param featureIdx
+     * @return base::FValType
+     */
+    base::FValType getConstantValue(
+        Context const & ctx, std::size_t const featureIdx) const;
+
+    /**
+     * @brief Add the feature evaluation times recorded in a context to
+     *  `stats`. Nothing is recorded unless built with
+     *  `ENABLE_INSTRUMENTATION`.
+     *
+     * @param ctx
+     * @param stats
+     */
+    void addTimings(Context const & ctx, PipelineStats & stats) const;
+
+    /* Getter methods */
+    /******************/
+
+    std::size_t size() const;
+    bool empty() const;
+
+    std::vector<base::FeatureKey> const & getFeatureKeys() const;
+
+    /**
+     * @brief Get the sections whose LMIR model the plan uses.
+     *
+     * @return std::vector<std::string> const&
+     */
+    std::vector<std::string> const & getLMIRSections() const;
+
+private:
+    /* Private type definitions */
+    /****************************/
+
+    struct SectionStep
+    {
+        std::string section;
+
+        // Indices into `featureKeys`
+        std::vector<std::size_t> featureIdxs;
+
+        bool needsQueryMatches = false;
+        bool needsTfSum = false;
+        bool needsLMIR = false;
+    };
+
+    /* Private member variables */
+    /****************************/
+
+    std::vector<base::FeatureKey> featureKeys;
+
+    std::vector<SectionStep> sectionSteps;
+
+    // Indices into `featureKeys` of the features over every section
+    std::vector<std::size_t> structuredFeatureIdxs;
+
+    // Whether each feature is constant for a query
+    std::vector<bool> constantFeatures;
+
+    std::vector<std::string> lmirSections;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Intersect a sorted section term frequency map with the query
+     *  terms into the scratch indices of `ctx`, in query term order.
+     *
+     * @return std::size_t The number of matched query terms.
+     */
+    template <class TfMap>
+    std::size_t matchQueryTerms(Context & ctx, TfMap const & tfMap) const;
+
+    /**
+     * @brief Calculate the BM25 of a section from its matched query terms.
+     *
+     */
+    template <class TfMap>
+    base::FValType sectionBm25(
+        Context::SectionContext const & sectionCtx, TfMap const & tfMap,
+        Context const & ctx, std::size_t const nMatches) const;
+
+    /**
+     * @brief Calculate the BM25+ of a section from its matched query terms.
+     *
+     */
+    template <class TfMap>
+    base::FValType sectionBm25plus(
+        Context::SectionContext const & sectionCtx, TfMap const & tfMap,
+        Context const & ctx, std::size_t const nMatches) const;
+
+    /* Private static class methods */
+    /********************************/
+
+    /**
+     * @brief Throw an error for an unsupported feature type.
+     *
+     */
+    [[noreturn]] static void throwUnsupportedFeatureType(
+        std::string const & fType);
+
+    /**
+     * @brief Throw an error for an unsupported feature name.
+     *
+     */
+    [[noreturn]] static void throwUnsupportedFeatureName(
+        std::string const & fName);
+};
+
+}  // namespace lowletorfeats
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <lowletorfeats/ExhaustiveScorer.hpp>
+#include <lowletorfeats/FeaturePlan.hpp>
+#include <lowletorfeats/Instrumentation.hpp>
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <lowletorfeats/base/BoundedQueue.hpp>
+#include <lowletorfeats/base/FeatureKey.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <cstdint>  // uint8_t, uint32_t
+#include <memory>   // unique_ptr
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Binary protocol of the feature server, in the byte order of the
+ *  host since both ends share a machine.
+ *
+ *  A message is a `uint32` payload size followed by the payload. A string is
+ *  a `uint32` size followed by its characters.
+ *
+ *  Requests start with a `RequestType`:
+ *  - `schema`: nothing else
+ *  - `docIds`: the query string, a `uint32` number of documents, then the
+ *   id of every indexed document as a string. Features are computed
+ *   against the statistics of the whole index.
+ *  - `docTexts`: the query string, a `uint32` number of documents, then for
+ *   every document a `uint32` number of sections and the key and text
+ *   strings of every section
+ *
+ *  Responses start with a `Status`, followed by an error string, or:
+ *  - `schema`: a `uint32` number of features, then every key as a string
+ *  - Others: a `uint32` number of documents, a `uint32` number of features,
+ *   then the `double` feature values row by row
+ *
+ */
+namespace featureserver
+{
+enum class RequestType : std::uint8_t
+{
+    schema = 1,
+    docIds = 2,
+    docTexts = 3
+};
+
+enum class Status : std::uint8_t
+{
+    ok = 0,
+    error = 1
+};
+
+// Larger messages are rejected and close the connection
+std::uint32_t const MAX_MESSAGE_SIZE = 1u << 30;
+
+}  // namespace featureserver
+
+/**
+ * @brief Serves feature requests over a Unix domain socket.
+ *  The plan, the analyzers and the index are loaded once and shared by a
+ *  pool of workers, so a request only pays for its own documents. Each
+ *  worker serves a connection at a time, further connections wait for a
+ *  free worker.
+ *
+ */
+class FeatureServer
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    struct Options
+    {
+        std::size_t numWorkers = 4;  // Connections served concurrently
+        std::size_t backlog = 64;    // Accepted connections waiting
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct a server collecting the features of a plan, with
+     *  default options.
+     *
+     * @param plan
+     */
+    explicit FeatureServer(FeaturePlan const & plan);
+
+    /**
+     * @brief Construct a server collecting the features of a plan.
+     *
+     * @param plan
+     * @param options
+     */
+    FeatureServer(FeaturePlan const & plan, Options const & options);
+
+    FeatureServer(FeatureServer const & other) = delete;
+    FeatureServer & operator=(FeatureServer const & other) = delete;
+
+    /**
+     * @brief Close the socket and remove its path.
+     *
+     */
+    ~FeatureServer();
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Bind the socket at the given path, replacing a stale socket.
+     *  Throws `std::runtime_error` on failure.
+     *
+     * @param socketPath
+     */
+    void listen(std::string const & socketPath);
+
+    /**
+     * @brief Serve connections until `stop` is called.
+     *
+     */
+    void run();
+
+    /**
+     * @brief Stop accepting connections and close the open ones, making
+     *  `run` return. Safe to call from another thread, not from a signal
+     *  handler.
+     *
+     */
+    void stop();
+
+    /* Getter methods */
+    /******************/
+
+    /**
+     * @brief Get the time spent handling requests, summed over the workers.
+     *
+     */
+    TimingStat getRequestTiming() const;
+
+    /* Setter methods */
+    /******************/
+
+    /**
+     * @brief Serve `docIds` requests from an index, which must outlive the
+     *  server. Features are computed against the statistics of the whole
+     *  index, as by `ExhaustiveScorer`.
+     *
+     * @param index
+     * @param docIds Id of every document of the index, by `DocId`.
+     */
+    void setIndex(
+        InvertedIndex const & index, std::vector<std::string> const & docIds);
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    FeaturePlan plan;
+    Options options;
+
+    std::unique_ptr<ExhaustiveScorer> scorer;  // Set with the index
+    std::unordered_map<std::string, base::DocId> docIdMap;
+
+    std::string socketPath;
+    int listenFd = -1;
+    int stopFds[2] = {-1, -1};  // Pipe waking the accepting thread
+
+    // Connections accepted and being served, closed by `stop`
+    mutable std::mutex connMutex;
+    base::BoundedQueue<int> * connQueue = nullptr;  // Set during `run`
+    std::unordered_set<int> activeFds;
+    bool stopping = false;
+
+    TimingStat requestTiming;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Answer the requests of a connection until it is closed.
+     *
+     */
+    void serveConnection(int const fd);
+
+    /**
+     * @brief Answer a request, throws `std::runtime_error` if it is invalid.
+     *
+     */
+    void handleRequest(
+        std::string_view const request, std::string & response);
+};
+
+/**
+ * @brief Connection to a `FeatureServer`. A client is not shared between
+ *  threads, open a connection per thread instead.
+ *
+ */
+class FeatureClient
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    /**
+     * @brief Feature values of the documents of a request, ordered as
+     *  `getFeatureKeys`.
+     *
+     */
+    struct FeatureRows
+    {
+        std::size_t numDocs = 0;
+        std::size_t numFeatures = 0;
+        std::vector<base::FValType> values;  // Row by row
+
+        base::FValType const * getRow(std::size_t const docIdx) const
+        {
+            return this->values.data() + docIdx * this->numFeatures;
+        }
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Connect to the server at the given socket path.
+     *  Throws `std::runtime_error` if it cannot connect.
+     *
+     * @param socketPath
+     */
+    explicit FeatureClient(std::string const & socketPath);
+
+    FeatureClient(FeatureClient const & other) = delete;
+    FeatureClient & operator=(FeatureClient const & other) = delete;
+
+    ~FeatureClient();
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Get the feature keys computed by the server.
+     *
+     */
+    std::vector<base::FeatureKey> getFeatureKeys();
+
+    /**
+     * @brief Get the features of indexed documents for a query.
+     *  Throws `std::runtime_error` with the message of the server if the
+     *  request fails.
+     *
+     * @param queryText
+     * @param docIds Ids given to `FeatureServer::setIndex`.
+     * @param rows Reused from request to request.
+     */
+    void getFeatures(
+        std::string_view const queryText,
+        std::vector<std::string_view> const & docIds, FeatureRows & rows);
+
+    /**
+     * @brief Get the features of document texts for a query.
+     *
+     * @param queryText
+     * @param docTextVect Sections of every document, see
+     *  `FeatureCollector::addDocs`.
+     * @param rows Reused from request to request.
+     */
+    void getFeatures(
+        std::string_view const queryText,
+        std::vector<base::StrViewPairVector> const & docTextVect,
+        FeatureRows & rows);
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    int fd = -1;
+
+    // Buffers reused from request to request
+    std::string request;
+    std::string response;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Send `request` and receive `response`, past its status.
+     *  Throws `std::runtime_error` if the server reports an error.
+     *
+     * @return std::string_view The rest of the response.
+     */
+    std::string_view exchange();
+
+    void readRows(std::string_view const payload, FeatureRows & rows);
+};
+
+}  // namespace lowletorfeats
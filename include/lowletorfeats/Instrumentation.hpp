@@ -0,0 +1,481 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <lowletorfeats/base/FeatureKey.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Timing instrumentation is compiled in only when the library is configured
+//  with `ENABLE_INSTRUMENTATION`, which defines
+//  `LOWLETORFEATS_INSTRUMENTATION`. Otherwise `LOWLETORFEATS_TIME_SCOPE`
+//  expands to a no-op and its argument is never evaluated.
+#ifdef LOWLETORFEATS_INSTRUMENTATION
+#define LOWLETORFEATS_CONCAT_IMPL(a, b) a##b
+#define LOWLETORFEATS_CONCAT(a, b) LOWLETORFEATS_CONCAT_IMPL(a, b)
+#define LOWLETORFEATS_TIME_SCOPE(timingStat)       \
+    ::lowletorfeats::ScopedTimer LOWLETORFEATS_CONCAT( \
+        lowletorfeatsScopedTimer, __LINE__)(timingStat)
+#else
+#define LOWLETORFEATS_TIME_SCOPE(timingStat) static_cast<void>(0)
+#endif
+
+namespace lowletorfeats
+{
+/**
+ * @brief Number of calls to an instrumented scope and their total wall time.
+ *
+ */
+struct TimingStat
+{
+    std::uint64_t calls = 0;
+    std::uint64_t nanoseconds = 0;
+
+    void add(std::uint64_t const elapsedNanoseconds)
+    {
+        ++this->calls;
+        this->nanoseconds += elapsedNanoseconds;
+    }
+
+    void merge(TimingStat const & other)
+    {
+        this->calls += other.calls;
+        this->nanoseconds += other.nanoseconds;
+    }
+};
+
+/**
+ * @brief Adds the wall time of its lifetime to a `TimingStat`.
+ *
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(TimingStat & timingStat)
+        : timingStat(timingStat), start(Clock::now())
+    {
+    }
+
+    ScopedTimer(ScopedTimer const & other) = delete;
+    ScopedTimer & operator=(ScopedTimer const & other) = delete;
+
+    ~ScopedTimer()
+    {
+        this->timingStat.add(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - this->start)
+                .count()));
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    TimingStat & timingStat;
+    Clock::time_point const start;
+};
+
+/**
+ * @brief Wall time and call counts of the feature collection pipeline, per
+ *  stage and per `FeatureKey`. Empty unless the library was built with
+ *  `ENABLE_INSTRUMENTATION`.
+ *
+ */
+class PipelineStats
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    /**
+     * @brief Instrumented stages. Stages nest, so their times do not add up:
+     *  `addDocs` includes the `analyzeText` and `collectionStats` of its
+     *  documents, and their `computeFeatures` unless evaluation is lazy.
+     *  `computeFeatures` includes `constructLMIR` and `bindPlan`.
+     *
+     */
+    enum class Stage : std::size_t
+    {
+        analyzeText,      // Each `analyzerFun` call, for queries and sections
+        addDocs,          // Filtering and adding documents to the collector
+        collectionStats,  // Updating the collection statistics
+        constructLMIR,    // Constructing the LMIR model of a section
+        bindPlan,         // Computing the per-query intermediates of a plan
+        computeFeatures,  // Computing and storing features over documents
+        count
+    };
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Get the timing of a stage, for recording.
+     *
+     * @param stage
+     * @return TimingStat&
+     */
+    TimingStat & stage(Stage const stage);
+
+    /**
+     * @brief Get the timing of a feature, for recording. Counts one call per
+     *  document the feature was evaluated for. Constant features are
+     *  computed while binding the plan and are not recorded.
+     *
+     * @param fKey
+     * @return TimingStat&
+     */
+    TimingStat & feature(base::FeatureKey const & fKey);
+
+    /**
+     * @brief Add the timings of another `PipelineStats`, for example of
+     *  collectors running in other threads.
+     *
+     * @param other
+     */
+    void merge(PipelineStats const & other);
+
+    void clear();
+
+    /**
+     * @brief Format as a single line JSON object with a `stages` and a
+     *  `features` object, mapping names to their `calls` and `ns`.
+     *
+     * @return std::string
+     */
+    std::string toJson() const;
+
+    /* Getter methods */
+    /******************/
+
+    TimingStat const & getStage(Stage const stage) const;
+
+    std::unordered_map<base::FeatureKey, TimingStat> const &
+        getFeatureTimings() const;
+
+    /* Static methods */
+    /******************/
+
+    static std::string const & getStageName(Stage const stage);
+
+    /**
+     * @brief Whether the library records timings.
+     *
+     */
+    static constexpr bool isEnabled()
+    {
+#ifdef LOWLETORFEATS_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    std::array<TimingStat, static_cast<std::size_t>(Stage::count)>
+        stageTimings{};
+
+    std::unordered_map<base::FeatureKey, TimingStat> featureTimings;
+};
+
+/**
+ * @brief Estimated heap bytes held by a part of the collection, per kind of
+ *  data. The container payloads are estimated from their sizes and
+ *  capacities, ignoring allocator overhead and unused arena space.
+ *
+ */
+struct MemoryUsage
+{
+    std::size_t termMaps = 0;     // Term frequency maps and term vectors
+    std::size_t statsMaps = 0;    // Document and collection statistics
+    std::size_t featureMaps = 0;  // Feature values
+    std::size_t lmirModels = 0;   // LMIR term probabilities
+    std::size_t termStrings = 0;  // Heap allocated term strings of the above
+
+    std::size_t total() const
+    {
+        return this->termMaps + this->statsMaps + this->featureMaps +
+               this->lmirModels + this->termStrings;
+    }
+
+    void merge(MemoryUsage const & other)
+    {
+        this->termMaps += other.termMaps;
+        this->statsMaps += other.statsMaps;
+        this->featureMaps += other.featureMaps;
+        this->lmirModels += other.lmirModels;
+        this->termStrings += other.termStrings;
+    }
+};
+
+/**
+ * @brief Memory held by a collector, per section. What is not specific to a
+ *  section, such as the query, the feature key lists and the interned
+ *  term ids, is reported as unsectioned.
+ *
+ */
+class MemoryStats
+{
+public:
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Get the usage of a section, for recording.
+     *
+     * @param sectionKey
+     * @return MemoryUsage&
+     */
+    MemoryUsage & section(std::string const & sectionKey);
+
+    /**
+     * @brief Get the usage not specific to a section, for recording.
+     *
+     * @return MemoryUsage&
+     */
+    MemoryUsage & unsectioned();
+
+    /**
+     * @brief Add the usage of another `MemoryStats`, for example of the
+     *  collectors of other workers.
+     *
+     * @param other
+     */
+    void merge(MemoryStats const & other);
+
+    /**
+     * @brief Format as a single line JSON object with a `sections`, an
+     *  `unsectioned` and a `total` usage, each mapping the kinds of data and
+     *  `total` to their bytes.
+     *
+     * @return std::string
+     */
+    std::string toJson() const;
+
+    /* Getter methods */
+    /******************/
+
+    std::map<std::string, MemoryUsage> const & getSections() const;
+    MemoryUsage const & getUnsectioned() const;
+
+    /**
+     * @brief Get the usage summed over every section and the unsectioned
+     *  usage.
+     *
+     * @return MemoryUsage
+     */
+    MemoryUsage getTotal() const;
+
+    /* Static methods */
+    /******************/
+
+    /**
+     * @brief Estimate the heap bytes of a string, 0 if it fits in the
+     *  small string buffer.
+     *
+     */
+    static std::size_t stringBytes(std::string const & str)
+    {
+        static std::size_t const SSO_CAPACITY = std::string().capacity();
+
+        return (str.capacity() > SSO_CAPACITY) ? str.capacity() + 1 : 0;
+    }
+
+    /**
+     * @brief Estimate the heap bytes of the nodes and buckets of an
+     *  `unordered_map`, excluding the memory owned by its keys and values.
+     *  Nodes are assumed to hold a next pointer, the value and its hash.
+     *
+     */
+    template <class Container>
+    static std::size_t hashMapBytes(Container const & x)
+    {
+        return x.bucket_count() * sizeof(void *) +
+               x.size() * (sizeof(void *) +
+                           sizeof(typename Container::value_type) +
+                           sizeof(std::size_t));
+    }
+
+    /**
+     * @brief Estimate the heap bytes of a `FlatMap`, excluding the memory
+     *  owned by its keys and values.
+     *
+     */
+    template <class Key, class T>
+    static std::size_t flatMapBytes(base::FlatMap<Key, T> const & x)
+    {
+        return x.capacity() *
+               sizeof(typename base::FlatMap<Key, T>::value_type);
+    }
+
+    /**
+     * @brief Estimate the heap bytes of a `FeatureMap`: its values and an
+     *  index and truncated hash per bucket.
+     *
+     */
+    static std::size_t featureMapBytes(base::FeatureMap const & x)
+    {
+        return x.size() * sizeof(base::FeatureMap::value_type) +
+               x.bucket_count() * 2 * sizeof(std::uint32_t);
+    }
+
+    /**
+     * @brief Sum the `stringBytes` of the keys of a map.
+     *
+     */
+    template <class Container>
+    static std::size_t keyStringBytes(Container const & x)
+    {
+        std::size_t nBytes = 0;
+        for (auto const & mapPair : x)
+            nBytes += MemoryStats::stringBytes(mapPair.first);
+
+        return nBytes;
+    }
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    std::map<std::string, MemoryUsage> sectionUsages;
+    MemoryUsage unsectionedUsage;
+};
+
+/**
+ * @brief Writes spans to a file in the JSON trace event format, which trace
+ *  viewers such as Perfetto and `chrome://tracing` open. Every span is
+ *  tagged with a query id and the index of the thread recording it.
+ *  Spans may be added from several threads.
+ *
+ */
+class TraceRecorder
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Start a trace written to the given path. Span times are
+     *  relative to the construction. Throws `std::runtime_error` if the file
+     *  cannot be opened.
+     *
+     * @param path
+     */
+    explicit TraceRecorder(std::string const & path);
+
+    TraceRecorder(TraceRecorder const & other) = delete;
+    TraceRecorder & operator=(TraceRecorder const & other) = delete;
+
+    /**
+     * @brief Finish the trace, see `close`.
+     *
+     */
+    ~TraceRecorder();
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Add a complete span of the calling thread.
+     *
+     * @param name
+     * @param category Group of the span, such as "analysis" or "features".
+     * @param start
+     * @param end
+     * @param qid Query id the span worked on, may be empty.
+     */
+    void addSpan(
+        std::string_view const name, std::string_view const category,
+        Clock::time_point const start, Clock::time_point const end,
+        std::string_view const qid);
+
+    /**
+     * @brief Terminate the trace and close the file. Later spans are
+     *  ignored.
+     *
+     */
+    void close();
+
+    /* Static methods */
+    /******************/
+
+    /**
+     * @brief Get the index of the calling thread, in the order threads first
+     *  asked for it.
+     *
+     * @return std::uint32_t
+     */
+    static std::uint32_t getThreadId();
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    std::mutex mutex;
+    std::ofstream outStream;
+
+    Clock::time_point const origin;
+    bool hasSpans = false;
+
+    /* Private static methods */
+    /**************************/
+
+    /**
+     * @brief Quote a string as a JSON value.
+     *
+     */
+    static std::string quoteJson(std::string_view const str);
+};
+
+/**
+ * @brief Adds a span covering its lifetime to a `TraceRecorder`, unless the
+ *  recorder is null. The name, category and query id are referenced until
+ *  the span ends.
+ *
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(
+        TraceRecorder * const traceRecorder, std::string_view const name,
+        std::string_view const category, std::string_view const qid)
+        : traceRecorder(traceRecorder),
+          name(name),
+          category(category),
+          qid(qid)
+    {
+        if (traceRecorder != nullptr)
+            this->start = TraceRecorder::Clock::now();
+    }
+
+    TraceSpan(TraceSpan const & other) = delete;
+    TraceSpan & operator=(TraceSpan const & other) = delete;
+
+    ~TraceSpan()
+    {
+        if (this->traceRecorder != nullptr)
+            this->traceRecorder->addSpan(
+                this->name, this->category, this->start,
+                TraceRecorder::Clock::now(), this->qid);
+    }
+
+private:
+    TraceRecorder * const traceRecorder;
+
+    std::string_view const name;
+    std::string_view const category;
+    std::string_view const qid;
+
+    TraceRecorder::Clock::time_point start;
+};
+
+}  // namespace lowletorfeats
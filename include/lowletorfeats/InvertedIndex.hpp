@@ -0,0 +1,254 @@
+#pragma once
+
+#include <lowletorfeats/base/stdDef.hpp>
+#include <textalyzer/Analyzer.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Inverted index over a collection of structured documents.
+ *  Holds per-section postings lists for first-stage retrieval and the term
+ *  counts of every document, so that retrieved documents can be handed to a
+ *  `FeatureCollector` without keeping a second copy of the corpus.
+ *  Documents are identified by the order they were added in. Documents
+ *  without a "full" section are also indexed under one merged from their
+ *  other sections, as done by `StructuredDocument`.
+ *
+ */
+class InvertedIndex
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    struct Posting
+    {
+        base::DocId docId;
+        std::uint32_t tf;
+    };
+
+    typedef std::vector<Posting> PostingsList;  // Sorted by docId
+
+    /**
+     * @brief Metadata of a block of `BLOCK_SIZE` consecutive postings, used
+     *  to bound the score of every document within the block. The BM25
+     *  term scores do not depend on the document length, so the highest tf
+     *  of the block is enough to bound them.
+     *
+     */
+    struct PostingsBlock
+    {
+        base::DocId lastDocId;
+        std::uint32_t maxTf;
+    };
+
+    /**
+     * @brief Postings list of a term within a section, with the statistics
+     *  used to bound its score contribution.
+     *
+     */
+    struct TermPostings
+    {
+        PostingsList postings;
+        std::uint32_t maxTf = 0;  // Highest term frequency of the list
+        std::size_t tfSum = 0;    // Collection frequency of the term
+
+        // Block `i` covers the postings from `i * BLOCK_SIZE` on
+        std::vector<PostingsBlock> blocks;
+    };
+
+    /* Public static member variables */
+    /**********************************/
+
+    static constexpr std::size_t BLOCK_SIZE = 64;
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct an empty index.
+     *
+     */
+    InvertedIndex();
+
+    /**
+     * @brief Construct an index over raw full text documents.
+     *
+     * @param docTextMapVect Multiple structured documents of raw text.
+     */
+    explicit InvertedIndex(
+        std::vector<base::StrStrMap> const & docTextMapVect);
+
+    /**
+     * @brief Construct an index over preanalyzed documents.
+     *
+     * @param docLenMapVect The length of each document section.
+     * @param docTfMapVect The term frequencies of each document section.
+     */
+    InvertedIndex(
+        std::vector<base::StrSizeMap> const & docLenMapVect,
+        std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect);
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Append raw full text documents to the index.
+     *
+     * @param docTextMapVect Multiple structured documents of raw text.
+     */
+    void addDocs(std::vector<base::StrStrMap> const & docTextMapVect);
+
+    /**
+     * @brief Append preanalyzed documents to the index.
+     *
+     * @param docLenMapVect The length of each document section.
+     * @param docTfMapVect The term frequencies of each document section.
+     */
+    void addDocs(
+        std::vector<base::StrSizeMap> const & docLenMapVect,
+        std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect);
+
+    /**
+     * @brief Reconstruct the section lengths and term frequencies of an
+     *  indexed document, as accepted by `FeatureCollector::addDocs`.
+     *
+     * @param docId
+     * @param docLenMap Receives the length of each section.
+     * @param docTfMap Receives the term frequencies of each section.
+     */
+    void getDocument(
+        base::DocId const docId, base::StrSizeMap & docLenMap,
+        base::StructuredTermFrequencyMap & docTfMap) const;
+
+    /**
+     * @brief Analyze a raw query into its term frequency map, as done for
+     *  indexed text.
+     *
+     * @param queryText
+     * @return base::StrSizeMap
+     */
+    static base::StrSizeMap analyzeQuery(std::string const & queryText);
+
+    /* Getter methods */
+    /******************/
+
+    std::size_t getNumDocs() const;
+
+    /**
+     * @brief Get the number of distinct terms over every section.
+     *
+     */
+    std::size_t getNumTerms() const;
+
+    bool hasSection(std::string const & sectionKey) const;
+
+    /**
+     * @brief Get the key of every indexed section, sorted.
+     *
+     */
+    std::vector<std::string> getSectionKeys() const;
+
+    /**
+     * @brief Get the average length of a section over every document.
+     *  Throws `std::out_of_range` for an unknown section.
+     *
+     * @param sectionKey
+     * @return float
+     */
+    float getAvgDocLen(std::string const & sectionKey) const;
+
+    /**
+     * @brief Get the length of a document section, 0 if the document does
+     *  not have the section.
+     *
+     */
+    std::size_t getDocLen(
+        base::DocId const docId, std::string const & sectionKey) const;
+
+    /**
+     * @brief Find the id of an indexed term.
+     *
+     * @param term
+     * @param termId Receives the id if found.
+     * @return Whether the term is indexed.
+     */
+    bool findTermId(std::string const & term, base::TermId & termId) const;
+
+    std::string const & getTerm(base::TermId const termId) const;
+
+    /**
+     * @brief Get the postings of a term within a section.
+     *
+     * @return TermPostings const* Null if the term is not in the section.
+     */
+    TermPostings const * findPostings(
+        std::string const & sectionKey, base::TermId const termId) const;
+
+    /* Static setter methods */
+    /*************************/
+
+    static void setAnalyzerFunction(
+        textalyzer::AnlyzerFunType<std::string> const & analyzerFunction)
+    {
+        InvertedIndex::analyzerFun = analyzerFunction;
+    }
+
+private:
+    /* Private type definitions */
+    /****************************/
+
+    struct Section
+    {
+        std::unordered_map<base::TermId, TermPostings> postingsMap;
+        std::size_t docLenSum = 0;
+    };
+
+    /* Private member variables */
+    /****************************/
+
+    std::unordered_map<std::string, Section> sections;
+
+    // Interned id of every indexed term, and the term of every id
+    std::unordered_map<std::string, base::TermId> termIds;
+    std::vector<std::string> terms;
+
+    // Section lengths and term counts of every document, by docId
+    std::vector<base::StrSizeMap> docLenMaps;
+    std::vector<base::StructuredTermCountVector> docTermVects;
+
+    /* Private static member variables */
+
+    // Analyzer method for a string of text into pair<tokenStrVect, docLen>.
+    textalyzer::AnlyzerFunType<std::string> static analyzerFun;
+    uint8_t static const DEFAULT_NGRAMS;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Index a single document under the next docId.
+     *
+     */
+    void addDoc(
+        base::StrSizeMap const & docLenMap,
+        base::StructuredTermFrequencyMap const & docTfMap);
+
+    /**
+     * @brief Get the id of a term, interning it if new.
+     *
+     */
+    base::TermId internTerm(std::string const & term);
+
+    /**
+     * @brief Append the postings of a document section.
+     *
+     */
+    void addSection(
+        base::DocId const docId, std::string const & sectionKey,
+        base::StrSizeMap const & sectionTfMap);
+};
+
+}  // namespace lowletorfeats
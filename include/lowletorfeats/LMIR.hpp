@@ -7,6 +7,8 @@ namespace lowletorfeats
 {
 /**
  * @brief Class for calculate LMIR scores.
+ *  The scoring methods are instantiated for `base::StrSizeMap` and
+ *  `base::FlatStrSizeMap` term frequency maps.
  *
  */
 class LMIR
@@ -45,21 +47,62 @@ class LMIR
     /* Public class methods */
     /************************/
 
+    /**
+     * @brief Calculate the absolute discount score of a single query term
+     *  found in the document.
+     *
+     * @param docTermFrequency
+     * @param docLen
+     * @param nUniqueTerms Number of unique terms in the document.
+     * @param termProb Corpus probability of the term.
+     * @return base::FValType
+     */
+    base::FValType absoluteDiscountTerm(
+        std::size_t const docTermFrequency, std::size_t const docLen,
+        std::size_t const nUniqueTerms, double const termProb) const;
+
+    /**
+     * @brief Calculate the Dirichlet score of a single query term found in
+     *  the document.
+     *
+     */
+    base::FValType dirichletTerm(
+        std::size_t const docTermFrequency, std::size_t const docLen,
+        double const termProb) const;
+
+    /**
+     * @brief Calculate the Jelinek-Mercer score of a single query term found
+     *  in the document.
+     *
+     */
+    base::FValType jelinekMercerTerm(
+        std::size_t const docTermFrequency, std::size_t const docLen,
+        double const termProb) const;
+
+    /**
+     * @brief Get the corpus wide probability of every term.
+     *
+     * @return base::StrDblMap const&
+     */
+    base::StrDblMap const & getTermProbabilityMap() const;
+
     /**
      * @brief Calculate the absolute cumulative discount score.
      *
      */
+    template <class TfMap>
     base::FValType absolute_discount(
-        base::StrSizeMap const & docTermFreqMap, std::size_t const docLen,
-        base::StrSizeMap const & queryTermFreqMap) const;
+        TfMap const & docTermFreqMap, std::size_t const docLen,
+        TfMap const & queryTermFreqMap) const;
 
     /**
      * @brief Calculate the Dirichlet score.
      *
      */
+    template <class TfMap>
     base::FValType dirichlet(
-        base::StrSizeMap const & docTermFreqMap, std::size_t const docLen,
-        base::StrSizeMap const & queryTermFreqMap) const;
+        TfMap const & docTermFreqMap, std::size_t const docLen,
+        TfMap const & queryTermFreqMap) const;
 
     /**
      * @brief Calculate the Jelinek-Mercer Score
@@ -69,29 +112,16 @@ class LMIR
      * @param queryTermFreqMap
      * @return base::FValType
      */
+    template <class TfMap>
     base::FValType jelinek_mercer(
-        base::StrSizeMap const & docTermFreqMap, std::size_t const docLen,
-        base::StrSizeMap const & queryTermFreqMap) const;
+        TfMap const & docTermFreqMap, std::size_t const docLen,
+        TfMap const & queryTermFreqMap) const;
 
 private:
     /* Private member variables */
     /****************************/
 
     base::StrDblMap termProbabilityMap;  // corpus wide term probability
-
-    /* Private class methods */
-    /*************************/
-
-    /**
-     * @brief Calculate the PML score for each term in the document.
-     *
-     * @param docTermFreqMap The document's term frequency map.
-     * @param docLen The length of the document.
-     * @return base::StrDblMap The calculated pMl for each term.
-     */
-    base::StrDblMap calcDocPml(
-        base::StrSizeMap const & docTermFreqMap,
-        std::size_t const docLen) const;
 };
 
 }  // namespace lowletorfeats
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <lowletorfeats/FeatureMatrix.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Streams feature vectors as LETOR / SVMlight lines,
+ *  `label qid:<qid> 1:<value> 2:<value> ... #<docid>`, to a file descriptor.
+ *  Lines are formatted into a fixed buffer that is written out when full,
+ *  with values in their shortest round-trip representation.
+ *
+ */
+class LetorWriter
+{
+public:
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Create or truncate the file at the given path and write to it.
+     *  Throws `std::runtime_error` if it cannot be opened.
+     *
+     * @param path
+     */
+    explicit LetorWriter(std::string const & path);
+
+    /**
+     * @brief Write to an open file descriptor, such as `STDOUT_FILENO`.
+     *  The descriptor is not closed by the writer.
+     *
+     * @param fd
+     */
+    explicit LetorWriter(int const fd);
+
+    LetorWriter(LetorWriter const & other) = delete;
+    LetorWriter & operator=(LetorWriter const & other) = delete;
+
+    /**
+     * @brief Flush the buffer, and close the file if opened by the writer.
+     *  Write errors are ignored here, call `close` to have them thrown.
+     *
+     */
+    ~LetorWriter();
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Write a line for every document of a query.
+     *
+     * @param fMatrix Computes any pending features.
+     * @param qid
+     * @param labels Relevance label of every document, 0 if empty.
+     * @param docIds Id of every document written as a comment, no comment
+     *  if empty.
+     */
+    void writeQuery(
+        FeatureMatrix & fMatrix, std::string_view const qid,
+        std::vector<base::FValType> const & labels = {},
+        std::vector<std::string> const & docIds = {});
+
+    /**
+     * @brief Write the line of a single document.
+     *
+     * @param label
+     * @param qid
+     * @param fValues Feature values, numbered from 1.
+     * @param numFeatures
+     * @param docId Written as a comment if not empty.
+     */
+    void writeRow(
+        base::FValType const label, std::string_view const qid,
+        base::FValType const * fValues, std::size_t const numFeatures,
+        std::string_view const docId = {});
+
+    /**
+     * @brief Write out the buffered lines. Throws `std::runtime_error` on a
+     *  write error.
+     *
+     */
+    void flush();
+
+    /**
+     * @brief Flush the buffer and close the file if opened by the writer.
+     *  Later writes throw `std::runtime_error`.
+     *
+     */
+    void close();
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    int fd;
+    bool ownsFd;
+
+    std::vector<char> buffer;
+    std::size_t bufferLen = 0;
+
+    // Scratch row of `writeQuery`
+    std::vector<base::FValType> rowScratch;
+
+    /* Private static member variables */
+    /***********************************/
+
+    static std::size_t const BUFFER_SIZE;
+
+    // Longest shortest round-trip representation of a `double`
+    static std::size_t const MAX_VALUE_CHARS;
+
+    /* Private class methods */
+    /*************************/
+
+    void append(std::string_view const str);
+
+    void appendValue(base::FValType const value);
+
+    /**
+     * @brief Flush the buffer unless `nChars` more characters fit.
+     *
+     */
+    void reserve(std::size_t const nChars);
+};
+
+}  // namespace lowletorfeats
@@ -6,6 +6,8 @@ namespace lowletorfeats
 {
 /**
  * @brief Static class for calculating Okapi BM25 like scores.
+ *  The query methods are instantiated for `base::StrSizeMap` and
+ *  `base::FlatStrSizeMap` term frequency maps.
  *
  */
 class Okapi
@@ -13,6 +15,12 @@ class Okapi
 public:
     /* BM25 */
     /********/
+    static base::FValType bm25TfNorm(
+        std::size_t const & docTermFrequency, std::size_t const & numDocs,
+        float const & avgDocLen, float const & b, float const & k1);
+    static base::FValType bm25TfNorm(
+        std::size_t const & docTermFrequency, std::size_t const & numDocs,
+        float const & avgDocLen);
     static base::FValType bm25(
         std::size_t const & docTermFrequency, std::size_t const & numDocs,
         std::size_t const & numDocsWithTerm, float const & avgDocLen,
@@ -20,13 +28,21 @@ class Okapi
     static base::FValType bm25(
         std::size_t const & docTermFrequency, std::size_t const & numDocs,
         std::size_t const & numDocsWithTerm, float const & avgDocLen);
+    template <class TfMap>
     static base::FValType queryBm25(
-        base::StrSizeMap const & docTermFreqMap, std::size_t const & numDocs,
+        TfMap const & docTermFreqMap, std::size_t const & numDocs,
         base::StrSizeMap const & docsWithTermFreqMap, float const & avgDocLen,
-        base::StrSizeMap const & queryTermFreqMap);
+        TfMap const & queryTermFreqMap);
 
     /* BM25+ */
     /*********/
+    static base::FValType bm25plusTfNorm(
+        std::size_t const & docTermFrequency, std::size_t const & numDocs,
+        float const & avgDocLen, float const & b, float const & k1,
+        float const & delta);
+    static base::FValType bm25plusTfNorm(
+        std::size_t const & docTermFrequency, std::size_t const & numDocs,
+        float const & avgDocLen);
     static base::FValType bm25plus(
         std::size_t const & docTermFrequency, std::size_t const & numDocs,
         std::size_t const & numDocsWithTerm, float const & avgDocLen,
@@ -34,30 +50,33 @@ class Okapi
     static base::FValType bm25plus(
         std::size_t const & docTermFrequency, std::size_t const & numDocs,
         std::size_t const & numDocsWithTerm, float const & avgDocLen);
+    template <class TfMap>
     static base::FValType queryBm25plus(
-        base::StrSizeMap const & docTermFreqMap, std::size_t const & numDocs,
+        TfMap const & docTermFreqMap, std::size_t const & numDocs,
         base::StrSizeMap const & docsWithTermFreqMap, float const & avgDocLen,
-        base::StrSizeMap const & queryTermFreqMap);
+        TfMap const & queryTermFreqMap);
 
     /* BM25f */
     /*********/
+    template <class StructuredTfMap>
     static base::FValType queryBm25f(
-        base::StructuredTermFrequencyMap const & structDocTermFreqMap,
+        StructuredTfMap const & structDocTermFreqMap,
         std::size_t const & numDocs,
         base::StructuredTermFrequencyMap const & structDocsWithTermFreqMap,
         base::StrFltMap const & avgDocLenMap,
-        base::StrSizeMap const & queryTermFreqMap,
+        typename StructuredTfMap::mapped_type const & queryTermFreqMap,
         std::unordered_map<std::string, base::WeightType> const &
             sectionWeights);
 
     /* BM25f+ */
     /**********/
+    template <class StructuredTfMap>
     static base::FValType queryBm25fplus(
-        base::StructuredTermFrequencyMap const & structDocTermFreqMap,
+        StructuredTfMap const & structDocTermFreqMap,
         std::size_t const & numDocs,
         base::StructuredTermFrequencyMap const & structDocsWithTermFreqMap,
         base::StrFltMap const & avgDocLenMap,
-        base::StrSizeMap const & queryTermFreqMap,
+        typename StructuredTfMap::mapped_type const & queryTermFreqMap,
         std::unordered_map<std::string, base::WeightType> const &
             sectionWeights);
 
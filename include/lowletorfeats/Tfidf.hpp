@@ -6,6 +6,8 @@ namespace lowletorfeats
 {
 /**
  * @brief Static class for claculating TF/IDF related scores.
+ *  The map based methods are instantiated for `base::StrSizeMap` and
+ *  `base::FlatStrSizeMap` term frequency maps.
  *
  */
 class Tfidf
@@ -53,15 +55,16 @@ class Tfidf
      * @brief Return the sum of tfLogNorm for a document.
      *
      */
-    static base::FValType sumTfLogNorm(
-        base::StrSizeMap const & docTermFreqMap);
+    template <class TfMap>
+    static base::FValType sumTfLogNorm(TfMap const & docTermFreqMap);
 
     /**
      * @brief Return the sum of tfDoubleNorm for a document.
      *
      */
+    template <class TfMap>
     static base::FValType sumTfDoubleNorm(
-        base::StrSizeMap const & docTermFreqMap,
+        TfMap const & docTermFreqMap,
         std::size_t const & docMaxTermFrequency);
 
     /* Inverse document frequency */
@@ -97,11 +100,12 @@ class Tfidf
         std::size_t const & docTermFrequency,
         std::size_t const & docMaxTermFrequency, std::size_t const & numDocs,
         std::size_t const & numDocsWithTerm);
+    template <class TfMap>
     base::FValType static queryTfidf(
-        base::StrSizeMap const & docTermFreqMap,
-        std::size_t const & docMaxTermFrequency, std::size_t const & numDocs,
+        TfMap const & docTermFreqMap, std::size_t const & docMaxTermFrequency,
+        std::size_t const & numDocs,
         base::StrSizeMap const & docsWithTermFreqMap,
-        base::StrSizeMap const & queryTermFreqMap);
+        TfMap const & queryTermFreqMap);
 
 private:
     Tfidf() {}
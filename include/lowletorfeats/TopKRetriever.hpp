@@ -0,0 +1,143 @@
+#pragma once
+
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <lowletorfeats/base/stdDef.hpp>
+#include <vector>
+
+namespace lowletorfeats
+{
+/**
+ * @brief Document retrieved for a query, with its first-stage score.
+ *
+ */
+struct ScoredDoc
+{
+    base::DocId docId;
+    base::FValType score;
+};
+
+/**
+ * @brief First-stage top-k retrieval over an `InvertedIndex` section.
+ *  Scores match `Okapi::bm25` and `Okapi::bm25plus` summed over the unique
+ *  query terms, using the statistics of the whole index. Traversal is
+ *  document-at-a-time with block-max WAND dynamic pruning: a document is
+ *  only scored if the upper bounds of the query terms it can contain, first
+ *  over the whole postings lists then over their current blocks, may beat
+ *  the current k-th score. Runs of blocks that cannot are skipped whole.
+ *
+ */
+class TopKRetriever
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    enum class Model
+    {
+        bm25,
+        bm25plus
+    };
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct a retriever over a section of the index.
+     *  The index must outlive the retriever.
+     *
+     * @param index
+     * @param sectionKey Section whose postings are scored.
+     * @param model
+     */
+    explicit TopKRetriever(
+        InvertedIndex const & index, std::string const & sectionKey = "full",
+        Model const model = Model::bm25);
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Retrieve the k highest scoring documents for a raw query.
+     *
+     * @param queryText Raw unanalyzed query string.
+     * @param k
+     * @return std::vector<ScoredDoc> Ordered by decreasing score, then
+     *  increasing docId.
+     */
+    std::vector<ScoredDoc> retrieve(
+        std::string const & queryText, std::size_t const k) const;
+
+    /**
+     * @brief Retrieve the k highest scoring documents for a preanalyzed
+     *  query, see above.
+     *
+     */
+    std::vector<ScoredDoc> retrieve(
+        base::StrSizeMap const & queryTfMap, std::size_t const k) const;
+
+    /* Getter methods */
+    /******************/
+
+    std::string const & getSectionKey() const { return this->sectionKey; }
+    Model getModel() const { return this->model; }
+
+    /**
+     * @brief Get the docIds of retrieved documents, in retrieval order.
+     *
+     * @param scoredDocVect
+     * @return std::vector<base::DocId>
+     */
+    static std::vector<base::DocId> getDocIds(
+        std::vector<ScoredDoc> const & scoredDocVect);
+
+private:
+    /* Private type definitions */
+    /****************************/
+
+    struct Cursor
+    {
+        InvertedIndex::TermPostings const * termPostings;
+        std::size_t pos;
+        std::size_t blockIdx;  // Block last moved to by `seekBlock`
+        base::FValType idf;
+        base::FValType upperBound;  // Highest contribution to a score
+
+        base::DocId docId() const;
+
+        /**
+         * @brief Move to the first posting not before the given document.
+         *
+         */
+        void seek(base::DocId const targetDocId);
+
+        /**
+         * @brief Move only the block to the one that would hold the given
+         *  document, without decoding postings.
+         *
+         * @return InvertedIndex::PostingsBlock const* Null past the last
+         *  block.
+         */
+        InvertedIndex::PostingsBlock const * seekBlock(
+            base::DocId const targetDocId);
+    };
+
+    /* Private member variables */
+    /****************************/
+
+    InvertedIndex const * index;
+    std::string sectionKey;
+    Model model;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Calculate the contribution of a query term to a score.
+     *
+     */
+    base::FValType termScore(
+        std::uint32_t const tf, base::FValType const idf,
+        std::size_t const numDocs, float const avgDocLen) const;
+};
+
+}  // namespace lowletorfeats
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <condition_variable>  // condition_variable
+#include <cstddef>             // size_t
+#include <deque>               // deque
+#include <mutex>               // mutex, unique_lock
+#include <utility>             // move
+
+namespace lowletorfeats::base
+{
+/**
+ * @brief Blocking first-in first-out queue of a fixed capacity, shared by
+ *  producer and consumer threads. Producers wait while it is full, which
+ *  applies backpressure up a pipeline.
+ *
+ * @tparam T
+ */
+template <class T>
+class BoundedQueue
+{
+public:
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct an empty queue holding at most `capacity` items.
+     *
+     * @param capacity At least 1.
+     */
+    explicit BoundedQueue(std::size_t const capacity)
+        : capacity(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    BoundedQueue(BoundedQueue const & other) = delete;
+    BoundedQueue & operator=(BoundedQueue const & other) = delete;
+
+    /* Public class methods */
+    /************************/
+
+    /**
+     * @brief Append an item, waiting while the queue is full.
+     *
+     * @param item
+     * @return true If the item was appended.
+     * @return false If the queue is closed, the item is left as is.
+     */
+    bool push(T && item)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->notFull.wait(lock, [this]() {
+            return this->closed || this->items.size() < this->capacity;
+        });
+        if (this->closed) return false;
+
+        this->items.push_back(std::move(item));
+        lock.unlock();
+        this->notEmpty.notify_one();
+
+        return true;
+    }
+
+    /**
+     * @brief Remove the first item, waiting while the queue is empty.
+     *
+     * @param item Assigned the removed item.
+     * @return true If an item was removed.
+     * @return false If the queue is closed and drained, or cancelled.
+     */
+    bool pop(T & item)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->notEmpty.wait(
+            lock, [this]() { return this->closed || !this->items.empty(); });
+        if (this->cancelled || this->items.empty()) return false;
+
+        item = std::move(this->items.front());
+        this->items.pop_front();
+        lock.unlock();
+        this->notFull.notify_one();
+
+        return true;
+    }
+
+    /**
+     * @brief Stop accepting items. Items already queued can still be
+     *  popped.
+     *
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> const lock(this->mutex);
+            this->closed = true;
+        }
+        this->notFull.notify_all();
+        this->notEmpty.notify_all();
+    }
+
+    /**
+     * @brief Close the queue and drop its items, waking every waiting
+     *  thread.
+     *
+     */
+    void cancel()
+    {
+        {
+            std::lock_guard<std::mutex> const lock(this->mutex);
+            this->closed = true;
+            this->cancelled = true;
+            this->items.clear();
+        }
+        this->notFull.notify_all();
+        this->notEmpty.notify_all();
+    }
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    std::size_t const capacity;
+
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+    std::deque<T> items;
+    bool closed = false;
+    bool cancelled = false;
+};
+
+}  // namespace lowletorfeats::base
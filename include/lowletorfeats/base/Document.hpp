@@ -1,5 +1,6 @@
 #pragma once
 
+#include <lowletorfeats/Instrumentation.hpp>
 #include <lowletorfeats/base/stdDef.hpp>
 #include <vector>
 
@@ -22,6 +23,13 @@ class StructuredDocument
      */
     StructuredDocument();
 
+    /**
+     * @brief Empty constructor allocating from the given memory resource.
+     *
+     * @param resource Memory resource backing every map of the document.
+     */
+    explicit StructuredDocument(std::pmr::memory_resource * resource);
+
     // Preanalyzed
 
     /**
@@ -31,11 +39,14 @@ class StructuredDocument
      * @param docLen The full document's length.
      * @param fullTermFrequencyMap Preanalyzed `TermFrequencyMap` for the full
      * doc.
+     * @param resource Memory resource backing every map of the document.
      */
     StructuredDocument(  // The indicated section only
         std::size_t const & docLen,
         base::StrSizeMap const & fullTermFrequencyMap,
-        std::string const & sectionKey);
+        std::string const & sectionKey,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
 
     /**
      * @brief Construct a new Structured Document object using a preanalyzed
@@ -44,10 +55,13 @@ class StructuredDocument
      * @param docLen The full document's length.
      * @param fullTermFrequencyMap Preanalyzed `TermFrequencyMap` for the full
      * doc.
+     * @param resource Memory resource backing every map of the document.
      */
     StructuredDocument(  // `"full"` section only
         std::size_t const & docLen,
-        base::StrSizeMap const & fullTermFrequencyMap);
+        base::StrSizeMap const & fullTermFrequencyMap,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
 
     /**
      * @brief Construct a new Structured Document object using a preanalyzed
@@ -56,20 +70,66 @@ class StructuredDocument
      * @param docLenMap The document lengths for each structured section.
      * @param structuredTermFrequencyMap Preanalyzed `TermFrequencyMap`s for
      * each structured section.
+     * @param resource Memory resource backing every map of the document.
      */
     StructuredDocument(  // One or more sections
         base::StrSizeMap const & docLenMap,
-        base::StructuredTermFrequencyMap const & structuredTermFrequencyMap);
+        base::StructuredTermFrequencyMap const & structuredTermFrequencyMap,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
+
+    /**
+     * @brief Construct a new Structured Document object using a preanalyzed
+     *  document length map and sorted `FlatStrSizeMap`s.
+     *
+     * @param docLenMap The document lengths for each structured section.
+     * @param structuredTermFrequencyMap Preanalyzed term frequencies for each
+     *  structured section.
+     * @param resource Memory resource backing every map of the document.
+     */
+    StructuredDocument(  // One or more sections
+        base::StrSizeMap const & docLenMap,
+        base::StructuredFlatTermFrequencyMap const &
+            structuredTermFrequencyMap,
+        std::pmr::memory_resource * resource =
+            std::pmr::get_default_resource());
 
     // Copy constructor
 
     /**
      * @brief Copy constructor.
+     *  The copy allocates from the default memory resource so that it may
+     *  outlive the resource of `other`.
      *
      * @param other
      */
     StructuredDocument(StructuredDocument const & other);
 
+    /**
+     * @brief Copy constructor allocating from the given memory resource.
+     *
+     * @param other
+     * @param resource Memory resource backing every map of the copy.
+     */
+    StructuredDocument(
+        StructuredDocument const & other,
+        std::pmr::memory_resource * resource);
+
+    /**
+     * @brief Move constructor. Keeps the memory resource of `other`.
+     *  Does not throw, so that containers of documents move them when
+     *  growing instead of copying them out of their memory resource.
+     *
+     * @param other
+     */
+    StructuredDocument(StructuredDocument && other) noexcept;
+
+    /* Assignment operators */
+    /************************/
+
+    StructuredDocument & operator=(StructuredDocument const & other) = default;
+    StructuredDocument & operator=(StructuredDocument && other) = default;
+
     /* Public class methods */
     /************************/
 
@@ -100,6 +160,15 @@ class StructuredDocument
      */
     void clearFeatureMap();
 
+    /**
+     * @brief Add the estimated memory held by the document to `stats`.
+     *  Term frequency maps are attributed to their section and feature
+     *  values to the section of their feature.
+     *
+     * @param stats
+     */
+    void addMemoryUsage(MemoryStats & stats) const;
+
     /* Getter methods */
 
     /**
@@ -120,25 +189,25 @@ class StructuredDocument
     /**
      * @brief Get the entire structured term frequency map.
      *
-     * @return std::unordered_map<std::string, base::TermFrequencyMap> const&
+     * @return base::StructuredFlatTermFrequencyMap const&
      */
-    base::StructuredTermFrequencyMap const & getStructuredTermFrequencyMap()
-        const;
+    base::StructuredFlatTermFrequencyMap const &
+        getStructuredTermFrequencyMap() const;
 
     /**
      * @brief Get the `TermFrequencyMap` for the full document.
      *
-     * @return base::TermFrequencyMap const&
+     * @return base::FlatStrSizeMap const&
      */
-    base::StrSizeMap const & getTermFrequencyMap() const;
+    base::FlatStrSizeMap const & getTermFrequencyMap() const;
 
     /**
      * @brief Get the `TermFrequencyMap` for the given section.
      *
      * @param section
-     * @return base::TermFrequencyMap const&
+     * @return base::FlatStrSizeMap const&
      */
-    base::StrSizeMap const & getTermFrequencyMap(
+    base::FlatStrSizeMap const & getTermFrequencyMap(
         std::string const & section) const;
 
     /**
@@ -197,13 +266,23 @@ class StructuredDocument
     void updateFeature(
         base::FeatureKey const & fKey, base::FValType const & fValue);
 
+    /**
+     * @brief Replace the term frequencies of every section, keeping the
+     *  document lengths and feature values.
+     *  The "full" section is populated from the others if it is missing.
+     *
+     * @param structuredTermFrequencyMap
+     */
+    void setStructuredTermFrequencyMap(
+        base::StructuredFlatTermFrequencyMap && structuredTermFrequencyMap);
+
 private:
     /* Private member variables */
     /****************************/
 
     base::StrSizeMap docLenMaps;
 
-    base::StructuredTermFrequencyMap termFrequencyMaps;
+    base::StructuredFlatTermFrequencyMap termFrequencyMaps;
     base::StrSizeMap maxTermMaps;
 
     base::FeatureMap featureMap;
@@ -211,6 +290,13 @@ class StructuredDocument
     /* Private class methods */
     /*************************/
 
+    /**
+     * @brief Fill the `maxTermMaps` from the `termFrequencyMaps`, populating
+     *  the "full" section if it does not exist.
+     *
+     */
+    void initMaxTermMaps();
+
     /**
      * @brief Fill the "full" sections based on other existing sections.
      *  Assigns docLenMap["full"], termFrequencyMap["full"],
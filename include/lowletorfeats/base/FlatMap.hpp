@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>         // lower_bound, stable_sort, unique
+#include <cstddef>           // ptrdiff_t
+#include <initializer_list>  // initializer_list
+#include <memory_resource>   // polymorphic_allocator
+#include <stdexcept>         // out_of_range
+#include <utility>           // pair, move
+#include <vector>            // pmr::vector
+
+namespace lowletorfeats::base
+{
+/**
+ * @brief Associative container for small maps stored as a vector of pairs
+ *  sorted by key.
+ *  Intended for the query-filtered term frequency maps, which hold a handful
+ *  of entries. Lookups are a short scan over contiguous memory instead of a
+ *  hash and a pointer chase per node.
+ *
+ * @tparam Key
+ * @tparam T
+ */
+template <class Key, class T>
+class FlatMap
+{
+public:
+    /* Public type definitions */
+    /***************************/
+
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef std::pair<Key, T> value_type;
+    typedef std::size_t size_type;
+    typedef std::pmr::polymorphic_allocator<value_type> allocator_type;
+
+    typedef typename std::pmr::vector<value_type>::iterator iterator;
+    typedef
+        typename std::pmr::vector<value_type>::const_iterator const_iterator;
+
+    /* Constructors */
+    /****************/
+
+    /**
+     * @brief Construct an empty `FlatMap`.
+     *
+     */
+    FlatMap() {}
+
+    /**
+     * @brief Construct an empty `FlatMap` using the given allocator.
+     *
+     * @param alloc
+     */
+    explicit FlatMap(allocator_type const & alloc) : values(alloc) {}
+
+    /**
+     * @brief Construct a `FlatMap` from a list of key-value pairs.
+     *  The first occurrence of a duplicate key is kept.
+     *
+     * @param init
+     * @param alloc
+     */
+    FlatMap(
+        std::initializer_list<value_type> init,
+        allocator_type const & alloc = allocator_type())
+        : values(alloc)
+    {
+        this->insert(init.begin(), init.end());
+    }
+
+    /**
+     * @brief Construct a `FlatMap` from a range of key-value pairs, such as
+     *  the contents of an `unordered_map`.
+     *  The first occurrence of a duplicate key is kept.
+     *
+     * @tparam InputIt
+     * @param first
+     * @param last
+     * @param alloc
+     */
+    template <class InputIt>
+    FlatMap(
+        InputIt first, InputIt last,
+        allocator_type const & alloc = allocator_type())
+        : values(alloc)
+    {
+        this->insert(first, last);
+    }
+
+    /**
+     * @brief Copy constructor using the given allocator.
+     *
+     * @param other
+     * @param alloc
+     */
+    FlatMap(FlatMap const & other, allocator_type const & alloc)
+        : values(other.values, alloc)
+    {
+    }
+
+    /**
+     * @brief Move constructor using the given allocator.
+     *
+     * @param other
+     * @param alloc
+     */
+    FlatMap(FlatMap && other, allocator_type const & alloc)
+        : values(std::move(other.values), alloc)
+    {
+    }
+
+    FlatMap(FlatMap const & other) = default;
+    FlatMap(FlatMap && other) = default;
+
+    FlatMap & operator=(FlatMap const & other) = default;
+    FlatMap & operator=(FlatMap && other) = default;
+
+    /* Public class methods */
+    /************************/
+
+    allocator_type get_allocator() const
+    {
+        return this->values.get_allocator();
+    }
+
+    iterator begin() { return this->values.begin(); }
+    iterator end() { return this->values.end(); }
+    const_iterator begin() const { return this->values.begin(); }
+    const_iterator end() const { return this->values.end(); }
+
+    size_type size() const { return this->values.size(); }
+    size_type capacity() const { return this->values.capacity(); }
+    bool empty() const { return this->values.empty(); }
+
+    void clear() { this->values.clear(); }
+    void reserve(size_type const n) { this->values.reserve(n); }
+
+    /**
+     * @brief Find the entry with the given key.
+     *
+     * @param key
+     * @return iterator The entry, or `end()` if not found.
+     */
+    iterator find(Key const & key)
+    {
+        auto const it = this->lowerBound(key);
+        return (it != this->values.end() && it->first == key)
+                   ? this->values.begin() + (it - this->values.cbegin())
+                   : this->values.end();
+    }
+
+    const_iterator find(Key const & key) const
+    {
+        auto const it = this->lowerBound(key);
+        return (it != this->values.end() && it->first == key)
+                   ? it
+                   : this->values.end();
+    }
+
+    size_type count(Key const & key) const
+    {
+        return (this->find(key) != this->end()) ? 1 : 0;
+    }
+
+    /**
+     * @brief Get the value for the given key.
+     *  Throws `std::out_of_range` if the key does not exist.
+     *
+     * @param key
+     */
+    T & at(Key const & key)
+    {
+        auto const it = this->find(key);
+        if (it == this->end()) FlatMap::throwOutOfRange();
+
+        return it->second;
+    }
+
+    T const & at(Key const & key) const
+    {
+        auto const it = this->find(key);
+        if (it == this->end()) FlatMap::throwOutOfRange();
+
+        return it->second;
+    }
+
+    /**
+     * @brief Get the value for the given key, inserting a value-initialized
+     *  entry if it does not exist.
+     *
+     * @param key
+     */
+    T & operator[](Key const & key)
+    {
+        return this->insert(value_type(key, T())).first->second;
+    }
+
+    /**
+     * @brief Insert the key-value pair if the key does not already exist.
+     *  Appending keys in ascending order is amortized constant time.
+     *
+     * @param value
+     * @return std::pair<iterator, bool> The entry for the key and whether
+     *  the insertion took place.
+     */
+    std::pair<iterator, bool> insert(value_type const & value)
+    {
+        if (this->values.empty() || this->values.back().first < value.first)
+        {
+            this->values.push_back(value);
+            return {this->values.end() - 1, true};
+        }
+
+        auto const pos = this->values.begin() +
+                         (this->lowerBound(value.first) - this->values.cbegin());
+        if (pos != this->values.end() && pos->first == value.first)
+            return {pos, false};
+
+        return {this->values.insert(pos, value), true};
+    }
+
+    /**
+     * @brief Insert a range of key-value pairs.
+     *  The first occurrence of a duplicate key is kept.
+     *
+     * @tparam InputIt
+     * @param first
+     * @param last
+     */
+    template <class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        auto const oldSize = static_cast<std::ptrdiff_t>(this->values.size());
+        for (; first != last; ++first) this->values.emplace_back(*first);
+
+        // Sort the new entries, then merge them with the existing ones
+        std::stable_sort(
+            this->values.begin() + oldSize, this->values.end(),
+            FlatMap::compareKeys);
+        std::inplace_merge(
+            this->values.begin(), this->values.begin() + oldSize,
+            this->values.end(), FlatMap::compareKeys);
+
+        auto const newEnd = std::unique(
+            this->values.begin(), this->values.end(),
+            [](value_type const & a, value_type const & b) {
+                return a.first == b.first;
+            });
+        this->values.erase(newEnd, this->values.end());
+    }
+
+    /**
+     * @brief Remove the entry with the given key.
+     *
+     * @param key
+     * @return size_type The number of removed entries.
+     */
+    size_type erase(Key const & key)
+    {
+        auto const it = this->find(key);
+        if (it == this->end()) return 0;
+
+        this->values.erase(it);
+        return 1;
+    }
+
+private:
+    /* Private member variables */
+    /****************************/
+
+    std::pmr::vector<value_type> values;  // Sorted by key
+
+    /* Private static member variables */
+    /***********************************/
+
+    // Maps of at most this size are searched linearly
+    static constexpr size_type LINEAR_SEARCH_MAX = 8;
+
+    /* Private class methods */
+    /*************************/
+
+    /**
+     * @brief Get the first entry whose key is not less than the given key.
+     *
+     */
+    const_iterator lowerBound(Key const & key) const
+    {
+        if (this->values.size() <= FlatMap::LINEAR_SEARCH_MAX)
+        {
+            auto it = this->values.cbegin();
+            while (it != this->values.cend() && it->first < key) ++it;
+            return it;
+        }
+
+        return std::lower_bound(
+            this->values.cbegin(), this->values.cend(), key,
+            [](value_type const & a, Key const & k) { return a.first < k; });
+    }
+
+    /* Private static class methods */
+    /********************************/
+
+    static bool compareKeys(value_type const & a, value_type const & b)
+    {
+        return a.first < b.first;
+    }
+
+    [[noreturn]] static void throwOutOfRange()
+    {
+        throw std::out_of_range("FlatMap::at");
+    }
+};
+
+}  // namespace lowletorfeats::base
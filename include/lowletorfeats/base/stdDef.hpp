@@ -3,7 +3,12 @@
 #include <tsl/ordered_map.h>
 
 #include <lowletorfeats/base/FeatureKey.hpp>
-#include <unordered_map>  // unordered_map
+#include <lowletorfeats/base/FlatMap.hpp>
+#include <cstdint>          // uint32_t
+#include <memory_resource>  // memory_resource, polymorphic_allocator
+#include <string_view>      // string_view
+#include <unordered_map>    // unordered_map
+#include <vector>           // pmr::vector
 
 namespace lowletorfeats::base
 {
@@ -12,18 +17,35 @@ typedef float WeightType;  // Section weight type
 
 typedef std::unordered_map<std::string, uint>
     StrUintMap;  // String to uint map
-typedef std::unordered_map<std::string, std::size_t>
+typedef std::pmr::unordered_map<std::string, std::size_t>
     StrSizeMap;  // String to size map
-typedef std::unordered_map<std::string, float>
+typedef std::pmr::unordered_map<std::string, float>
     StrFltMap;  // String to float map
-typedef std::unordered_map<std::string, double>
+typedef std::pmr::unordered_map<std::string, double>
     StrDblMap;  // String to double map
 
 typedef std::unordered_map<std::string, std::string>
     StrStrMap;  // String to string map
-typedef std::unordered_map<std::string, base::StrSizeMap>
+typedef std::vector<std::pair<std::string_view, std::string_view>>
+    StrViewPairVector;  // Viewed section keys and texts of a document
+typedef std::pmr::unordered_map<std::string, base::StrSizeMap>
     StructuredTermFrequencyMap;  // String to string-size map
 
-typedef tsl::ordered_map<FeatureKey, FValType> FeatureMap;  // FKey to FVal map
+typedef FlatMap<std::string, std::size_t>
+    FlatStrSizeMap;  // Small sorted string to size map
+typedef std::pmr::unordered_map<std::string, base::FlatStrSizeMap>
+    StructuredFlatTermFrequencyMap;  // String to small string-size map
+
+typedef std::uint32_t TermId;  // Interned term identifier
+typedef std::uint32_t DocId;   // Document identifier within an index
+typedef std::pmr::vector<std::pair<TermId, std::size_t>>
+    TermCountVector;  // Term ids and their counts, sorted by id
+typedef std::pmr::unordered_map<std::string, base::TermCountVector>
+    StructuredTermCountVector;  // String to term count vector
+
+typedef tsl::ordered_map<
+    FeatureKey, FValType, std::hash<FeatureKey>, std::equal_to<FeatureKey>,
+    std::pmr::polymorphic_allocator<std::pair<FeatureKey, FValType>>>
+    FeatureMap;  // FKey to FVal map
 
 }  // namespace lowletorfeats::base
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <algorithm>  // max_element
+#include <algorithm>  // max_element, lower_bound
+#include <lowletorfeats/base/FlatMap.hpp>
 #include <map>
 #include <numeric>  // accumulate
 #include <unordered_map>
@@ -144,19 +145,164 @@ std::vector<T> getIntersection(
     return interLst;
 }
 
+/**
+ * @brief A range over `[first, last)` usable in range-based for loops.
+ *
+ * @tparam It
+ */
+template <class It>
+class IterRange
+{
+public:
+    IterRange(It first, It last) : first(first), last(last) {}
+
+    It begin() const { return this->first; }
+    It end() const { return this->last; }
+
+private:
+    It first;
+    It last;
+};
+
+/**
+ * @brief Compares map entries or keys by key. Entries are compared by their
+ *  `first` member, anything else is compared directly.
+ *
+ */
+struct KeyLess
+{
+    template <class A, class B>
+    bool operator()(A const & a, B const & b) const
+    {
+        return KeyLess::key(a) < KeyLess::key(b);
+    }
+
+private:
+    template <class K, class V>
+    static K const & key(std::pair<K, V> const & entry)
+    {
+        return entry.first;
+    }
+
+    template <class K>
+    static K const & key(K const & k)
+    {
+        return k;
+    }
+};
+
+/**
+ * @brief Find the first element not less than `value` in a sorted range by
+ *  galloping: probe exponentially growing offsets from `first`, then binary
+ *  search the last gap. Cheaper than `std::lower_bound` when the result is
+ *  close to `first`.
+ *
+ * @tparam RandomIt
+ * @tparam T
+ * @tparam Compare
+ * @param first
+ * @param last
+ * @param value
+ * @param comp
+ * @return RandomIt
+ */
+template <class RandomIt, class T, class Compare>
+RandomIt gallopLowerBound(
+    RandomIt first, RandomIt last, T const & value, Compare comp)
+{
+    auto const size = last - first;
+
+    decltype(last - first) bound = 1;
+    while (bound < size && comp(first[bound], value)) bound *= 2;
+
+    return std::lower_bound(
+        first + bound / 2, first + std::min(bound + 1, size), value, comp);
+}
+
+/**
+ * @brief Get the index of `value` in a sorted range.
+ *
+ * @tparam RandomIt
+ * @tparam T
+ * @tparam Compare
+ * @param first
+ * @param last
+ * @param value
+ * @param comp
+ * @return std::size_t The index, or `last - first` if not found.
+ */
+template <class RandomIt, class T, class Compare>
+std::size_t findSortedIndex(
+    RandomIt first, RandomIt last, T const & value, Compare comp)
+{
+    auto const it = std::lower_bound(first, last, value, comp);
+    if (it == last || comp(value, *it))
+        return static_cast<std::size_t>(last - first);
+
+    return static_cast<std::size_t>(it - first);
+}
+
+/**
+ * @brief Intersect two ranges of unique elements sorted in ascending order.
+ *  Writes the index of every match within each range to the preallocated
+ *  output buffers, which must hold at least `min(|a|, |b|)` indices.
+ *  The smaller range drives the search and the larger one is galloped, so
+ *  asymmetric sizes cost O(small * log(large / small)).
+ *
+ * @tparam RandomItA
+ * @tparam RandomItB
+ * @tparam Compare Callable as both `comp(*a, *b)` and `comp(*b, *a)`.
+ * @param aFirst
+ * @param aLast
+ * @param bFirst
+ * @param bLast
+ * @param aIdxOut Receives the index of each match in `a`.
+ * @param bIdxOut Receives the index of each match in `b`.
+ * @param comp
+ * @return std::size_t The number of matches.
+ */
+template <class RandomItA, class RandomItB, class Compare = KeyLess>
+std::size_t getSortedIntersection(
+    RandomItA aFirst, RandomItA aLast, RandomItB bFirst, RandomItB bLast,
+    std::size_t * aIdxOut, std::size_t * bIdxOut, Compare comp = Compare())
+{
+    if ((aLast - aFirst) > (bLast - bFirst))
+        return getSortedIntersection(
+            bFirst, bLast, aFirst, aLast, bIdxOut, aIdxOut, comp);
+
+    std::size_t nMatches = 0;
+
+    auto bIt = bFirst;
+    for (auto aIt = aFirst; aIt != aLast && bIt != bLast; ++aIt)
+    {
+        bIt = gallopLowerBound(bIt, bLast, *aIt, comp);
+
+        if (bIt != bLast && !comp(*aIt, *bIt))  // Equal
+        {
+            aIdxOut[nMatches] = static_cast<std::size_t>(aIt - aFirst);
+            bIdxOut[nMatches] = static_cast<std::size_t>(bIt - bFirst);
+            ++nMatches;
+            ++bIt;
+        }
+    }
+
+    return nMatches;
+}
+
 /**
  * @brief Get the intersection of two maps.
+ *  The result keeps the type and allocator of `a`.
  *
- * @tparam KEY_T
- * @tparam VALUE_T
- * @param x
- * @param filterMap
- * @return std::unordered_map<KEY_T, VALUE_T>
+ * @tparam Container
+ * @tparam FilterContainer
+ * @param a
+ * @param b
+ * @return Container
  */
-template <class Container>
-Container getIntersection(Container const & a, Container const & b)
+template <class Container, class FilterContainer>
+Container getIntersection(Container const & a, FilterContainer const & b)
 {
-    Container interMap;
+    Container interMap(a.get_allocator());
 
     for (auto const & pair : a)
     {
@@ -166,4 +312,33 @@ Container getIntersection(Container const & a, Container const & b)
     return interMap;
 }
 
+/**
+ * @brief Get the intersection of two sorted `FlatMap`s.
+ *  The result keeps the values and allocator of `a`.
+ *
+ * @tparam Key
+ * @tparam T
+ * @param a
+ * @param b
+ * @return base::FlatMap<Key, T>
+ */
+template <class Key, class T, class FilterT>
+base::FlatMap<Key, T> getIntersection(
+    base::FlatMap<Key, T> const & a, base::FlatMap<Key, FilterT> const & b)
+{
+    std::vector<std::size_t> aIdxVect(std::min(a.size(), b.size()));
+    std::vector<std::size_t> bIdxVect(aIdxVect.size());
+
+    std::size_t const nMatches = getSortedIntersection(
+        a.begin(), a.end(), b.begin(), b.end(), aIdxVect.data(),
+        bIdxVect.data());
+
+    base::FlatMap<Key, T> interMap(a.get_allocator());
+    interMap.reserve(nMatches);
+    for (std::size_t i = 0; i < nMatches; ++i)
+        interMap.insert(*(a.begin() + aIdxVect[i]));
+
+    return interMap;
+}
+
 }  // namespace lowletorfeats::utils
@@ -0,0 +1,319 @@
+#include <algorithm>  // max
+#include <atomic>
+#include <chrono>
+#include <exception>  // exception_ptr, current_exception, rethrow_exception
+#include <lowletorfeats/ExtractionPipeline.hpp>
+#include <lowletorfeats/base/BoundedQueue.hpp>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace lowletorfeats
+{
+/* Constructors */
+
+ExtractionPipeline::ExtractionPipeline(FeaturePlan const & plan)
+    : ExtractionPipeline(plan, Options())
+{
+}
+
+ExtractionPipeline::ExtractionPipeline(
+    FeaturePlan const & plan, Options const & options)
+    : plan(plan), options(options)
+{
+}
+
+/* Public class methods */
+
+void ExtractionPipeline::run(
+    ReadFunction const & readFun, WriteFunction const & writeFun)
+{
+    typedef std::unique_ptr<QueryTask> TaskPtr;
+    typedef base::BoundedQueue<TaskPtr> TaskQueue;
+
+    std::size_t const analyzeThreads =
+        std::max<std::size_t>(1, this->options.analyzeThreads);
+    std::size_t const scoreThreads =
+        std::max<std::size_t>(1, this->options.scoreThreads);
+    std::size_t const writeThreads =
+        std::max<std::size_t>(1, this->options.writeThreads);
+    std::size_t const queueCapacity = this->options.queueCapacity;
+
+    // Enough tasks to fill every queue and thread, more could only wait
+    std::size_t const numTasks = 1 + 3 * queueCapacity + analyzeThreads +
+                                 scoreThreads + writeThreads;
+
+    TaskQueue freeQueue(numTasks);
+    TaskQueue analyzeQueue(queueCapacity);
+    TaskQueue scoreQueue(queueCapacity);
+    TaskQueue writeQueue(queueCapacity);
+    for (std::size_t i = 0; i < numTasks; ++i)
+        freeQueue.push(std::make_unique<QueryTask>());
+
+    this->stageTimings.fill(TimingStat());
+    this->numQueries = 0;
+    this->numDocs = 0;
+
+    std::mutex statsMutex;
+    std::exception_ptr firstError;
+    auto const fail = [&]() {
+        {
+            std::lock_guard<std::mutex> const lock(statsMutex);
+            if (!firstError) firstError = std::current_exception();
+        }
+        for (TaskQueue * queue :
+             {&freeQueue, &analyzeQueue, &scoreQueue, &writeQueue})
+            queue->cancel();
+    };
+    auto const addTiming = [&](Stage const stage, TimingStat const & stat) {
+        std::lock_guard<std::mutex> const lock(statsMutex);
+        this->stageTimings[static_cast<std::size_t>(stage)].merge(stat);
+    };
+
+    // Process the tasks of a queue, the last thread of a stage closes the
+    //  next queue
+    auto const worker = [&](
+                            Stage const stage, TaskQueue & inQueue,
+                            TaskQueue & outQueue,
+                            std::atomic<std::size_t> & nRunning,
+                            auto const & processFun) {
+        TimingStat timingStat;
+        try
+        {
+            TaskPtr task;
+            while (inQueue.pop(task))
+            {
+                {
+                    ScopedTimer const timer(timingStat);
+                    processFun(*task);
+                }
+                if (!outQueue.push(std::move(task))) break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+
+        addTiming(stage, timingStat);
+        if (--nRunning == 0) outQueue.close();
+    };
+
+    std::atomic<std::size_t> nAnalyzing{analyzeThreads};
+    std::atomic<std::size_t> nScoring{scoreThreads};
+
+    auto const analyzeTask = [&](QueryTask & task) {
+        task.fc = std::make_unique<FeatureCollector>();
+        if (this->options.traceRecorder != nullptr)
+            task.fc->setTrace(this->options.traceRecorder, task.qid);
+        this->analyzeFun(task);
+    };
+    auto const scoreTask = [&](QueryTask & task) {
+        task.fc->collectFeatures(this->plan);
+    };
+
+    // Write a task and hand it back to the reader
+    auto const writeTask = [&](TaskPtr & task, TimingStat & timingStat) {
+        {
+            ScopedTimer const timer(timingStat);
+            writeFun(*task);
+        }
+        {
+            std::lock_guard<std::mutex> const lock(statsMutex);
+            ++this->numQueries;
+            this->numDocs += task->fc->getNumDocs();
+        }
+        task->fc.reset();
+        freeQueue.push(std::move(task));
+    };
+
+    auto const writer = [&]() {
+        TimingStat timingStat;
+        try
+        {
+            // Tasks finished early wait for the ones before them
+            std::map<std::size_t, TaskPtr> pendingTasks;
+            std::size_t nextSeqNum = 0;
+
+            TaskPtr task;
+            while (writeQueue.pop(task))
+            {
+                if (writeThreads > 1)
+                {
+                    writeTask(task, timingStat);
+                    continue;
+                }
+
+                pendingTasks.emplace(task->seqNum, std::move(task));
+                for (auto taskIt = pendingTasks.begin();
+                     taskIt != pendingTasks.end() &&
+                     taskIt->first == nextSeqNum;
+                     taskIt = pendingTasks.erase(taskIt), ++nextSeqNum)
+                    writeTask(taskIt->second, timingStat);
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+
+        addTiming(Stage::write, timingStat);
+    };
+
+    auto const reader = [&]() {
+        TimingStat timingStat;
+        try
+        {
+            std::size_t seqNum = 0;
+            TaskPtr task;
+            while (freeQueue.pop(task))
+            {
+                bool hasTask;
+                {
+                    ScopedTimer const timer(timingStat);
+                    hasTask = readFun(*task);
+                }
+                if (!hasTask)
+                {
+                    // The end of the input is not a query
+                    --timingStat.calls;
+                    break;
+                }
+
+                task->seqNum = seqNum++;
+                if (!analyzeQueue.push(std::move(task))) break;
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+
+        addTiming(Stage::read, timingStat);
+        analyzeQueue.close();
+    };
+
+    auto const start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(reader);
+    for (std::size_t i = 0; i < analyzeThreads; ++i)
+        threads.emplace_back([&]() {
+            worker(
+                Stage::analyze, analyzeQueue, scoreQueue, nAnalyzing,
+                analyzeTask);
+        });
+    for (std::size_t i = 0; i < scoreThreads; ++i)
+        threads.emplace_back([&]() {
+            worker(Stage::score, scoreQueue, writeQueue, nScoring, scoreTask);
+        });
+    for (std::size_t i = 0; i < writeThreads; ++i)
+        threads.emplace_back(writer);
+
+    for (auto & thread : threads) thread.join();
+
+    this->seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    if (firstError) std::rethrow_exception(firstError);
+}
+
+std::string ExtractionPipeline::toJson() const
+{
+    std::string outStr =
+        "{\"queries\":" + std::to_string(this->numQueries) +
+        ",\"docs\":" + std::to_string(this->numDocs) +
+        ",\"seconds\":" + std::to_string(this->seconds) +
+        ",\"docs_per_sec\":" +
+        std::to_string(
+            (this->seconds > 0)
+                ? static_cast<double>(this->numDocs) / this->seconds
+                : 0) +
+        ",\"stages\":{";
+    for (std::size_t i = 0; i < this->stageTimings.size(); ++i)
+    {
+        if (i != 0) outStr += ',';
+        outStr +=
+            '"' + ExtractionPipeline::getStageName(static_cast<Stage>(i)) +
+            "\":{\"calls\":" + std::to_string(this->stageTimings[i].calls) +
+            ",\"ns\":" + std::to_string(this->stageTimings[i].nanoseconds) +
+            '}';
+    }
+    outStr += "}}";
+
+    return outStr;
+}
+
+/* Getter methods */
+
+TimingStat const & ExtractionPipeline::getStageTiming(Stage const stage) const
+{
+    return this->stageTimings.at(static_cast<std::size_t>(stage));
+}
+
+std::string const & ExtractionPipeline::getStageName(Stage const stage)
+{
+    static std::array<
+        std::string, static_cast<std::size_t>(Stage::count)> const
+        STAGE_NAMES = {"read", "analyze", "score", "write"};
+
+    return STAGE_NAMES.at(static_cast<std::size_t>(stage));
+}
+
+/* Static methods */
+
+ExtractionPipeline::ReadFunction ExtractionPipeline::readDocuments(
+    DocumentReader & reader)
+{
+    // The group is reused from call to call
+    auto group = std::make_shared<DocumentReader::QueryGroup>();
+
+    return [&reader, group](QueryTask & task) {
+        if (!reader.next(*group)) return false;
+
+        task.qid.assign(group->qid);
+        task.query.assign(group->query);
+        task.labels = group->labels;
+        task.docIds.assign(group->docIds.begin(), group->docIds.end());
+
+        // Copy the texts in a single buffer, then view them
+        std::size_t textSize = 0;
+        for (auto const & doc : group->docs)
+            for (auto const & [sectionKey, sectionText] : doc)
+                textSize += sectionKey.size() + sectionText.size();
+        task.docText.clear();
+        task.docText.reserve(textSize);
+        for (auto const & doc : group->docs)
+            for (auto const & [sectionKey, sectionText] : doc)
+                task.docText.append(sectionKey).append(sectionText);
+
+        task.docs.resize(group->docs.size());
+        std::size_t textPos = 0;
+        for (std::size_t docIdx = 0; docIdx < group->docs.size(); ++docIdx)
+        {
+            task.docs[docIdx].clear();
+            for (auto const & [sectionKey, sectionText] : group->docs[docIdx])
+            {
+                std::string_view const keyView(
+                    task.docText.data() + textPos, sectionKey.size());
+                textPos += sectionKey.size();
+                std::string_view const textView(
+                    task.docText.data() + textPos, sectionText.size());
+                textPos += sectionText.size();
+
+                task.docs[docIdx].emplace_back(keyView, textView);
+            }
+        }
+
+        return true;
+    };
+}
+
+void ExtractionPipeline::analyzeTexts(QueryTask & task)
+{
+    task.fc->setQuery(task.query);
+    task.fc->addDocs(task.docs);
+}
+
+}  // namespace lowletorfeats
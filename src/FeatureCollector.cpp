@@ -1,64 +1,134 @@
+#include <algorithm>  // find, remove, sort
 #include <cassert>
 #include <iomanip>
 #include <lowletorfeats/FeatureCollector.hpp>
 #include <lowletorfeats/LMIR.hpp>
-#include <lowletorfeats/Okapi.hpp>
-#include <lowletorfeats/Tfidf.hpp>
 #include <lowletorfeats/utils.hpp>
+#include <map>
+#include <numeric>  // iota
 #include <textalyzer/utils.hpp>
+#include <type_traits>  // is_reference_v
+#include <utility>      // forward, move
 
 namespace lowletorfeats
 {
+namespace
+{
+std::string const & toSectionKey(std::string const & sectionKey)
+{
+    return sectionKey;
+}
+
+std::string toSectionKey(std::string_view const sectionKey)
+{
+    return std::string(sectionKey);
+}
+
+}  // namespace
+
 /* Constructors */
 
-FeatureCollector::FeatureCollector() {}
+FeatureCollector::FeatureCollector()
+    : FeatureCollector::FeatureCollector(std::pmr::get_default_resource())
+{
+}
+
+FeatureCollector::FeatureCollector(std::pmr::memory_resource * resource)
+    : resource(resource),
+      queryTfMap(resource),
+      numDocs(0),
+      docLenSumPerSection(resource),
+      avgDocLenPerSection(resource),
+      tfMapPerSection(resource),
+      nDocsWithTermPerSection(resource),
+      nTermsPerSection(resource),
+      constantFeatureMap(base::FeatureMap::allocator_type(resource))
+{
+}
 
 FeatureCollector::FeatureCollector(
     std::vector<base::StrStrMap> const & docTextMapVect,
-    std::string const & queryText)
+    std::string const & queryText, std::pmr::memory_resource * resource)
+    : FeatureCollector::FeatureCollector(resource)
 {
     // Query text
-    this->queryTfMap = textalyzer::asFrequencyMap(
-        FeatureCollector::analyzerFun(
-            queryText, FeatureCollector::DEFAULT_NGRAMS)
-            .first);
+    auto const queryFreqMap = textalyzer::asFrequencyMap(
+        this->analyzeText(queryText).first);
+    this->queryTfMap.insert(queryFreqMap.begin(), queryFreqMap.end());
     // Initialize documents
-    this->initDocs(docTextMapVect);
+    this->addDocs(docTextMapVect);
 }
 
 FeatureCollector::FeatureCollector(
     std::vector<base::StrStrMap> const & docTextMapVect,
-    base::StrSizeMap const & queryTfMap)
+    base::StrSizeMap const & queryTfMap, std::pmr::memory_resource * resource)
+    : FeatureCollector::FeatureCollector(resource)
 {
     // Query text
-    this->queryTfMap = queryTfMap;
+    this->queryTfMap.insert(queryTfMap.begin(), queryTfMap.end());
     // Initialize documents
-    this->initDocs(docTextMapVect);
+    this->addDocs(docTextMapVect);
 }
 
 FeatureCollector::FeatureCollector(
     std::vector<base::StrSizeMap> const & docLenMapVect,
     std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect,
-    std::string const & queryText)
+    std::string const & queryText, std::pmr::memory_resource * resource)
+    : FeatureCollector::FeatureCollector(resource)
 {
     // Analyze query text
-    this->queryTfMap = textalyzer::asFrequencyMap(
-        FeatureCollector::analyzerFun(
-            queryText, FeatureCollector::DEFAULT_NGRAMS)
-            .first);
+    auto const queryFreqMap = textalyzer::asFrequencyMap(
+        this->analyzeText(queryText).first);
+    this->queryTfMap.insert(queryFreqMap.begin(), queryFreqMap.end());
     // Initialize documents
-    this->initDocs(docLenMapVect, docTfMapVect);
+    this->addDocs(docLenMapVect, docTfMapVect);
 }
 
 FeatureCollector::FeatureCollector(
     std::vector<base::StrSizeMap> const & docLenMapVect,
     std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect,
-    base::StrSizeMap const & queryTfMap)
+    base::StrSizeMap const & queryTfMap, std::pmr::memory_resource * resource)
+    : FeatureCollector::FeatureCollector(resource)
 {
     // Query text
-    this->queryTfMap = queryTfMap;
+    this->queryTfMap.insert(queryTfMap.begin(), queryTfMap.end());
     // Initialize documents
-    this->initDocs(docLenMapVect, docTfMapVect);
+    this->addDocs(docLenMapVect, docTfMapVect);
+}
+
+FeatureCollector::FeatureCollector(FeatureCollector const & other)
+    : FeatureCollector::FeatureCollector(
+          other, std::pmr::get_default_resource())
+{
+}
+
+FeatureCollector::FeatureCollector(
+    FeatureCollector const & other, std::pmr::memory_resource * resource)
+    : FeatureCollector::FeatureCollector(resource)
+{
+    this->assignState(other);
+}
+
+/* Assignment operators */
+
+FeatureCollector & FeatureCollector::operator=(FeatureCollector const & other)
+{
+    if (this != &other) this->assignState(other);
+
+    return *this;
+}
+
+FeatureCollector & FeatureCollector::operator=(FeatureCollector && other)
+{
+    if (this == &other) return *this;
+
+    // The state of `other` lives in another resource, copy it
+    if (other.resource != this->resource)
+        this->assignState(static_cast<FeatureCollector const &>(other));
+    else
+        this->assignState(std::move(other));
+
+    return *this;
 }
 
 /* Public class methods */
@@ -82,6 +152,11 @@ std::string FeatureCollector::toString() const
         outStr += "\n\t" + sectionKey + ":" + std::to_string(sectionVal);
     outStr += '\n';
 
+    outStr += "Query Constant Features:";
+    for (auto const & [fKey, fVal] : this->constantFeatureMap)
+        outStr += "\n\t" + fKey.toString() + ":" + std::to_string(fVal);
+    outStr += '\n';
+
     outStr += '\n';
     outStr += "Document Feature Maps:\n";
     outStr += "----------------------\n";
@@ -90,37 +165,590 @@ std::string FeatureCollector::toString() const
     return outStr;
 }
 
+bool FeatureCollector::isPruned(std::size_t const docIdx) const
+{
+    return this->prunedDocs.at(docIdx);
+}
+
+std::vector<bool> const & FeatureCollector::getPrunedDocs() const
+{
+    return this->prunedDocs;
+}
+
+MemoryStats FeatureCollector::getMemoryStats() const
+{
+    MemoryStats stats;
+
+    // Documents
+    for (auto const & doc : this->docVect) doc.addMemoryUsage(stats);
+    for (auto const & docTermVect : this->docTermVects)
+    {
+        for (auto const & [sectionKey, termCountVect] : docTermVect)
+            stats.section(sectionKey).termMaps +=
+                termCountVect.capacity() *
+                sizeof(base::TermCountVector::value_type);
+
+        stats.unsectioned().termMaps += MemoryStats::hashMapBytes(docTermVect);
+    }
+
+    // Collection statistics and LMIR models
+    for (auto const & [sectionKey, sectionTfMap] : this->tfMapPerSection)
+    {
+        MemoryUsage & usage = stats.section(sectionKey);
+        usage.statsMaps += MemoryStats::hashMapBytes(sectionTfMap);
+        usage.termStrings += MemoryStats::keyStringBytes(sectionTfMap);
+    }
+    for (auto const & [sectionKey, docsWithTermMap] :
+         this->nDocsWithTermPerSection)
+    {
+        MemoryUsage & usage = stats.section(sectionKey);
+        usage.statsMaps += MemoryStats::hashMapBytes(docsWithTermMap);
+        usage.termStrings += MemoryStats::keyStringBytes(docsWithTermMap);
+    }
+    for (auto const & [sectionKey, lime] : this->lmirCalculators)
+    {
+        auto const & termProbMap = lime.getTermProbabilityMap();
+
+        MemoryUsage & usage = stats.section(sectionKey);
+        usage.lmirModels += MemoryStats::hashMapBytes(termProbMap);
+        usage.termStrings += MemoryStats::keyStringBytes(termProbMap);
+    }
+
+    // Query constant features
+    for (auto const & mapPair : this->constantFeatureMap)
+    {
+        stats.section(mapPair.first.getFSection()).featureMaps +=
+            sizeof(base::FeatureMap::value_type);
+    }
+
+    // The maps over the sections themselves, the query, the requested
+    //  features and the interned terms
+    MemoryUsage & usage = stats.unsectioned();
+    usage.termMaps +=
+        this->docVect.capacity() * sizeof(StructuredDocument) +
+        this->docTermVects.capacity() *
+            sizeof(base::StructuredTermCountVector) +
+        MemoryStats::flatMapBytes(this->queryTfMap) +
+        MemoryStats::hashMapBytes(this->termIds);
+    usage.termStrings += MemoryStats::keyStringBytes(this->queryTfMap) +
+                         MemoryStats::keyStringBytes(this->termIds);
+    usage.statsMaps +=
+        MemoryStats::hashMapBytes(this->docLenSumPerSection) +
+        MemoryStats::hashMapBytes(this->avgDocLenPerSection) +
+        MemoryStats::hashMapBytes(this->tfMapPerSection) +
+        MemoryStats::hashMapBytes(this->nDocsWithTermPerSection) +
+        MemoryStats::hashMapBytes(this->nTermsPerSection) +
+        this->prunedDocs.capacity() / 8;
+    usage.lmirModels += MemoryStats::hashMapBytes(this->lmirCalculators);
+    usage.featureMaps +=
+        MemoryStats::featureMapBytes(this->constantFeatureMap) -
+        this->constantFeatureMap.size() *
+            sizeof(base::FeatureMap::value_type) +
+        this->featureKeys.capacity() * sizeof(base::FeatureKey) +
+        MemoryStats::hashMapBytes(this->pendingFeatures);
+
+    return stats;
+}
+
 std::string FeatureCollector::getFeatureString() const
 {
     if (this->numDocs <= 0) return "";
 
+    this->computePendingFeatures();
+    TraceSpan const span = this->traceSpan("getFeatureString", "output");
+
     std::string outStr = "";
 
     // Construct header
     outStr += "Feature Vectors\n";
 
-    auto const featKeys = this->docVect.at(0).getFeatureKeys();
-    for (auto const & fKey : featKeys) outStr += "|" + fKey.toString();
+    for (auto const & fKey : this->featureKeys)
+        outStr += "|" + fKey.toString();
+    outStr += "\n";
+
+    // Per document features
+    for (auto const & doc : this->docVect)
+    {
+        for (auto const & fKey : this->featureKeys)
+            outStr +=
+                "|" + std::to_string(this->getStoredFeatureValue(doc, fKey));
+        outStr += "\n";
+    }
+
     outStr += "\n";
+    return outStr;
+}
+
+void FeatureCollector::collectPresetFeatures()
+{
+    this->clearFeatureMaps();
+    this->featureKeys.clear();
+    this->pendingFeatures.clear();
+
+    FeaturePlan static const PRESET_PLAN(
+        FeatureCollector::getPresetFeatureKeys());
+
+    this->collectFeatures(PRESET_PLAN);
+}
+
+void FeatureCollector::reCollectFeatures()
+{
+    if (this->lazyEvaluation) return;  // Invalidated features stay pending
+
+    this->computePendingFeatures();
+}
+
+void FeatureCollector::invalidateFeatures(DependencyMask const dependencies)
+{
+    for (auto const & fKey : this->featureKeys)
+    {
+        if ((FeatureCollector::getDependencies(fKey) & dependencies) != 0)
+            this->pendingFeatures[fKey] = 0;
+    }
+}
+
+void FeatureCollector::invalidateFeatures(Dependency const dependency)
+{
+    this->invalidateFeatures(static_cast<DependencyMask>(dependency));
+}
+
+void FeatureCollector::collectFeatures(base::FeatureKey const & fKey)
+{
+    this->collectFeatures(FeaturePlan({fKey}));
+}
+
+void FeatureCollector::collectFeatures(
+    std::vector<base::FeatureKey> const & fKeyVect)
+{
+    this->collectFeatures(FeaturePlan(fKeyVect));
+}
+
+void FeatureCollector::collectFeatures(FeaturePlan const & plan)
+{
+    if (this->lazyEvaluation)
+    {
+        for (auto const & fKey : plan.getFeatureKeys())
+        {
+            if (std::find(
+                    this->featureKeys.begin(), this->featureKeys.end(),
+                    fKey) == this->featureKeys.end())
+                this->featureKeys.push_back(fKey);
+
+            this->pendingFeatures[fKey] = 0;
+        }
+    }
+    else
+    {
+        this->requestFeatures(plan);
+        this->computeFeatures(plan, 0);
+    }
+}
+
+std::vector<std::size_t> FeatureCollector::collectCascadeFeatures(
+    std::vector<base::FeatureKey> const & cheapKeys,
+    std::vector<base::FeatureKey> const & expensiveKeys,
+    CascadeScoreFunction const & scoreFunction, std::size_t const topN,
+    base::FValType const minScore)
+{
+    // Both stages are computed now, regardless of lazy evaluation
+    FeaturePlan const cheapPlan(cheapKeys);
+    this->requestFeatures(cheapPlan);
+    this->computeFeatures(cheapPlan, 0);
+
+    // Score every document from its cheap features
+    auto const & cheapKeyVect = cheapPlan.getFeatureKeys();
+    std::vector<base::FValType> cheapRow(cheapKeyVect.size());
+    std::vector<std::pair<base::FValType, std::size_t>> scoredDocs;
+    for (std::size_t docIdx = 0; docIdx < this->docVect.size(); ++docIdx)
+    {
+        for (std::size_t i = 0; i < cheapKeyVect.size(); ++i)
+            cheapRow[i] = this->getStoredFeatureValue(
+                this->docVect[docIdx], cheapKeyVect[i]);
+
+        base::FValType const score = scoreFunction(cheapRow);
+        if (score >= minScore) scoredDocs.emplace_back(score, docIdx);
+    }
+
+    // Keep the best `topN`, ties go to the first document
+    std::size_t const nSurvivors = std::min(topN, scoredDocs.size());
+    std::partial_sort(
+        scoredDocs.begin(),
+        scoredDocs.begin() + static_cast<std::ptrdiff_t>(nSurvivors),
+        scoredDocs.end(), [](auto const & a, auto const & b) {
+            return a.first > b.first ||
+                   (a.first == b.first && a.second < b.second);
+        });
+    scoredDocs.resize(nSurvivors);
+
+    std::vector<std::size_t> survivorVect;
+    survivorVect.reserve(nSurvivors);
+    this->prunedDocs.assign(this->docVect.size(), true);
+    for (auto const & scoredDoc : scoredDocs)
+    {
+        survivorVect.push_back(scoredDoc.second);
+        this->prunedDocs[scoredDoc.second] = false;
+    }
+
+    // Expensive features not already computed by the cheap stage
+    std::vector<base::FeatureKey> remainingKeys;
+    for (auto const & fKey : expensiveKeys)
+    {
+        if (std::find(cheapKeyVect.begin(), cheapKeyVect.end(), fKey) ==
+            cheapKeyVect.end())
+            remainingKeys.push_back(fKey);
+    }
+    FeaturePlan const expensivePlan(remainingKeys);
+    this->requestFeatures(expensivePlan);
+
+    // Zero the per-document expensive features of the pruned documents
+    auto const & expensiveKeyVect = expensivePlan.getFeatureKeys();
+    this->prunedKeys.clear();
+    for (std::size_t i = 0; i < expensiveKeyVect.size(); ++i)
+    {
+        if (!expensivePlan.isConstant(i))
+            this->prunedKeys.push_back(expensiveKeyVect[i]);
+    }
+    for (std::size_t docIdx = 0; docIdx < this->docVect.size(); ++docIdx)
+    {
+        if (!this->prunedDocs[docIdx]) continue;
+
+        for (auto const & fKey : this->prunedKeys)
+            this->docVect[docIdx].updateFeature(fKey, 0);
+    }
+
+    std::vector<std::size_t> survivorIdxVect = survivorVect;
+    std::sort(survivorIdxVect.begin(), survivorIdxVect.end());
+    this->computeFeatures(expensivePlan, survivorIdxVect);
+
+    return survivorVect;
+}
+
+void FeatureCollector::addDocs(
+    std::vector<base::StrStrMap> const & docTextMapVect)
+{
+    this->addTextDocs(docTextMapVect);
+}
+
+void FeatureCollector::addDocs(
+    std::vector<base::StrViewPairVector> const & docTextVect)
+{
+    this->addTextDocs(docTextVect);
+}
+
+void FeatureCollector::addDocs(
+    std::vector<base::StrSizeMap> const & docLenMapVect,
+    std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect)
+{
+    LOWLETORFEATS_TIME_SCOPE(
+        this->pipelineStats.stage(PipelineStats::Stage::addDocs));
+    TraceSpan const span = this->traceSpan("addDocs", "documents");
+
+    std::size_t const firstNewDocIdx = this->docVect.size();
+    this->queryTermCounts.assign(this->queryTfMap.size(), 0);
+
+    // Initialize every document, filtering with `queryTfMap`
+    this->docVect.reserve(firstNewDocIdx + docTfMapVect.size());
+    for (std::size_t docIdx = 0; docIdx < docTfMapVect.size();
+         ++docIdx)  // for each document
+    {
+        base::StrSizeMap const & docLenMap = docLenMapVect.at(docIdx);
+        base::StructuredFlatTermFrequencyMap strucDocTfMap(this->resource);
+        if (this->retainTermVectors)
+            this->docTermVects.emplace_back(this->resource);
+
+        // For each section, setup docTfMap for the document
+        for (auto const & [sectionKey, sectionTfMap] :
+             docTfMapVect.at(docIdx))  // for each section
+        {
+            if (this->retainTermVectors)
+                this->retainTerms(
+                    sectionTfMap, this->docTermVects.back()[sectionKey]);
+
+            // Filter for query tokens only
+            this->countQueryTerms(sectionTfMap);
+            this->flushQueryTermCounts(strucDocTfMap[sectionKey]);
+        }
+
+        this->addDoc(docLenMap, strucDocTfMap);
+    }
+
+    this->updateCollectionStats(firstNewDocIdx);
+}
+
+void FeatureCollector::addDocs(
+    InvertedIndex const & index, std::vector<base::DocId> const & docIdVect)
+{
+    std::vector<base::StrSizeMap> docLenMapVect(docIdVect.size());
+    std::vector<base::StructuredTermFrequencyMap> docTfMapVect(
+        docIdVect.size());
+    for (std::size_t docIdx = 0; docIdx < docIdVect.size(); ++docIdx)
+        index.getDocument(
+            docIdVect[docIdx], docLenMapVect[docIdx], docTfMapVect[docIdx]);
+
+    this->addDocs(docLenMapVect, docTfMapVect);
+}
+
+/* Getter methods */
+
+std::size_t FeatureCollector::getNumDocs() const { return this->numDocs; }
+
+std::size_t FeatureCollector::getNumFeatures() const
+{
+    if (this->docVect.size() > 0) return this->featureKeys.size();
+
+    return 0;
+}
+
+std::vector<base::FeatureKey> const & FeatureCollector::getFeatureKeys() const
+{
+    return this->featureKeys;
+}
+
+std::vector<StructuredDocument> const & FeatureCollector::getDocVect() const
+{
+    return this->docVect;
+}
+
+std::vector<std::vector<base::FValType>> const
+    FeatureCollector::getFeatureVects() const
+{
+    this->computePendingFeatures();
+    TraceSpan const span = this->traceSpan("getFeatureVects", "output");
+
+    std::vector<std::vector<base::FValType>> outVect;
+    outVect.reserve(this->numDocs);
+
+    for (std::size_t docIdx = 0; docIdx < this->docVect.size(); ++docIdx)
+        outVect.push_back(this->getFeatureVector(docIdx));
+
+    return outVect;
+}
+
+base::FeatureMap const & FeatureCollector::getConstantFeatureMap() const
+{
+    this->computePendingFeatures();
+
+    return this->constantFeatureMap;
+}
+
+base::FValType FeatureCollector::getFeatureValue(
+    std::size_t const docIdx, base::FeatureKey const & fKey)
+{
+    auto const & doc = this->docVect.at(docIdx);
+
+    auto const pendingIt = this->pendingFeatures.find(fKey);
+    if (pendingIt != this->pendingFeatures.end())
+    {
+        this->computeFeature(fKey, pendingIt->second);
+        this->pendingFeatures.erase(pendingIt);
+    }
+    else if (
+        std::find(this->featureKeys.begin(), this->featureKeys.end(), fKey) ==
+        this->featureKeys.end())
+    {
+        // Not requested yet, collect it now
+        this->featureKeys.push_back(fKey);
+        this->computeFeature(fKey, 0);
+    }
+
+    return this->getStoredFeatureValue(doc, fKey);
+}
+
+std::vector<base::FValType> FeatureCollector::getFeatureVector(
+    std::size_t const docIdx) const
+{
+    std::vector<base::FValType> outVect(this->featureKeys.size());
+    this->copyFeatureVector(docIdx, outVect.data());
+
+    return outVect;
+}
+
+void FeatureCollector::copyFeatureVector(
+    std::size_t const docIdx, base::FValType * out) const
+{
+    auto const & doc = this->docVect.at(docIdx);
+
+    this->computePendingFeatures();
+
+    // Features are stored in the requested order unless lazily computed
+    //  columns were inserted out of order, follow both maps and only look
+    //  up the keys found elsewhere
+    auto constIt = this->constantFeatureMap.begin();
+    auto const constEnd = this->constantFeatureMap.end();
+    auto docIt = doc.getFeatureMap().begin();
+    auto const docEnd = doc.getFeatureMap().end();
+    for (auto const & fKey : this->featureKeys)
+    {
+        if (constIt != constEnd && constIt->first == fKey)
+            *out++ = (constIt++)->second;
+        else if (docIt != docEnd && docIt->first == fKey)
+            *out++ = (docIt++)->second;
+        else
+            *out++ = this->getStoredFeatureValue(doc, fKey);
+    }
+}
+
+std::vector<base::FValType> FeatureCollector::getFeatureColumn(
+    base::FeatureKey const & fKey)
+{
+    std::vector<base::FValType> outVect;
+    outVect.reserve(this->numDocs);
+
+    for (std::size_t docIdx = 0; docIdx < this->docVect.size(); ++docIdx)
+        outVect.push_back(this->getFeatureValue(docIdx, fKey));
+
+    return outVect;
+}
+
+FeatureMatrix FeatureCollector::getFeatureMatrix()
+{
+    return FeatureMatrix(*this);
+}
+
+/* Setter methods */
+
+void FeatureCollector::setQuery(std::string const & queryText)
+{
+    this->assertRetainedTermVectors();
+
+    auto const queryFreqMap = textalyzer::asFrequencyMap(
+        this->analyzeText(queryText).first);
+    this->queryTfMap.clear();
+    this->queryTfMap.insert(queryFreqMap.begin(), queryFreqMap.end());
+
+    this->refilterDocs();
+}
+
+void FeatureCollector::setQuery(base::StrSizeMap const & queryTfMap)
+{
+    this->assertRetainedTermVectors();
+
+    this->queryTfMap.clear();
+    this->queryTfMap.insert(queryTfMap.begin(), queryTfMap.end());
+
+    this->refilterDocs();
+}
+
+void FeatureCollector::resetStats() { this->pipelineStats.clear(); }
+
+void FeatureCollector::setTrace(
+    TraceRecorder * const traceRecorder, std::string const & qid)
+{
+    this->traceRecorder = traceRecorder;
+    this->traceQid = qid;
+}
+
+void FeatureCollector::setRetainTermVectors(bool const retainTermVectors)
+{
+    if (retainTermVectors == this->retainTermVectors) return;
+
+    if (retainTermVectors && !this->docVect.empty())
+        throw std::runtime_error(
+            "Term vectors must be retained before adding documents");
+
+    this->retainTermVectors = retainTermVectors;
+    if (!retainTermVectors)
+    {
+        this->termIds.clear();
+        this->docTermVects.clear();
+        this->docTermVects.shrink_to_fit();
+    }
+}
+
+void FeatureCollector::setSectionWeights(
+    std::unordered_map<std::string, base::WeightType> const & sectionWeights)
+{
+    this->sectionWeights = sectionWeights;
+    this->invalidateFeatures(Dependency::sectionWeights);
+}
+
+void FeatureCollector::setLMIRParameters(
+    float const lamb, ushort const mu, float const delta)
+{
+    this->lmirLamb = lamb;
+    this->lmirMu = mu;
+    this->lmirDelta = delta;
+
+    for (auto & [sectionKey, lime] : this->lmirCalculators)
+    {
+        lime.lamb = lamb;
+        lime.mu = mu;
+        lime.delta = delta;
+    }
+
+    this->invalidateFeatures(Dependency::lmirParameters);
+}
+
+/* Static getter methods */
+
+bool FeatureCollector::isConstantFeature(base::FeatureKey const & fKey)
+{
+    return FeaturePlan({fKey}).isConstant(0);
+}
+
+FeatureCollector::DependencyMask FeatureCollector::getDependencies(
+    base::FeatureKey const & fKey)
+{
+    // QOL typedefs
+    typedef base::FeatureKey::ValidTypes VTypes;
+    typedef base::FeatureKey::ValidNames VNames;
+
+    DependencyMask const documents =
+        static_cast<DependencyMask>(Dependency::documents);
+    DependencyMask const query =
+        static_cast<DependencyMask>(Dependency::query);
+    DependencyMask const sectionStats =
+        static_cast<DependencyMask>(Dependency::sectionStats);
+
+    // Document term frequencies are filtered by the query
+    DependencyMask const filteredDocuments = documents | query;
+
+    switch (fKey.getVType())
+    {
+        case VTypes::other:
+            return documents;
+
+        case VTypes::tfidf:
+        {
+            switch (fKey.getVName())
+            {
+                case VNames::tflognorm:
+                case VNames::tfdoublenorm:
+                    return filteredDocuments;
+                case VNames::idfmax:
+                case VNames::tfidf:
+                    return filteredDocuments | sectionStats;
+                default:  // Collection wide idf
+                    return sectionStats;
+            }
+        }
+
+        case VTypes::okapi:
+        {
+            switch (fKey.getVName())
+            {
+                case VNames::bm25f:
+                case VNames::bm25fplus:
+                    return filteredDocuments | sectionStats |
+                           static_cast<DependencyMask>(
+                               Dependency::sectionWeights);
+                default:
+                    return filteredDocuments | sectionStats;
+            }
+        }
 
-    // Per document features
-    for (auto const & doc : this->docVect)
-    {
-        auto const & fMap = doc.getFeatureMap();
+        case VTypes::lmir:
+            return filteredDocuments | sectionStats |
+                   static_cast<DependencyMask>(Dependency::lmirParameters);
 
-        for (auto const & fKey : featKeys)
-            outStr += "|" + std::to_string(fMap.at(fKey));
-        outStr += "\n";
+        default:
+            return static_cast<DependencyMask>(Dependency::all);
     }
-
-    outStr += "\n";
-    return outStr;
 }
 
-void FeatureCollector::collectPresetFeatures()
+std::vector<base::FeatureKey> const &
+    FeatureCollector::getPresetFeatureKeys()
 {
-    this->clearFeatureMaps();
-
     std::vector<base::FeatureKey> static const PRESET_FEATURES = {
         base::FeatureKey("tfidf", "tfdoublenorm", "body"),
         base::FeatureKey("tfidf", "tfdoublenorm", "anchor"),
@@ -163,499 +791,383 @@ void FeatureCollector::collectPresetFeatures()
         base::FeatureKey("lmir", "jm", "url"),
         base::FeatureKey("lmir", "jm", "full")};
 
-    this->collectFeatures(PRESET_FEATURES);
+    return PRESET_FEATURES;
 }
 
-void FeatureCollector::reCollectFeatures()
-{
-    try
-    {
-        // Get vector of keys
-        std::vector<base::FeatureKey> keyVect =
-            this->docVect.at(0).getFeatureKeys();
+/* Private static member variables */
 
-        if (keyVect.size() <= 0) return;  // No features to collect
+textalyzer::AnlyzerFunType<std::string> FeatureCollector::analyzerFun =
+    textalyzer::Analyzer::medAnalyze;
+
+uint8_t const FeatureCollector::DEFAULT_NGRAMS = 2;
 
-        // Clear all feature maps
-        this->clearFeatureMaps();
+/* Private class methods */
 
-        // Collect featuers from key vector
-        this->collectFeatures(keyVect);
+template <class Other>
+void FeatureCollector::assignState(Other && other)
+{
+    bool constexpr isMove = !std::is_reference_v<Other>;
+
+    // Maps allocated from a memory resource keep it on assignment, copying
+    //  the entries of a map allocated from another one
+    this->sectionWeights = std::forward<Other>(other).sectionWeights;
+    this->queryTfMap = std::forward<Other>(other).queryTfMap;
+    this->queryTermCounts = std::forward<Other>(other).queryTermCounts;
+    this->numDocs = other.numDocs;
+    this->sectionKeys = std::forward<Other>(other).sectionKeys;
+    this->docLenSumPerSection =
+        std::forward<Other>(other).docLenSumPerSection;
+    this->avgDocLenPerSection =
+        std::forward<Other>(other).avgDocLenPerSection;
+    this->tfMapPerSection = std::forward<Other>(other).tfMapPerSection;
+    this->nDocsWithTermPerSection =
+        std::forward<Other>(other).nDocsWithTermPerSection;
+    this->nTermsPerSection = std::forward<Other>(other).nTermsPerSection;
+    this->lmirCalculators = std::forward<Other>(other).lmirCalculators;
+    this->lmirLamb = other.lmirLamb;
+    this->lmirMu = other.lmirMu;
+    this->lmirDelta = other.lmirDelta;
+    this->featureKeys = std::forward<Other>(other).featureKeys;
+    this->pendingFeatures = std::forward<Other>(other).pendingFeatures;
+    this->constantFeatureMap = std::forward<Other>(other).constantFeatureMap;
+    this->prunedDocs = std::forward<Other>(other).prunedDocs;
+    this->prunedKeys = std::forward<Other>(other).prunedKeys;
+    this->lazyEvaluation = other.lazyEvaluation;
+    this->retainTermVectors = other.retainTermVectors;
+    this->termIds = std::forward<Other>(other).termIds;
+    this->pipelineStats = std::forward<Other>(other).pipelineStats;
+    this->traceRecorder = other.traceRecorder;
+    this->traceQid = std::forward<Other>(other).traceQid;
+
+    // Documents are allocated from the resource of their collector
+    if constexpr (isMove)
+    {
+        this->docVect = std::move(other.docVect);
+        this->docTermVects = std::move(other.docTermVects);
     }
-    catch (std::out_of_range const & e)  // docVect.size() == 0
+    else
     {
-    }  // Do nothing (no features to collect)
+        this->docVect.clear();
+        this->docVect.reserve(other.docVect.size());
+        for (auto const & doc : other.docVect)
+            this->docVect.emplace_back(doc, this->resource);
+
+        this->docTermVects.clear();
+        this->docTermVects.reserve(other.docTermVects.size());
+        for (auto const & docTermVect : other.docTermVects)
+            this->docTermVects.emplace_back(docTermVect, this->resource);
+    }
 }
 
-void FeatureCollector::collectFeatures(base::FeatureKey const & fKey)
+void FeatureCollector::constructLMIR(std::string const & sectionKey) const
 {
-    // QOL typedefs
-    typedef base::FeatureKey::ValidTypes VTypes;
-    typedef base::FeatureKey::ValidNames VNames;
-
-    std::string const & fSection = fKey.getFSection();
-    // Handle non-existent section
-    if (this->sectionKeys.count(fSection) == 0)
-    {
-        // throw std::out_of_range("Invalid section key '" + fSection + "'");
-        for (auto & doc : this->docVect) doc.updateFeature(fKey, 0);
+    if (this->lmirCalculators.count(sectionKey) != 0)  // Already constructed
         return;
-    }
 
-    switch (fKey.getVType())
-    {
-        case VTypes::other:
-        {
-            switch (fKey.getVName())
-            {
-                case VNames::dl:
-                {
-                    for (auto & doc : this->docVect)
-                        doc.updateFeature(
-                            fKey, static_cast<base::FValType>(
-                                      doc.getDocLen(fSection)));
-                    break;
-                }
+    LOWLETORFEATS_TIME_SCOPE(
+        this->pipelineStats.stage(PipelineStats::Stage::constructLMIR));
+    TraceSpan const span = this->traceSpan("constructLMIR", "stats");
 
-                default:
-                    FeatureCollector::throwUnsupportedFeatureName(
-                        fKey.getFName());
-                    break;
-            }
-            break;
-        }
+    // Else construct
+    LMIR & lime = this->lmirCalculators[sectionKey] =
+        LMIR(this->tfMapPerSection.at(sectionKey));
+    lime.lamb = this->lmirLamb;
+    lime.mu = this->lmirMu;
+    lime.delta = this->lmirDelta;
+}
 
-        case VTypes::tfidf:
-        {
-            auto const & totalTerms = this->nTermsPerSection.at(fSection);
+TraceSpan FeatureCollector::traceSpan(
+    std::string_view const name, std::string_view const category) const
+{
+    return TraceSpan(this->traceRecorder, name, category, this->traceQid);
+}
 
-            switch (fKey.getVName())
-            {
-                case VNames::tflognorm:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & tfMap = doc.getTermFrequencyMap(fSection);
+std::pair<std::vector<std::string>, std::size_t>
+    FeatureCollector::analyzeText(std::string const & text)
+{
+    LOWLETORFEATS_TIME_SCOPE(
+        this->pipelineStats.stage(PipelineStats::Stage::analyzeText));
+    TraceSpan const span = this->traceSpan("analyzeText", "analysis");
 
-                        base::FValType const fVal = Tfidf::sumTfLogNorm(tfMap);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+    return FeatureCollector::analyzerFun(
+        text, FeatureCollector::DEFAULT_NGRAMS);
+}
 
-                case VNames::tfdoublenorm:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & tfMap = doc.getTermFrequencyMap(fSection);
-
-                        base::FValType const fVal =
-                            Tfidf::sumTfDoubleNorm(tfMap, doc.getMaxTF());
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
-
-                case VNames::idfdefault:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        base::FValType const fVal =
-                            Tfidf::idfDefault(this->numDocs, totalTerms);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
-
-                case VNames::idfsmooth:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        base::FValType const fVal =
-                            Tfidf::idfSmooth(this->numDocs, totalTerms);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+std::pair<std::vector<std::string>, std::size_t>
+    FeatureCollector::analyzeText(std::string_view const text)
+{
+    this->textScratch.assign(text);
+    return this->analyzeText(this->textScratch);
+}
 
-                case VNames::idfmax:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        base::FValType const fVal =
-                            Tfidf::idfMax(totalTerms, doc.getMaxTF());
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
-
-                case VNames::idfprob:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        base::FValType const fVal =
-                            Tfidf::idfProb(this->numDocs, totalTerms);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
-
-                case VNames::idfnorm:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        base::FValType const fVal =
-                            Tfidf::idfNorm(this->numDocs, totalTerms);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+template <class DocText>
+void FeatureCollector::addTextDocs(std::vector<DocText> const & docTextVect)
+{
+    LOWLETORFEATS_TIME_SCOPE(
+        this->pipelineStats.stage(PipelineStats::Stage::addDocs));
+    TraceSpan const span = this->traceSpan("addDocs", "documents");
 
-                case VNames::tfidf:
-                {
-                    base::StrSizeMap const & docsWithTermMap =
-                        this->nDocsWithTermPerSection.at(fSection);
-
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & tfMap = doc.getTermFrequencyMap(fSection);
-
-                        base::FValType const fVal = Tfidf::queryTfidf(
-                            tfMap, doc.getMaxTF(), this->numDocs,
-                            docsWithTermMap, this->queryTfMap);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+    std::size_t const firstNewDocIdx = this->docVect.size();
+    this->queryTermCounts.assign(this->queryTfMap.size(), 0);
 
-                default:
-                    FeatureCollector::throwUnsupportedFeatureName(
-                        fKey.getFName());
-                    break;
-            }
-            break;
-        }
+    // Initialize every document, filtering with `queryTfMap`
+    this->docVect.reserve(firstNewDocIdx + docTextVect.size());
+    for (auto const & docText : docTextVect)  // for each document
+    {
+        base::StrSizeMap docLenMap(this->resource);
+        base::StructuredFlatTermFrequencyMap structDocTfMap(this->resource);
+        if (this->retainTermVectors)
+            this->docTermVects.emplace_back(this->resource);
 
-        case VTypes::okapi:
+        // For each section
+        for (auto const & [sectionKeyView, sectionText] : docText)
         {
-            base::StrSizeMap const & docsWithTermMap =
-                this->nDocsWithTermPerSection.at(fSection);
-            auto const & avgDocLen = this->avgDocLenPerSection.at(fSection);
-
-            switch (fKey.getVName())
-            {
-                case VNames::invalid:
-                    break;  // do nothing
-                case VNames::bm25:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & tfMap = doc.getTermFrequencyMap(fSection);
-
-                        base::FValType const fVal = Okapi::queryBm25(
-                            tfMap, this->numDocs, docsWithTermMap, avgDocLen,
-                            this->queryTfMap);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
-
-                case VNames::bm25plus:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & tfMap = doc.getTermFrequencyMap(fSection);
-
-                        base::FValType const fVal = Okapi::queryBm25plus(
-                            tfMap, this->numDocs, docsWithTermMap, avgDocLen,
-                            this->queryTfMap);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+            auto const & sectionKey = toSectionKey(sectionKeyView);
 
-                case VNames::bm25f:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        base::FValType const fVal = Okapi::queryBm25f(
-                            doc.getStructuredTermFrequencyMap(), this->numDocs,
-                            this->nDocsWithTermPerSection,
-                            this->avgDocLenPerSection, this->queryTfMap,
-                            this->sectionWeights);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+            // Analyze text for this document
+            auto const & pair = this->analyzeText(sectionText);
+            docLenMap[sectionKey] = pair.second;
 
-                case VNames::bm25fplus:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        base::FValType const fVal = Okapi::queryBm25fplus(
-                            doc.getStructuredTermFrequencyMap(), this->numDocs,
-                            this->nDocsWithTermPerSection,
-                            this->avgDocLenPerSection, this->queryTfMap,
-                            this->sectionWeights);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+            if (this->retainTermVectors)
+                this->retainTerms(
+                    pair.first, this->docTermVects.back()[sectionKey]);
 
-                default:
-                    FeatureCollector::throwUnsupportedFeatureName(
-                        fKey.getFName());
-                    break;
-            }
-            break;
+            // Filter for query tokens only and add to `structDocTfMap`
+            this->countQueryTerms(pair.first);
+            this->flushQueryTermCounts(structDocTfMap[sectionKey]);
         }
 
-        case VTypes::lmir:
-        {
-            this->constructLMIR(fSection);
-            auto const & lime = this->lmirCalculators.at(fSection);
+        this->addDoc(docLenMap, structDocTfMap);
+    }
 
-            switch (fKey.getVName())
-            {
-                case VNames::abs:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & docTfMap =
-                            doc.getTermFrequencyMap(fSection);
-                        auto const & docLen = doc.getDocLen();
-
-                        base::FValType const fVal = lime.absolute_discount(
-                            docTfMap, docLen, this->queryTfMap);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
-
-                case VNames::dir:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & docTfMap =
-                            doc.getTermFrequencyMap(fSection);
-                        auto const & docLen = doc.getDocLen();
-
-                        base::FValType const fVal =
-                            lime.dirichlet(docTfMap, docLen, this->queryTfMap);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
-
-                case VNames::jm:
-                {
-                    for (auto & doc : this->docVect)
-                    {
-                        auto const & docTfMap =
-                            doc.getTermFrequencyMap(fSection);
-                        auto const & docLen = doc.getDocLen();
-
-                        base::FValType const fVal = lime.jelinek_mercer(
-                            docTfMap, docLen, this->queryTfMap);
-                        doc.updateFeature(fKey, fVal);
-                    }
-                    break;
-                }
+    this->updateCollectionStats(firstNewDocIdx);
+}
 
-                default:
-                    FeatureCollector::throwUnsupportedFeatureName(
-                        fKey.getFName());
-                    break;
-            }
-            break;
-        }
+void FeatureCollector::addDoc(StructuredDocument const & newDoc)
+{
+    // Add the new document, copied into the collector's memory resource
+    auto const & doc = this->docVect.emplace_back(newDoc, this->resource);
 
-        default:
-            FeatureCollector::throwUnsupportedFeatureType(fKey.getFName());
-            break;
+    // For each section,
+    //  setup `nDocsWithTermPerSection` and `docLenSumPerSection`
+    for (auto const & [sectionKey, sectionTfMap] :
+         doc.getStructuredTermFrequencyMap())
+    {
+        this->docLenSumPerSection[sectionKey] += doc.getDocLen(sectionKey);
+        this->initNDocsWithTermPerSection(sectionKey, sectionTfMap);
     }
 }
 
-void FeatureCollector::collectFeatures(
-    std::vector<base::FeatureKey> const & fKeyVect)
+void FeatureCollector::addDoc(
+    base::StrSizeMap const & docLenMap,
+    base::StructuredFlatTermFrequencyMap const & strucDocTfMap)
 {
-    for (auto const & fKey : fKeyVect) this->collectFeatures(fKey);
-}
-
-/* Getter methods */
-
-std::size_t FeatureCollector::getNumDocs() const { return this->numDocs; }
+    // Create a new document, ensures `full` sectionKey
+    auto const & newDoc =
+        this->docVect.emplace_back(docLenMap, strucDocTfMap, this->resource);
 
-std::size_t FeatureCollector::getNumFeatures() const
-{
-    if (this->docVect.size() > 0)
+    // For each section,
+    //  setup `nDocsWithTermPerSection` and `docLenSumPerSection`
+    for (auto const & [sectionKey, sectionTfMap] :
+         newDoc.getStructuredTermFrequencyMap())
     {
-        auto doc = *docVect.begin();
-        return doc.getFeatureMap().size();
+        this->docLenSumPerSection[sectionKey] += newDoc.getDocLen(sectionKey);
+        this->initNDocsWithTermPerSection(sectionKey, sectionTfMap);
     }
-    return 0;
 }
 
-std::vector<StructuredDocument> const & FeatureCollector::getDocVect() const
+void FeatureCollector::updateCollectionStats(std::size_t const firstNewDocIdx)
 {
-    return this->docVect;
-}
+    if (firstNewDocIdx == this->docVect.size()) return;  // Nothing added
 
-std::vector<std::vector<base::FValType>> const
-    FeatureCollector::getFeatureVects() const
-{
-    std::vector<std::vector<base::FValType>> outVect;
-    outVect.reserve(this->numDocs);
+    std::size_t const numSections = this->sectionKeys.size();
 
-    for (auto const & doc : this->docVect)
-        outVect.push_back(doc.getFeatureVector());
+    {
+        LOWLETORFEATS_TIME_SCOPE(
+            this->pipelineStats.stage(PipelineStats::Stage::collectionStats));
+        TraceSpan const span = this->traceSpan("collectionStats", "stats");
 
-    return outVect;
-}
+        // Number of documents
+        this->numDocs = this->docVect.size();
+        this->prunedDocs.resize(this->numDocs, false);
 
-/* Private static member variables */
+        // Calculate avgDocLengths
+        for (auto const & [sectionKey, sectionValue] :
+             this->docLenSumPerSection)
+            this->avgDocLenPerSection[sectionKey] =
+                static_cast<float>(sectionValue) /
+                static_cast<float>(this->numDocs);
 
-textalyzer::AnlyzerFunType<std::string> FeatureCollector::analyzerFun =
-    textalyzer::Analyzer::medAnalyze;
+        // Total collection terms for each section
+        this->initNTermsPerSection();
 
-uint8_t const FeatureCollector::DEFAULT_NGRAMS = 2;
+        // The collection term frequencies changed
+        this->lmirCalculators.clear();
 
-/* Private class methods */
+        // Ensure everything was done right
+        this->assertProperties();
+    }
 
-void FeatureCollector::constructLMIR(std::string const & sectionKey)
-{
-    if (this->lmirCalculators.count(sectionKey) != 0)  // Already constructed
-        return;
+    // Existing documents only need the features using collection statistics,
+    //  features of a new section were zero for every document
+    if (this->sectionKeys.size() != numSections)
+        this->invalidateFeatures(Dependency::all);
+    else
+        this->invalidateFeatures(Dependency::sectionStats);
 
-    // Else construct
-    this->lmirCalculators[sectionKey] =
-        LMIR(this->tfMapPerSection.at(sectionKey));
+    // New documents need every feature
+    for (auto const & fKey : this->featureKeys)
+        this->pendingFeatures.emplace(fKey, firstNewDocIdx);
+
+    if (!this->lazyEvaluation) this->computePendingFeatures();
 }
 
-void FeatureCollector::addDoc(StructuredDocument const & newDoc)
+void FeatureCollector::countQueryTerms(
+    std::vector<std::string> const & tokenVect)
 {
-    // For each section,
-    //  setup `nDocsWithTermPerSection` and `avgDocLenPerSection`
-    for (auto const & [sectionKey, sectionTfMap] :
-         newDoc.getStructuredTermFrequencyMap())
+    std::size_t const numQueryTerms = this->queryTfMap.size();
+
+    for (auto const & token : tokenVect)
     {
-        this->avgDocLenPerSection[sectionKey] +=
-            static_cast<float>(newDoc.getDocLen(sectionKey));
-        this->initNDocsWithTermPerSection(sectionKey, sectionTfMap);
+        std::size_t const termIdx = utils::findSortedIndex(
+            this->queryTfMap.begin(), this->queryTfMap.end(), token,
+            utils::KeyLess());
+        if (termIdx != numQueryTerms) ++this->queryTermCounts[termIdx];
     }
+}
 
-    // Add the new document
-    this->docVect.push_back(newDoc);
+void FeatureCollector::countQueryTerms(base::StrSizeMap const & sectionTfMap)
+{
+    std::size_t termIdx = 0;
+    for (auto const & [queryTerm, queryTermFreq] : this->queryTfMap)
+    {
+        auto const it = sectionTfMap.find(queryTerm);
+        if (it != sectionTfMap.end())
+            this->queryTermCounts[termIdx] += it->second;
+
+        ++termIdx;
+    }
 }
 
-void FeatureCollector::addDoc(
-    base::StrSizeMap const & docLenMap,
-    base::StructuredTermFrequencyMap const & strucDocTfMap)
+void FeatureCollector::retainTerms(
+    std::vector<std::string> const & tokenVect,
+    base::TermCountVector & termVect)
 {
-    // Create a new document, ensures `full` sectionKey
-    StructuredDocument newDoc(docLenMap, strucDocTfMap);
+    this->termIdScratch.clear();
+    for (auto const & token : tokenVect)
+        this->termIdScratch.push_back(this->internTerm(token));
+    std::sort(this->termIdScratch.begin(), this->termIdScratch.end());
 
-    // For each section,
-    //  setup `nDocsWithTermPerSection` and `avgDocLenPerSection`
-    for (auto const & [sectionKey, sectionTfMap] :
-         newDoc.getStructuredTermFrequencyMap())
+    // Count the runs of equal ids
+    for (auto const termId : this->termIdScratch)
     {
-        this->avgDocLenPerSection[sectionKey] +=
-            static_cast<float>(newDoc.getDocLen(sectionKey));
-        this->initNDocsWithTermPerSection(sectionKey, sectionTfMap);
+        if (!termVect.empty() && termVect.back().first == termId)
+            ++termVect.back().second;
+        else
+            termVect.emplace_back(termId, 1);
     }
+}
 
-    // Add the new document
-    this->docVect.push_back(newDoc);
+void FeatureCollector::retainTerms(
+    base::StrSizeMap const & sectionTfMap, base::TermCountVector & termVect)
+{
+    termVect.reserve(sectionTfMap.size());
+    for (auto const & [term, termFreq] : sectionTfMap)
+        termVect.emplace_back(this->internTerm(term), termFreq);
+    std::sort(termVect.begin(), termVect.end());
 }
 
-void FeatureCollector::initDocs(
-    std::vector<base::StrStrMap> const & docTextMapVect)
+base::TermId FeatureCollector::internTerm(std::string const & term)
 {
-    // Number of documents
-    this->numDocs = docTextMapVect.size();
+    auto const nextId = static_cast<base::TermId>(this->termIds.size());
+    return this->termIds.try_emplace(term, nextId).first->second;
+}
 
-    // Initialize every document, filtering with `queryTfMap`
-    this->docVect.reserve(this->numDocs);
-    for (auto const & docTextMap : docTextMapVect)  // for each document
+void FeatureCollector::refilterDocs()
+{
+    this->queryTermCounts.assign(this->queryTfMap.size(), 0);
+
+    // Ids of the known query terms, sorted, with their index in `queryTfMap`
+    std::vector<std::pair<base::TermId, std::size_t>> queryTermIds;
+    queryTermIds.reserve(this->queryTfMap.size());
+    std::size_t termIdx = 0;
+    for (auto const & [queryTerm, queryTermFreq] : this->queryTfMap)
     {
-        base::StrSizeMap docLenMap;
-        base::StructuredTermFrequencyMap structDocTfMap;
+        auto const it = this->termIds.find(queryTerm);
+        if (it != this->termIds.end())
+            queryTermIds.emplace_back(it->second, termIdx);
+        ++termIdx;
+    }
+    std::sort(queryTermIds.begin(), queryTermIds.end());
 
-        // For each section
-        for (auto const & [sectionKey, sectionText] : docTextMap)
+    std::vector<std::size_t> queryIdxVect(queryTermIds.size());
+    std::vector<std::size_t> docIdxVect(queryTermIds.size());
+
+    // Reset the query dependent collection statistics
+    this->tfMapPerSection.clear();
+    this->nDocsWithTermPerSection.clear();
+    this->nTermsPerSection.clear();
+    this->lmirCalculators.clear();
+
+    for (std::size_t docIdx = 0; docIdx < this->docVect.size(); ++docIdx)
+    {
+        base::StructuredFlatTermFrequencyMap strucDocTfMap(this->resource);
+
+        for (auto const & [sectionKey, termVect] : this->docTermVects[docIdx])
         {
-            // Analyze text for this document
-            base::StrSizeMap sectionTfMap;
-            auto const & pair = FeatureCollector::analyzerFun(
-                sectionText, FeatureCollector::DEFAULT_NGRAMS);
-            sectionTfMap = textalyzer::asFrequencyMap(pair.first);
-            docLenMap[sectionKey] = pair.second;
+            std::size_t const nMatches = utils::getSortedIntersection(
+                queryTermIds.begin(), queryTermIds.end(), termVect.begin(),
+                termVect.end(), queryIdxVect.data(), docIdxVect.data());
 
-            // Filter for query tokens only
-            sectionTfMap =
-                utils::getIntersection(sectionTfMap, this->queryTfMap);
+            for (std::size_t i = 0; i < nMatches; ++i)
+                this->queryTermCounts[queryTermIds[queryIdxVect[i]].second] =
+                    termVect[docIdxVect[i]].second;
 
-            // Add to `structDocTfMap`
-            structDocTfMap[sectionKey] = sectionTfMap;
+            this->flushQueryTermCounts(strucDocTfMap[sectionKey]);
         }
 
-        this->addDoc(docLenMap, structDocTfMap);
-    }
+        auto & doc = this->docVect[docIdx];
+        doc.setStructuredTermFrequencyMap(std::move(strucDocTfMap));
 
-    // Calculate avgDocLengths
-    for (auto const & [sectionKey, sectionValue] : this->avgDocLenPerSection)
-        this->avgDocLenPerSection.at(sectionKey) =
-            sectionValue / static_cast<float>(this->numDocs);
+        for (auto const & [sectionKey, sectionTfMap] :
+             doc.getStructuredTermFrequencyMap())
+            this->initNDocsWithTermPerSection(sectionKey, sectionTfMap);
+    }
 
     this->initNTermsPerSection();
-
-    // Ensure everything was done right
     this->assertProperties();
+
+    this->invalidateFeatures(
+        static_cast<DependencyMask>(Dependency::query) |
+        static_cast<DependencyMask>(Dependency::sectionStats));
+    if (!this->lazyEvaluation) this->computePendingFeatures();
 }
 
-void FeatureCollector::initDocs(
-    std::vector<base::StrSizeMap> const & docLenMapVect,
-    std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect)
+void FeatureCollector::assertRetainedTermVectors() const
 {
-    // Set the number of documents
-    this->numDocs = docTfMapVect.size();
+    if (this->docTermVects.size() != this->docVect.size())
+        throw std::runtime_error(
+            "setQuery requires the term vectors of every document, enable "
+            "setRetainTermVectors before adding documents");
+}
 
-    // Initialize every document, filtering with `queryTfMap`
-    this->docVect.reserve(this->numDocs);
-    for (std::size_t docIdx = 0; docIdx < this->numDocs;
-         ++docIdx)  // for each document
+void FeatureCollector::flushQueryTermCounts(
+    base::FlatStrSizeMap & sectionTfMap)
+{
+    // `queryTfMap` is sorted, so every insert is an append
+    std::size_t termIdx = 0;
+    for (auto const & [queryTerm, queryTermFreq] : this->queryTfMap)
     {
-        base::StrSizeMap const & docLenMap = docLenMapVect.at(docIdx);
-        base::StructuredTermFrequencyMap strucDocTfMap =
-            docTfMapVect.at(docIdx);
+        std::size_t & termCount = this->queryTermCounts[termIdx++];
+        if (termCount == 0) continue;
 
-        // For each section, setup docTfMap for the document
-        for (auto const & [sectionKey, sectionTfMap] :
-             strucDocTfMap)  // for each section
-        {
-            // Filter for query tokens only
-            strucDocTfMap.at(sectionKey) =
-                utils::getIntersection(sectionTfMap, queryTfMap);
-        }
-
-        this->addDoc(docLenMap, strucDocTfMap);
+        sectionTfMap.insert({queryTerm, termCount});
+        termCount = 0;
     }
-
-    // Calculate avgDocLengths
-    for (auto const & [sectionKey, sectionValue] : this->avgDocLenPerSection)
-        this->avgDocLenPerSection.at(sectionKey) =
-            sectionValue / static_cast<float>(this->numDocs);
-
-    // Total collection terms for each section
-    this->initNTermsPerSection();
-
-    // Ensure everything was done right
-    this->assertProperties();
 }
 
 void FeatureCollector::initNDocsWithTermPerSection(
-    std::string const & sectionKey, base::StrSizeMap const & sectionTfMap)
+    std::string const & sectionKey, base::FlatStrSizeMap const & sectionTfMap)
 {
     // Create the sectionKey key
     if (this->nDocsWithTermPerSection.count(sectionKey) == 0)
@@ -689,9 +1201,159 @@ void FeatureCollector::initNTermsPerSection()
 
 void FeatureCollector::initFullFromOthers() {}
 
+void FeatureCollector::computeFeature(
+    base::FeatureKey const & fKey, std::size_t const firstDocIdx) const
+{
+    this->computeFeatures(FeaturePlan({fKey}), firstDocIdx);
+}
+
+void FeatureCollector::requestFeatures(FeaturePlan const & plan)
+{
+    for (auto const & fKey : plan.getFeatureKeys())
+    {
+        if (std::find(
+                this->featureKeys.begin(), this->featureKeys.end(), fKey) ==
+            this->featureKeys.end())
+            this->featureKeys.push_back(fKey);
+
+        this->pendingFeatures.erase(fKey);
+    }
+}
+
+void FeatureCollector::computeFeatures(
+    FeaturePlan const & plan, std::size_t const firstDocIdx) const
+{
+    if (firstDocIdx >= this->docVect.size()) return;
+
+    std::vector<std::size_t> docIdxVect(this->docVect.size() - firstDocIdx);
+    std::iota(docIdxVect.begin(), docIdxVect.end(), firstDocIdx);
+    this->computeFeatures(plan, docIdxVect);
+
+    // Pruned documents now hold these features, the cascade is undone once
+    //  they hold every expensive feature
+    if (firstDocIdx == 0 && !this->prunedKeys.empty())
+    {
+        for (auto const & fKey : plan.getFeatureKeys())
+            this->prunedKeys.erase(
+                std::remove(
+                    this->prunedKeys.begin(), this->prunedKeys.end(), fKey),
+                this->prunedKeys.end());
+
+        if (this->prunedKeys.empty())
+            this->prunedDocs.assign(this->docVect.size(), false);
+    }
+}
+
+void FeatureCollector::computeFeatures(
+    FeaturePlan const & plan,
+    std::vector<std::size_t> const & docIdxVect) const
+{
+    if (plan.empty() || this->docVect.empty()) return;
+
+    // Trace every feature family in its own span. The features of a plan
+    //  do not depend on each other, so splitting it keeps their values.
+    if (this->traceRecorder != nullptr)
+    {
+        std::map<std::string, std::vector<base::FeatureKey>> familyKeysMap;
+        for (auto const & fKey : plan.getFeatureKeys())
+            familyKeysMap[fKey.getFType()].push_back(fKey);
+
+        if (familyKeysMap.size() > 1)
+        {
+            for (auto const & mapPair : familyKeysMap)
+                this->computeFeatures(FeaturePlan(mapPair.second), docIdxVect);
+            return;
+        }
+    }
+
+    LOWLETORFEATS_TIME_SCOPE(
+        this->pipelineStats.stage(PipelineStats::Stage::computeFeatures));
+    TraceSpan const span = this->traceSpan(
+        plan.getFeatureKeys().front().getFType(), "features");
+
+    for (auto const & sectionKey : plan.getLMIRSections())
+    {
+        if (this->sectionKeys.count(sectionKey) != 0)
+            this->constructLMIR(sectionKey);
+    }
+
+    CollectionStatsView stats;
+    stats.numDocs = this->numDocs;
+    stats.queryTfMap = &this->queryTfMap;
+    stats.nDocsWithTermPerSection = &this->nDocsWithTermPerSection;
+    stats.avgDocLenPerSection = &this->avgDocLenPerSection;
+    stats.nTermsPerSection = &this->nTermsPerSection;
+    stats.sectionWeights = &this->sectionWeights;
+    stats.lmirCalculators = &this->lmirCalculators;
+
+    FeaturePlan::Context ctx;
+    {
+        LOWLETORFEATS_TIME_SCOPE(
+            this->pipelineStats.stage(PipelineStats::Stage::bindPlan));
+        TraceSpan const span = this->traceSpan("bindPlan", "stats");
+        ctx = plan.bind(stats);
+    }
+
+    // Store query-level constants once, for every document
+    auto const & fKeyVect = plan.getFeatureKeys();
+    std::vector<std::size_t> docFeatureIdxs;
+    for (std::size_t i = 0; i < fKeyVect.size(); ++i)
+    {
+        if (plan.isConstant(i))
+            this->constantFeatureMap[fKeyVect[i]] =
+                plan.getConstantValue(ctx, i);
+        else
+            docFeatureIdxs.push_back(i);
+    }
+    if (docFeatureIdxs.empty()) return;
+
+    std::vector<base::FValType> fValVect(fKeyVect.size());
+
+    for (auto const docIdx : docIdxVect)
+    {
+        StructuredDocument & doc = this->docVect[docIdx];
+        plan.evaluate(ctx, doc, fValVect.data());
+
+        for (auto const i : docFeatureIdxs)
+            doc.updateFeature(fKeyVect[i], fValVect[i]);
+    }
+
+    plan.addTimings(ctx, this->pipelineStats);
+}
+
+void FeatureCollector::computePendingFeatures() const
+{
+    if (this->pendingFeatures.empty()) return;
+
+    // Plan the features pending from the same document together
+    std::map<std::size_t, std::vector<base::FeatureKey>> pendingKeysPerDoc;
+    for (auto const & fKey : this->featureKeys)
+    {
+        auto const pendingIt = this->pendingFeatures.find(fKey);
+        if (pendingIt != this->pendingFeatures.end())
+            pendingKeysPerDoc[pendingIt->second].push_back(fKey);
+    }
+    this->pendingFeatures.clear();
+
+    for (auto const & [firstDocIdx, fKeyVect] : pendingKeysPerDoc)
+        this->computeFeatures(FeaturePlan(fKeyVect), firstDocIdx);
+}
+
 void FeatureCollector::clearFeatureMaps()
 {
     for (auto & doc : this->docVect) doc.clearFeatureMap();
+    this->constantFeatureMap.clear();
+    this->prunedDocs.assign(this->docVect.size(), false);
+    this->prunedKeys.clear();
+}
+
+base::FValType const & FeatureCollector::getStoredFeatureValue(
+    StructuredDocument const & doc, base::FeatureKey const & fKey) const
+{
+    auto const constIt = this->constantFeatureMap.find(fKey);
+    if (constIt != this->constantFeatureMap.end()) return constIt->second;
+
+    return doc.getFeatureValue(fKey);
 }
 
 void FeatureCollector::assertProperties()
@@ -713,16 +1375,4 @@ void FeatureCollector::assertProperties()
         utils::getKeyUnorderedSet(this->nTermsPerSection));
 }
 
-/* Private static class methods */
-
-void FeatureCollector::throwUnsupportedFeatureType(std::string const & fType)
-{
-    throw std::runtime_error("Unsupported feature type '" + fType + "'");
-}
-
-void FeatureCollector::throwUnsupportedFeatureName(std::string const & fName)
-{
-    throw std::runtime_error("Unsupported feature name '" + fName + "'");
-}
-
 }  // namespace lowletorfeats
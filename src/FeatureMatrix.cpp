@@ -0,0 +1,52 @@
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/FeatureMatrix.hpp>
+
+namespace lowletorfeats
+{
+/* Constructors */
+
+FeatureMatrix::FeatureMatrix(FeatureCollector & fc) : fc(&fc) {}
+
+/* Public class methods */
+
+base::FValType FeatureMatrix::at(
+    std::size_t const docIdx, std::size_t const featureIdx)
+{
+    return this->fc->getFeatureValue(
+        docIdx, this->getFeatureKeys().at(featureIdx));
+}
+
+std::vector<base::FValType> FeatureMatrix::getRow(std::size_t const docIdx)
+{
+    return this->fc->getFeatureVector(docIdx);
+}
+
+void FeatureMatrix::copyRow(std::size_t const docIdx, base::FValType * out)
+{
+    this->fc->copyFeatureVector(docIdx, out);
+}
+
+std::vector<base::FValType> FeatureMatrix::getColumn(
+    std::size_t const featureIdx)
+{
+    return this->fc->getFeatureColumn(this->getFeatureKeys().at(featureIdx));
+}
+
+/* Getter methods */
+
+std::size_t FeatureMatrix::getNumDocs() const
+{
+    return this->fc->getNumDocs();
+}
+
+std::size_t FeatureMatrix::getNumFeatures() const
+{
+    return this->fc->getNumFeatures();
+}
+
+std::vector<base::FeatureKey> const & FeatureMatrix::getFeatureKeys() const
+{
+    return this->fc->getFeatureKeys();
+}
+
+}  // namespace lowletorfeats
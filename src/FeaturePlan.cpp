@@ -0,0 +1,592 @@
+#include <algorithm>  // find, min
+#include <lowletorfeats/ExhaustiveScorer.hpp>
+#include <lowletorfeats/FeaturePlan.hpp>
+#include <lowletorfeats/Okapi.hpp>
+#include <lowletorfeats/Tfidf.hpp>
+#include <lowletorfeats/base/Document.hpp>
+#include <lowletorfeats/utils.hpp>
+#include <stdexcept>
+
+namespace lowletorfeats
+{
+/* Constructors */
+
+FeaturePlan::FeaturePlan() {}
+
+FeaturePlan::FeaturePlan(std::vector<base::FeatureKey> const & fKeyVect)
+{
+    // QOL typedefs
+    typedef base::FeatureKey::ValidTypes VTypes;
+    typedef base::FeatureKey::ValidNames VNames;
+
+    std::unordered_map<std::string, std::size_t> stepIdxMap;
+
+    for (auto const & fKey : fKeyVect)
+    {
+        // Compute duplicate keys once
+        if (std::find(
+                this->featureKeys.begin(), this->featureKeys.end(), fKey) !=
+            this->featureKeys.end())
+            continue;
+
+        bool isStructured = false;
+        bool isConstant = false;
+        bool needsQueryMatches = false;
+        bool needsTfSum = false;
+        bool needsLMIR = false;
+
+        switch (fKey.getVType())
+        {
+            case VTypes::other:
+            {
+                if (fKey.getVName() != VNames::dl)
+                    FeaturePlan::throwUnsupportedFeatureName(fKey.getFName());
+                break;
+            }
+
+            case VTypes::tfidf:
+            {
+                switch (fKey.getVName())
+                {
+                    case VNames::tflognorm:
+                    case VNames::tfdoublenorm:
+                        needsTfSum = true;
+                        break;
+                    case VNames::idfdefault:
+                    case VNames::idfsmooth:
+                    case VNames::idfprob:
+                    case VNames::idfnorm:
+                        isConstant = true;
+                        break;
+                    case VNames::idfmax:
+                        break;
+                    case VNames::tfidf:
+                        needsQueryMatches = true;
+                        break;
+                    default:
+                        FeaturePlan::throwUnsupportedFeatureName(
+                            fKey.getFName());
+                }
+                break;
+            }
+
+            case VTypes::okapi:
+            {
+                switch (fKey.getVName())
+                {
+                    case VNames::bm25:
+                    case VNames::bm25plus:
+                        needsQueryMatches = true;
+                        break;
+                    case VNames::bm25f:
+                    case VNames::bm25fplus:
+                        isStructured = true;
+                        break;
+                    default:
+                        FeaturePlan::throwUnsupportedFeatureName(
+                            fKey.getFName());
+                }
+                break;
+            }
+
+            case VTypes::lmir:
+            {
+                switch (fKey.getVName())
+                {
+                    case VNames::abs:
+                    case VNames::dir:
+                    case VNames::jm:
+                        needsQueryMatches = true;
+                        needsLMIR = true;
+                        break;
+                    default:
+                        FeaturePlan::throwUnsupportedFeatureName(
+                            fKey.getFName());
+                }
+                break;
+            }
+
+            default:
+                FeaturePlan::throwUnsupportedFeatureType(fKey.getFType());
+        }
+
+        std::size_t const featureIdx = this->featureKeys.size();
+        this->featureKeys.push_back(fKey);
+        this->constantFeatures.push_back(isConstant);
+
+        if (isStructured)
+        {
+            this->structuredFeatureIdxs.push_back(featureIdx);
+            continue;
+        }
+
+        // Group the feature with the others over the same section
+        std::string const & fSection = fKey.getFSection();
+        auto const [stepIt, isNewStep] =
+            stepIdxMap.try_emplace(fSection, this->sectionSteps.size());
+        if (isNewStep) this->sectionSteps.emplace_back().section = fSection;
+
+        SectionStep & step = this->sectionSteps[stepIt->second];
+        step.featureIdxs.push_back(featureIdx);
+        step.needsQueryMatches |= needsQueryMatches;
+        step.needsTfSum |= needsTfSum;
+
+        if (needsLMIR && !step.needsLMIR)
+        {
+            step.needsLMIR = true;
+            this->lmirSections.push_back(fSection);
+        }
+    }
+}
+
+/* Public class methods */
+
+FeaturePlan::Context FeaturePlan::bind(CollectionStatsView const & stats) const
+{
+    // QOL typedefs
+    typedef base::FeatureKey::ValidNames VNames;
+    typedef Context::SectionContext SectionContext;
+
+    Context ctx;
+    ctx.stats = stats;
+
+    auto const & queryTfMap = *stats.queryTfMap;
+    ctx.queryIdxVect.resize(queryTfMap.size());
+    ctx.docIdxVect.resize(queryTfMap.size());
+
+    // Construct the context of a section once, shared by every step using it
+    auto const getSectionContext = [&](std::string const & section,
+                                       bool const needsLMIR) {
+        auto const [ctxIt, isNew] = ctx.sectionContexts.try_emplace(section);
+        SectionContext & sectionCtx = ctxIt->second;
+
+        if (isNew)
+        {
+            sectionCtx.avgDocLen = stats.avgDocLenPerSection->at(section);
+            sectionCtx.totalTerms = stats.nTermsPerSection->at(section);
+
+            auto const & docsWithTermMap =
+                stats.nDocsWithTermPerSection->at(section);
+            sectionCtx.idfTable.reserve(queryTfMap.size());
+            for (auto const & mapPair : queryTfMap)
+            {
+                auto const dfIt = docsWithTermMap.find(mapPair.first);
+                sectionCtx.idfTable.push_back(
+                    (dfIt != docsWithTermMap.end())
+                        ? Tfidf::idfNorm(stats.numDocs, dfIt->second)
+                        : 0);
+            }
+        }
+
+        if (needsLMIR && sectionCtx.lime == nullptr)
+        {
+            sectionCtx.lime = &stats.lmirCalculators->at(section);
+
+            auto const & termProbMap =
+                sectionCtx.lime->getTermProbabilityMap();
+            sectionCtx.termProbTable.reserve(queryTfMap.size());
+            for (auto const & mapPair : queryTfMap)
+            {
+                auto const probIt = termProbMap.find(mapPair.first);
+                sectionCtx.termProbTable.push_back(
+                    (probIt != termProbMap.end()) ? probIt->second : 0);
+            }
+        }
+
+        return &sectionCtx;
+    };
+
+#ifdef LOWLETORFEATS_INSTRUMENTATION
+    ctx.featureTimings.assign(this->featureKeys.size(), TimingStat());
+#endif
+
+    // Section steps
+    ctx.constantValues.assign(this->featureKeys.size(), 0);
+    ctx.stepContexts.reserve(this->sectionSteps.size());
+    for (auto const & step : this->sectionSteps)
+    {
+        // Handle non-existent section
+        if (stats.avgDocLenPerSection->count(step.section) == 0)
+        {
+            ctx.stepContexts.push_back(nullptr);
+            continue;
+        }
+
+        SectionContext const * sectionCtx =
+            getSectionContext(step.section, step.needsLMIR);
+        ctx.stepContexts.push_back(sectionCtx);
+
+        for (auto const featureIdx : step.featureIdxs)
+        {
+            if (!this->constantFeatures[featureIdx]) continue;
+
+            base::FValType & fVal = ctx.constantValues[featureIdx];
+            switch (this->featureKeys[featureIdx].getVName())
+            {
+                case VNames::idfdefault:
+                    fVal = Tfidf::idfDefault(
+                        stats.numDocs, sectionCtx->totalTerms);
+                    break;
+                case VNames::idfsmooth:
+                    fVal = Tfidf::idfSmooth(
+                        stats.numDocs, sectionCtx->totalTerms);
+                    break;
+                case VNames::idfprob:
+                    fVal = Tfidf::idfProb(
+                        stats.numDocs, sectionCtx->totalTerms);
+                    break;
+                case VNames::idfnorm:
+                    fVal = Tfidf::idfNorm(
+                        stats.numDocs, sectionCtx->totalTerms);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Structured features
+    if (!this->structuredFeatureIdxs.empty())
+    {
+        for (auto const featureIdx : this->structuredFeatureIdxs)
+        {
+            ctx.structuredSectionExists.push_back(
+                stats.avgDocLenPerSection->count(
+                    this->featureKeys[featureIdx].getFSection()) != 0);
+        }
+
+        for (auto const & mapPair : *stats.nDocsWithTermPerSection)
+        {
+            auto const & sectionKey = mapPair.first;
+
+            auto const weightIt = stats.sectionWeights->find(sectionKey);
+            if (weightIt == stats.sectionWeights->end()) continue;
+
+            ctx.weightedContexts.try_emplace(
+                sectionKey, getSectionContext(sectionKey, false),
+                weightIt->second);
+        }
+
+        for (auto const & mapPair : stats.nDocsWithTermPerSection->at("full"))
+            ctx.fullIdf += Tfidf::idfNorm(stats.numDocs, mapPair.second);
+    }
+
+    return ctx;
+}
+
+template <class Doc>
+void FeaturePlan::evaluate(
+    Context & ctx, Doc const & doc, base::FValType * outRow) const
+{
+    // QOL typedefs
+    typedef base::FeatureKey::ValidNames VNames;
+
+    for (std::size_t stepIdx = 0; stepIdx < this->sectionSteps.size();
+         ++stepIdx)
+    {
+        auto const & step = this->sectionSteps[stepIdx];
+        auto const * sectionCtx = ctx.stepContexts[stepIdx];
+
+        // Handle non-existent section
+        if (sectionCtx == nullptr)
+        {
+            for (auto const featureIdx : step.featureIdxs)
+                outRow[featureIdx] = 0;
+            continue;
+        }
+
+        // Intermediates shared by the features of the section
+        decltype(&doc.getTermFrequencyMap(step.section)) tfMap = nullptr;
+        if (step.needsQueryMatches || step.needsTfSum)
+            tfMap = &doc.getTermFrequencyMap(step.section);
+
+        std::size_t const nMatches =
+            step.needsQueryMatches ? this->matchQueryTerms(ctx, *tfMap) : 0;
+        std::size_t const tfSum = step.needsTfSum ? utils::mapValueSum(*tfMap)
+                                                  : 0;
+
+        for (auto const featureIdx : step.featureIdxs)
+        {
+            base::FValType & fVal = outRow[featureIdx];
+
+            if (this->constantFeatures[featureIdx])
+            {
+                fVal = ctx.constantValues[featureIdx];
+                continue;
+            }
+
+            LOWLETORFEATS_TIME_SCOPE(ctx.featureTimings[featureIdx]);
+
+            switch (this->featureKeys[featureIdx].getVName())
+            {
+                case VNames::dl:
+                    fVal = static_cast<base::FValType>(
+                        doc.getDocLen(step.section));
+                    break;
+
+                case VNames::tflognorm:
+                    fVal = Tfidf::tfLogNorm(tfSum);
+                    break;
+
+                case VNames::tfdoublenorm:
+                    fVal = Tfidf::tfDoubleNorm(tfSum, doc.getMaxTF());
+                    break;
+
+                case VNames::idfmax:
+                    fVal =
+                        Tfidf::idfMax(sectionCtx->totalTerms, doc.getMaxTF());
+                    break;
+
+                case VNames::tfidf:
+                {
+                    std::size_t const maxTF = doc.getMaxTF();
+
+                    fVal = 0;
+                    for (std::size_t i = 0; i < nMatches; ++i)
+                    {
+                        auto const & tf =
+                            (tfMap->begin() + ctx.docIdxVect[i])->second;
+                        fVal += Tfidf::tfDoubleNorm(tf, maxTF) *
+                                sectionCtx->idfTable[ctx.queryIdxVect[i]];
+                    }
+                    break;
+                }
+
+                case VNames::bm25:
+                    fVal =
+                        this->sectionBm25(*sectionCtx, *tfMap, ctx, nMatches);
+                    break;
+
+                case VNames::bm25plus:
+                    fVal = this->sectionBm25plus(
+                        *sectionCtx, *tfMap, ctx, nMatches);
+                    break;
+
+                case VNames::abs:
+                {
+                    std::size_t const docLen = doc.getDocLen();
+                    std::size_t const nUniqueTerms = tfMap->size();
+
+                    fVal = 0;
+                    for (std::size_t i = 0; i < nMatches; ++i)
+                    {
+                        auto const & tf =
+                            (tfMap->begin() + ctx.docIdxVect[i])->second;
+                        fVal += sectionCtx->lime->absoluteDiscountTerm(
+                            tf, docLen, nUniqueTerms,
+                            sectionCtx->termProbTable[ctx.queryIdxVect[i]]);
+                    }
+                    break;
+                }
+
+                case VNames::dir:
+                {
+                    std::size_t const docLen = doc.getDocLen();
+
+                    fVal = 0;
+                    for (std::size_t i = 0; i < nMatches; ++i)
+                    {
+                        auto const & tf =
+                            (tfMap->begin() + ctx.docIdxVect[i])->second;
+                        fVal += sectionCtx->lime->dirichletTerm(
+                            tf, docLen,
+                            sectionCtx->termProbTable[ctx.queryIdxVect[i]]);
+                    }
+                    break;
+                }
+
+                case VNames::jm:
+                {
+                    std::size_t const docLen = doc.getDocLen();
+
+                    fVal = 0;
+                    for (std::size_t i = 0; i < nMatches; ++i)
+                    {
+                        auto const & tf =
+                            (tfMap->begin() + ctx.docIdxVect[i])->second;
+                        fVal += sectionCtx->lime->jelinekMercerTerm(
+                            tf, docLen,
+                            sectionCtx->termProbTable[ctx.queryIdxVect[i]]);
+                    }
+                    break;
+                }
+
+                default:
+                    break;  // Rejected when compiled
+            }
+        }
+    }
+
+    if (this->structuredFeatureIdxs.empty()) return;
+
+    // First `bm25f` and `bm25fplus` features, also recording the time of the
+    //  section scores shared by the others
+    std::size_t bm25fIdx = this->featureKeys.size();
+    std::size_t bm25fplusIdx = this->featureKeys.size();
+    for (auto const featureIdx : this->structuredFeatureIdxs)
+    {
+        if (this->featureKeys[featureIdx].getVName() == VNames::bm25f)
+            bm25fIdx = std::min(bm25fIdx, featureIdx);
+        else
+            bm25fplusIdx = std::min(bm25fplusIdx, featureIdx);
+    }
+    bool const needsBm25 = bm25fIdx != this->featureKeys.size();
+    bool const needsBm25plus = bm25fplusIdx != this->featureKeys.size();
+
+#ifdef LOWLETORFEATS_INSTRUMENTATION
+    TimingStat bm25Timing;
+    TimingStat bm25plusTiming;
+#endif
+
+    // Weighted BM25 and BM25+ of every section, shared by `bm25f` features
+    base::FValType totalBm25 = 0;
+    base::FValType totalBm25plus = 0;
+    for (auto const & [sectionKey, tfMap] :
+         doc.getStructuredTermFrequencyMap())
+    {
+        auto const ctxIt = ctx.weightedContexts.find(sectionKey);
+        if (ctxIt == ctx.weightedContexts.end()) continue;
+
+        auto const & [sectionCtx, weight] = ctxIt->second;
+        std::size_t const nMatches = this->matchQueryTerms(ctx, tfMap);
+
+        if (needsBm25)
+        {
+            LOWLETORFEATS_TIME_SCOPE(bm25Timing);
+            base::FValType bm25 =
+                this->sectionBm25(*sectionCtx, tfMap, ctx, nMatches);
+            bm25 *= weight;
+            totalBm25 += bm25;
+        }
+        if (needsBm25plus)
+        {
+            LOWLETORFEATS_TIME_SCOPE(bm25plusTiming);
+            base::FValType bm25plus =
+                this->sectionBm25plus(*sectionCtx, tfMap, ctx, nMatches);
+            bm25plus *= weight;
+            totalBm25plus += bm25plus;
+        }
+    }
+
+#ifdef LOWLETORFEATS_INSTRUMENTATION
+    if (needsBm25) ctx.featureTimings[bm25fIdx].add(bm25Timing.nanoseconds);
+    if (needsBm25plus)
+        ctx.featureTimings[bm25fplusIdx].add(bm25plusTiming.nanoseconds);
+#endif
+
+    for (std::size_t i = 0; i < this->structuredFeatureIdxs.size(); ++i)
+    {
+        std::size_t const featureIdx = this->structuredFeatureIdxs[i];
+
+        if (!ctx.structuredSectionExists[i])
+            outRow[featureIdx] = 0;
+        else if (this->featureKeys[featureIdx].getVName() == VNames::bm25f)
+            outRow[featureIdx] = ctx.fullIdf * totalBm25;
+        else
+            outRow[featureIdx] = ctx.fullIdf * totalBm25plus;
+    }
+}
+
+bool FeaturePlan::isConstant(std::size_t const featureIdx) const
+{
+    return this->constantFeatures.at(featureIdx);
+}
+
+base::FValType FeaturePlan::getConstantValue(
+    Context const & ctx, std::size_t const featureIdx) const
+{
+    return ctx.constantValues.at(featureIdx);
+}
+
+void FeaturePlan::addTimings(Context const & ctx, PipelineStats & stats) const
+{
+    for (std::size_t i = 0; i < ctx.featureTimings.size(); ++i)
+    {
+        if (ctx.featureTimings[i].calls != 0)
+            stats.feature(this->featureKeys[i]).merge(ctx.featureTimings[i]);
+    }
+}
+
+/* Getter methods */
+
+std::size_t FeaturePlan::size() const { return this->featureKeys.size(); }
+
+bool FeaturePlan::empty() const { return this->featureKeys.empty(); }
+
+std::vector<base::FeatureKey> const & FeaturePlan::getFeatureKeys() const
+{
+    return this->featureKeys;
+}
+
+std::vector<std::string> const & FeaturePlan::getLMIRSections() const
+{
+    return this->lmirSections;
+}
+
+/* Private class methods */
+
+template <class TfMap>
+std::size_t FeaturePlan::matchQueryTerms(
+    Context & ctx, TfMap const & tfMap) const
+{
+    auto const & queryTfMap = *ctx.stats.queryTfMap;
+
+    return utils::getSortedIntersection(
+        queryTfMap.begin(), queryTfMap.end(), tfMap.begin(), tfMap.end(),
+        ctx.queryIdxVect.data(), ctx.docIdxVect.data());
+}
+
+template <class TfMap>
+base::FValType FeaturePlan::sectionBm25(
+    Context::SectionContext const & sectionCtx, TfMap const & tfMap,
+    Context const & ctx, std::size_t const nMatches) const
+{
+    base::FValType score = 0;
+    for (std::size_t i = 0; i < nMatches; ++i)
+    {
+        auto const & tf = (tfMap.begin() + ctx.docIdxVect[i])->second;
+        score +=
+            sectionCtx.idfTable[ctx.queryIdxVect[i]] *
+            Okapi::bm25TfNorm(tf, ctx.stats.numDocs, sectionCtx.avgDocLen);
+    }
+
+    return score;
+}
+
+template <class TfMap>
+base::FValType FeaturePlan::sectionBm25plus(
+    Context::SectionContext const & sectionCtx, TfMap const & tfMap,
+    Context const & ctx, std::size_t const nMatches) const
+{
+    base::FValType score = 0;
+    for (std::size_t i = 0; i < nMatches; ++i)
+    {
+        auto const & tf = (tfMap.begin() + ctx.docIdxVect[i])->second;
+        score += sectionCtx.idfTable[ctx.queryIdxVect[i]] *
+                 Okapi::bm25plusTfNorm(
+                     tf, ctx.stats.numDocs, sectionCtx.avgDocLen);
+    }
+
+    return score;
+}
+
+/* Private static class methods */
+
+void FeaturePlan::throwUnsupportedFeatureType(std::string const & fType)
+{
+    throw std::runtime_error("Unsupported feature type '" + fType + "'");
+}
+
+void FeaturePlan::throwUnsupportedFeatureName(std::string const & fName)
+{
+    throw std::runtime_error("Unsupported feature name '" + fName + "'");
+}
+
+/* Explicit instantiation */
+
+template void FeaturePlan::evaluate<StructuredDocument>(
+    Context &, StructuredDocument const &, base::FValType *) const;
+template void FeaturePlan::evaluate<ExhaustiveScorer::DocumentView>(
+    Context &, ExhaustiveScorer::DocumentView const &, base::FValType *) const;
+
+}  // namespace lowletorfeats
@@ -0,0 +1,674 @@
+#include <fcntl.h>       // O_CLOEXEC
+#include <poll.h>        // poll
+#include <sys/socket.h>  // socket, bind, listen, accept4, connect, send
+#include <sys/stat.h>    // stat
+#include <sys/un.h>      // sockaddr_un
+#include <unistd.h>      // read, write, close, pipe2, unlink
+
+#include <algorithm>  // max, min
+#include <cerrno>
+#include <cstring>  // memcpy, strerror
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/FeatureServer.hpp>
+#include <stdexcept>
+#include <thread>
+
+namespace lowletorfeats
+{
+namespace
+{
+// Wait before accepting again when out of file descriptors
+int const ACCEPT_RETRY_MS = 100;
+
+std::runtime_error systemError(std::string const & what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+/**
+ * @brief Read exactly `n` characters.
+ *
+ * @return false If the peer closed the connection before the first one.
+ */
+bool readAll(int const fd, char * dst, std::size_t const n)
+{
+    std::size_t nRead = 0;
+    while (nRead < n)
+    {
+        ssize_t const nChars = ::read(fd, dst + nRead, n - nRead);
+        if (nChars < 0)
+        {
+            if (errno == EINTR) continue;
+            throw systemError("Could not read from socket");
+        }
+        if (nChars == 0)
+        {
+            if (nRead == 0) return false;
+            throw std::runtime_error("Connection closed within a message");
+        }
+
+        nRead += static_cast<std::size_t>(nChars);
+    }
+
+    return true;
+}
+
+void writeAll(int const fd, char const * src, std::size_t n)
+{
+    while (n > 0)
+    {
+        // Do not raise SIGPIPE if the peer is gone
+        ssize_t const nChars = ::send(fd, src, n, MSG_NOSIGNAL);
+        if (nChars < 0)
+        {
+            if (errno == EINTR) continue;
+            throw systemError("Could not write to socket");
+        }
+
+        src += nChars;
+        n -= static_cast<std::size_t>(nChars);
+    }
+}
+
+/* Message encoding */
+
+/**
+ * @brief Start a message, leaving room for its size.
+ *
+ */
+void startMessage(std::string & message)
+{
+    message.assign(sizeof(std::uint32_t), '\0');
+}
+
+void appendUint8(std::string & message, std::uint8_t const value)
+{
+    message += static_cast<char>(value);
+}
+
+void appendUint32(std::string & message, std::size_t const value)
+{
+    std::uint32_t const value32 = static_cast<std::uint32_t>(value);
+    message.append(reinterpret_cast<char const *>(&value32), sizeof(value32));
+}
+
+void appendString(std::string & message, std::string_view const str)
+{
+    appendUint32(message, str.size());
+    message.append(str);
+}
+
+/**
+ * @brief Fill in the size of a message and send it.
+ *
+ */
+void sendMessage(int const fd, std::string & message)
+{
+    std::size_t const payloadSize = message.size() - sizeof(std::uint32_t);
+    if (payloadSize > featureserver::MAX_MESSAGE_SIZE)
+        throw std::runtime_error("Message too large");
+
+    std::uint32_t const size32 = static_cast<std::uint32_t>(payloadSize);
+    std::memcpy(message.data(), &size32, sizeof(size32));
+    writeAll(fd, message.data(), message.size());
+}
+
+/**
+ * @brief Receive the payload of a message.
+ *
+ * @return false If the peer closed the connection between messages.
+ */
+bool receiveMessage(int const fd, std::string & payload)
+{
+    std::uint32_t size32;
+    if (!readAll(fd, reinterpret_cast<char *>(&size32), sizeof(size32)))
+        return false;
+    if (size32 > featureserver::MAX_MESSAGE_SIZE)
+        throw std::runtime_error("Message too large");
+
+    payload.resize(size32);
+    if (!readAll(fd, payload.data(), size32))
+        throw std::runtime_error("Connection closed within a message");
+
+    return true;
+}
+
+/**
+ * @brief Cursor over a received payload.
+ *
+ */
+class MessageReader
+{
+public:
+    explicit MessageReader(std::string_view const payload) : rest(payload) {}
+
+    std::string_view readBytes(std::size_t const n)
+    {
+        if (n > this->rest.size())
+            throw std::runtime_error("Truncated message");
+
+        std::string_view const bytes = this->rest.substr(0, n);
+        this->rest.remove_prefix(n);
+        return bytes;
+    }
+
+    std::uint8_t readUint8()
+    {
+        return static_cast<std::uint8_t>(this->readBytes(1)[0]);
+    }
+
+    std::uint32_t readUint32()
+    {
+        std::uint32_t value;
+        std::memcpy(
+            &value, this->readBytes(sizeof(value)).data(), sizeof(value));
+        return value;
+    }
+
+    std::string_view readString()
+    {
+        return this->readBytes(this->readUint32());
+    }
+
+    std::string_view getRest() const { return this->rest; }
+
+private:
+    std::string_view rest;
+};
+
+}  // namespace
+
+/* Constructors */
+
+FeatureServer::FeatureServer(FeaturePlan const & plan)
+    : FeatureServer(plan, Options())
+{
+}
+
+FeatureServer::FeatureServer(
+    FeaturePlan const & plan, Options const & options)
+    : plan(plan), options(options)
+{
+}
+
+FeatureServer::~FeatureServer()
+{
+    if (this->listenFd >= 0)
+    {
+        ::close(this->listenFd);
+        ::unlink(this->socketPath.c_str());
+    }
+    for (int const fd : this->stopFds)
+        if (fd >= 0) ::close(fd);
+}
+
+/* Public class methods */
+
+void FeatureServer::listen(std::string const & socketPath)
+{
+    if (this->listenFd >= 0) throw std::runtime_error("Already listening");
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error(
+            "Socket path too long: '" + socketPath + "'");
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    // Replace a socket left by a server that is gone, but not a live one
+    struct stat fileStat;
+    if (::stat(socketPath.c_str(), &fileStat) == 0)
+    {
+        if (!S_ISSOCK(fileStat.st_mode))
+            throw std::runtime_error("Not a socket: '" + socketPath + "'");
+
+        int const probeFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool const isLive =
+            probeFd >= 0 &&
+            ::connect(
+                probeFd, reinterpret_cast<sockaddr const *>(&address),
+                sizeof(address)) == 0;
+        if (probeFd >= 0) ::close(probeFd);
+        if (isLive)
+            throw std::runtime_error(
+                "A server is already listening at '" + socketPath + "'");
+        ::unlink(socketPath.c_str());
+    }
+
+    int const fd =
+        ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) throw systemError("Could not create socket");
+    if (::bind(
+            fd, reinterpret_cast<sockaddr const *>(&address),
+            sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0)
+    {
+        std::runtime_error const error =
+            systemError("Could not listen at '" + socketPath + "'");
+        ::close(fd);
+        throw error;
+    }
+
+    if (::pipe2(this->stopFds, O_CLOEXEC) != 0)
+    {
+        std::runtime_error const error = systemError("Could not create pipe");
+        ::close(fd);
+        ::unlink(socketPath.c_str());
+        throw error;
+    }
+
+    this->listenFd = fd;
+    this->socketPath = socketPath;
+}
+
+void FeatureServer::run()
+{
+    if (this->listenFd < 0) throw std::runtime_error("Not listening");
+
+    base::BoundedQueue<int> queue(this->options.backlog);
+    {
+        std::lock_guard<std::mutex> const lock(this->connMutex);
+        if (this->stopping) return;
+        this->connQueue = &queue;
+    }
+
+    auto const worker = [&]() {
+        int fd;
+        while (queue.pop(fd))
+        {
+            {
+                std::lock_guard<std::mutex> const lock(this->connMutex);
+                if (this->stopping)
+                {
+                    ::close(fd);
+                    continue;
+                }
+                this->activeFds.insert(fd);
+            }
+
+            this->serveConnection(fd);
+
+            {
+                std::lock_guard<std::mutex> const lock(this->connMutex);
+                this->activeFds.erase(fd);
+            }
+            ::close(fd);
+        }
+    };
+
+    std::size_t const numWorkers =
+        std::max<std::size_t>(1, this->options.numWorkers);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < numWorkers; ++i) workers.emplace_back(worker);
+
+    // Accept connections until woken by `stop`
+    int loopErrno = 0;
+    char const * loopError = nullptr;
+    pollfd pollFds[2] = {
+        {this->listenFd, POLLIN, 0}, {this->stopFds[0], POLLIN, 0}};
+    while (true)
+    {
+        if (::poll(pollFds, 2, -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            loopErrno = errno;
+            loopError = "Could not wait for connections";
+            this->stop();
+            break;
+        }
+        if (pollFds[1].revents != 0) break;
+        if (pollFds[0].revents == 0) continue;
+
+        int fd = ::accept4(this->listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            // The socket is non-blocking, the client may have given up
+            //  already
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ||
+                errno == ECONNABORTED)
+                continue;
+
+            // Out of descriptors or memory, the pending connection stays
+            //  readable: wait for connections to close, or for `stop`
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+                errno == ENOMEM)
+            {
+                ::poll(&pollFds[1], 1, ACCEPT_RETRY_MS);
+                continue;
+            }
+
+            loopErrno = errno;
+            loopError = "Could not accept a connection";
+            this->stop();
+            break;
+        }
+        if (!queue.push(std::move(fd)))
+        {
+            ::close(fd);
+            break;
+        }
+    }
+
+    queue.close();
+    for (auto & thread : workers) thread.join();
+    {
+        std::lock_guard<std::mutex> const lock(this->connMutex);
+        this->connQueue = nullptr;
+    }
+
+    if (loopError != nullptr)
+    {
+        errno = loopErrno;
+        throw systemError(loopError);
+    }
+}
+
+void FeatureServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> const lock(this->connMutex);
+        this->stopping = true;
+        if (this->connQueue != nullptr) this->connQueue->close();
+
+        // Wake the workers waiting for a request
+        for (int const fd : this->activeFds) ::shutdown(fd, SHUT_RDWR);
+    }
+
+    if (this->stopFds[1] >= 0)
+    {
+        char const c = 0;
+        [[maybe_unused]] ssize_t const nChars =
+            ::write(this->stopFds[1], &c, 1);
+    }
+}
+
+/* Getter methods */
+
+TimingStat FeatureServer::getRequestTiming() const
+{
+    std::lock_guard<std::mutex> const lock(this->connMutex);
+    return this->requestTiming;
+}
+
+/* Setter methods */
+
+void FeatureServer::setIndex(
+    InvertedIndex const & index, std::vector<std::string> const & docIds)
+{
+    if (docIds.size() != index.getNumDocs())
+        throw std::runtime_error("Expected an id for every indexed document");
+
+    this->scorer = std::make_unique<ExhaustiveScorer>(index, this->plan);
+    this->docIdMap.clear();
+    this->docIdMap.reserve(docIds.size());
+    for (std::size_t i = 0; i < docIds.size(); ++i)
+        this->docIdMap.emplace(docIds[i], static_cast<base::DocId>(i));
+}
+
+/* Private class methods */
+
+void FeatureServer::serveConnection(int const fd)
+{
+    std::string request;
+    std::string response;
+    TimingStat timingStat;
+
+    try
+    {
+        while (receiveMessage(fd, request))
+        {
+            {
+                ScopedTimer const timer(timingStat);
+                try
+                {
+                    this->handleRequest(request, response);
+                }
+                catch (std::exception const & e)
+                {
+                    startMessage(response);
+                    appendUint8(
+                        response,
+                        static_cast<std::uint8_t>(
+                            featureserver::Status::error));
+                    appendString(response, e.what());
+                }
+            }
+            sendMessage(fd, response);
+        }
+    }
+    catch (std::exception const &)
+    {
+        // A broken or malformed stream drops the connection only
+    }
+
+    std::lock_guard<std::mutex> const lock(this->connMutex);
+    this->requestTiming.merge(timingStat);
+}
+
+void FeatureServer::handleRequest(
+    std::string_view const request, std::string & response)
+{
+    std::vector<base::FeatureKey> const & fKeys = this->plan.getFeatureKeys();
+
+    MessageReader reader(request);
+    auto const requestType =
+        static_cast<featureserver::RequestType>(reader.readUint8());
+
+    startMessage(response);
+    appendUint8(
+        response, static_cast<std::uint8_t>(featureserver::Status::ok));
+
+    if (requestType == featureserver::RequestType::schema)
+    {
+        if (!reader.getRest().empty())
+            throw std::runtime_error("Unexpected bytes after the request");
+
+        appendUint32(response, fKeys.size());
+        for (auto const & fKey : fKeys)
+            appendString(response, fKey.toString());
+        return;
+    }
+
+    std::string const queryText(reader.readString());
+    std::size_t const numDocs = reader.readUint32();
+
+    // Every document takes at least a size, reject a count the request cannot
+    //  hold before allocating for it
+    if (numDocs > reader.getRest().size() / sizeof(std::uint32_t))
+        throw std::runtime_error("More documents announced than sent");
+
+    // The response must fit a message, reject it before computing it. The
+    //  status and the two counts precede the rows
+    std::size_t const rowsSize =
+        numDocs * fKeys.size() * sizeof(base::FValType);
+    if (rowsSize > featureserver::MAX_MESSAGE_SIZE - sizeof(std::uint8_t) -
+                       2 * sizeof(std::uint32_t))
+        throw std::runtime_error(
+            "Response too large, request fewer than " +
+            std::to_string(numDocs) + " documents");
+
+    if (requestType == featureserver::RequestType::docIds)
+    {
+        if (!this->scorer)
+            throw std::runtime_error("The server has no index");
+
+        std::vector<base::DocId> docIdVect;
+        docIdVect.reserve(numDocs);
+        for (std::size_t i = 0; i < numDocs; ++i)
+        {
+            std::string const docId(reader.readString());
+            auto const docIdIt = this->docIdMap.find(docId);
+            if (docIdIt == this->docIdMap.end())
+                throw std::runtime_error("Unknown document '" + docId + "'");
+            docIdVect.push_back(docIdIt->second);
+        }
+        if (!reader.getRest().empty())
+            throw std::runtime_error("Unexpected bytes after the request");
+
+        // Rows are streamed straight into the response
+        appendUint32(response, numDocs);
+        appendUint32(response, fKeys.size());
+        response.reserve(
+            response.size() + numDocs * fKeys.size() * sizeof(base::FValType));
+        this->scorer->score(
+            queryText, docIdVect,
+            [&response](
+                base::DocId const,
+                std::vector<base::FValType> const & fValues) {
+                response.append(
+                    reinterpret_cast<char const *>(fValues.data()),
+                    fValues.size() * sizeof(base::FValType));
+            });
+        return;
+    }
+    if (requestType != featureserver::RequestType::docTexts)
+        throw std::runtime_error("Unknown request type");
+
+    // Sections are viewed in the request
+    std::vector<base::StrViewPairVector> docTextVect(numDocs);
+    for (auto & docText : docTextVect)
+    {
+        std::size_t const numSections = reader.readUint32();
+        for (std::size_t i = 0; i < numSections; ++i)
+        {
+            std::string_view const sectionKey = reader.readString();
+            docText.emplace_back(sectionKey, reader.readString());
+        }
+    }
+    if (!reader.getRest().empty())
+        throw std::runtime_error("Unexpected bytes after the request");
+
+    appendUint32(response, numDocs);
+    appendUint32(response, fKeys.size());
+    if (numDocs == 0) return;
+
+    FeatureCollector fc;
+    fc.setQuery(queryText);
+    fc.addDocs(docTextVect);
+    fc.collectFeatures(this->plan);
+    FeatureMatrix fMatrix = fc.getFeatureMatrix();
+    response.reserve(
+        response.size() + numDocs * fKeys.size() * sizeof(base::FValType));
+    for (std::size_t docIdx = 0; docIdx < numDocs; ++docIdx)
+    {
+        std::vector<base::FValType> const fValues = fMatrix.getRow(docIdx);
+        response.append(
+            reinterpret_cast<char const *>(fValues.data()),
+            fValues.size() * sizeof(base::FValType));
+    }
+}
+
+/* Client */
+
+FeatureClient::FeatureClient(std::string const & socketPath)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error(
+            "Socket path too long: '" + socketPath + "'");
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    this->fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->fd < 0) throw systemError("Could not create socket");
+    if (::connect(
+            this->fd, reinterpret_cast<sockaddr const *>(&address),
+            sizeof(address)) != 0)
+    {
+        std::runtime_error const error =
+            systemError("Could not connect to '" + socketPath + "'");
+        ::close(this->fd);
+        throw error;
+    }
+}
+
+FeatureClient::~FeatureClient() { ::close(this->fd); }
+
+std::vector<base::FeatureKey> FeatureClient::getFeatureKeys()
+{
+    startMessage(this->request);
+    appendUint8(
+        this->request,
+        static_cast<std::uint8_t>(featureserver::RequestType::schema));
+
+    MessageReader reader(this->exchange());
+    std::size_t const numFeatures = reader.readUint32();
+    std::vector<base::FeatureKey> fKeys;
+    fKeys.reserve(std::min(
+        numFeatures, reader.getRest().size() / sizeof(std::uint32_t)));
+    for (std::size_t i = 0; i < numFeatures; ++i)
+        fKeys.emplace_back(std::string(reader.readString()));
+
+    return fKeys;
+}
+
+void FeatureClient::getFeatures(
+    std::string_view const queryText,
+    std::vector<std::string_view> const & docIds, FeatureRows & rows)
+{
+    startMessage(this->request);
+    appendUint8(
+        this->request,
+        static_cast<std::uint8_t>(featureserver::RequestType::docIds));
+    appendString(this->request, queryText);
+    appendUint32(this->request, docIds.size());
+    for (std::string_view const docId : docIds)
+        appendString(this->request, docId);
+
+    this->readRows(this->exchange(), rows);
+}
+
+void FeatureClient::getFeatures(
+    std::string_view const queryText,
+    std::vector<base::StrViewPairVector> const & docTextVect,
+    FeatureRows & rows)
+{
+    startMessage(this->request);
+    appendUint8(
+        this->request,
+        static_cast<std::uint8_t>(featureserver::RequestType::docTexts));
+    appendString(this->request, queryText);
+    appendUint32(this->request, docTextVect.size());
+    for (auto const & docText : docTextVect)
+    {
+        appendUint32(this->request, docText.size());
+        for (auto const & [sectionKey, sectionText] : docText)
+        {
+            appendString(this->request, sectionKey);
+            appendString(this->request, sectionText);
+        }
+    }
+
+    this->readRows(this->exchange(), rows);
+}
+
+std::string_view FeatureClient::exchange()
+{
+    sendMessage(this->fd, this->request);
+    if (!receiveMessage(this->fd, this->response))
+        throw std::runtime_error("The server closed the connection");
+
+    MessageReader reader(this->response);
+    if (static_cast<featureserver::Status>(reader.readUint8()) !=
+        featureserver::Status::ok)
+        throw std::runtime_error(
+            "Server error: " + std::string(reader.readString()));
+
+    return reader.getRest();
+}
+
+void FeatureClient::readRows(
+    std::string_view const payload, FeatureRows & rows)
+{
+    MessageReader reader(payload);
+    rows.numDocs = reader.readUint32();
+    rows.numFeatures = reader.readUint32();
+
+    std::size_t const numValues = rows.numDocs * rows.numFeatures;
+    std::string_view const bytes =
+        reader.readBytes(numValues * sizeof(base::FValType));
+    rows.values.resize(numValues);
+    std::memcpy(rows.values.data(), bytes.data(), bytes.size());
+}
+
+}  // namespace lowletorfeats
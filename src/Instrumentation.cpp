@@ -0,0 +1,250 @@
+#include <algorithm>  // sort
+#include <atomic>
+#include <cstdio>  // snprintf
+#include <lowletorfeats/Instrumentation.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace lowletorfeats
+{
+/* PipelineStats public class methods */
+
+TimingStat & PipelineStats::stage(Stage const stage)
+{
+    return this->stageTimings.at(static_cast<std::size_t>(stage));
+}
+
+TimingStat & PipelineStats::feature(base::FeatureKey const & fKey)
+{
+    return this->featureTimings[fKey];
+}
+
+void PipelineStats::merge(PipelineStats const & other)
+{
+    for (std::size_t i = 0; i < this->stageTimings.size(); ++i)
+        this->stageTimings[i].merge(other.stageTimings[i]);
+
+    for (auto const & [fKey, timingStat] : other.featureTimings)
+        this->featureTimings[fKey].merge(timingStat);
+}
+
+void PipelineStats::clear()
+{
+    this->stageTimings.fill(TimingStat());
+    this->featureTimings.clear();
+}
+
+std::string PipelineStats::toJson() const
+{
+    auto const timingJson = [](TimingStat const & timingStat) {
+        return "{\"calls\":" + std::to_string(timingStat.calls) +
+               ",\"ns\":" + std::to_string(timingStat.nanoseconds) + '}';
+    };
+
+    std::string outStr = "{\"stages\":{";
+    for (std::size_t i = 0; i < this->stageTimings.size(); ++i)
+    {
+        if (i != 0) outStr += ',';
+        outStr += '"' + PipelineStats::getStageName(static_cast<Stage>(i)) +
+                  "\":" + timingJson(this->stageTimings[i]);
+    }
+    outStr += "},\"features\":{";
+
+    // Sort the features for a stable output
+    std::vector<std::pair<std::string, TimingStat>> featureVect;
+    for (auto const & [fKey, timingStat] : this->featureTimings)
+        featureVect.emplace_back(fKey.toString(), timingStat);
+    std::sort(
+        featureVect.begin(), featureVect.end(),
+        [](auto const & pair1, auto const & pair2) {
+            return pair1.first < pair2.first;
+        });
+
+    for (std::size_t i = 0; i < featureVect.size(); ++i)
+    {
+        if (i != 0) outStr += ',';
+        auto const & [fKeyStr, timingStat] = featureVect[i];
+        outStr += '"' + fKeyStr + "\":" + timingJson(timingStat);
+    }
+    outStr += "}}";
+
+    return outStr;
+}
+
+/* PipelineStats getter methods */
+
+TimingStat const & PipelineStats::getStage(Stage const stage) const
+{
+    return this->stageTimings.at(static_cast<std::size_t>(stage));
+}
+
+std::unordered_map<base::FeatureKey, TimingStat> const &
+    PipelineStats::getFeatureTimings() const
+{
+    return this->featureTimings;
+}
+
+/* PipelineStats static methods */
+
+std::string const & PipelineStats::getStageName(Stage const stage)
+{
+    static std::array<
+        std::string, static_cast<std::size_t>(Stage::count)> const
+        STAGE_NAMES = {"analyzeText",   "addDocs",  "collectionStats",
+                       "constructLMIR", "bindPlan", "computeFeatures"};
+
+    return STAGE_NAMES.at(static_cast<std::size_t>(stage));
+}
+
+/* MemoryStats public class methods */
+
+MemoryUsage & MemoryStats::section(std::string const & sectionKey)
+{
+    return this->sectionUsages[sectionKey];
+}
+
+MemoryUsage & MemoryStats::unsectioned() { return this->unsectionedUsage; }
+
+void MemoryStats::merge(MemoryStats const & other)
+{
+    for (auto const & [sectionKey, usage] : other.sectionUsages)
+        this->sectionUsages[sectionKey].merge(usage);
+
+    this->unsectionedUsage.merge(other.unsectionedUsage);
+}
+
+std::string MemoryStats::toJson() const
+{
+    auto const usageJson = [](MemoryUsage const & usage) {
+        return "{\"term_maps\":" + std::to_string(usage.termMaps) +
+               ",\"stats_maps\":" + std::to_string(usage.statsMaps) +
+               ",\"feature_maps\":" + std::to_string(usage.featureMaps) +
+               ",\"lmir_models\":" + std::to_string(usage.lmirModels) +
+               ",\"term_strings\":" + std::to_string(usage.termStrings) +
+               ",\"total\":" + std::to_string(usage.total()) + '}';
+    };
+
+    std::string outStr = "{\"sections\":{";
+    for (auto const & [sectionKey, usage] : this->sectionUsages)
+    {
+        if (outStr.back() != '{') outStr += ',';
+        outStr += '"' + sectionKey + "\":" + usageJson(usage);
+    }
+    outStr += "},\"unsectioned\":" + usageJson(this->unsectionedUsage);
+    outStr += ",\"total\":" + usageJson(this->getTotal()) + '}';
+
+    return outStr;
+}
+
+/* MemoryStats getter methods */
+
+std::map<std::string, MemoryUsage> const & MemoryStats::getSections() const
+{
+    return this->sectionUsages;
+}
+
+MemoryUsage const & MemoryStats::getUnsectioned() const
+{
+    return this->unsectionedUsage;
+}
+
+MemoryUsage MemoryStats::getTotal() const
+{
+    MemoryUsage totalUsage = this->unsectionedUsage;
+    for (auto const & mapPair : this->sectionUsages)
+        totalUsage.merge(mapPair.second);
+
+    return totalUsage;
+}
+
+/* TraceRecorder constructors */
+
+TraceRecorder::TraceRecorder(std::string const & path)
+    : outStream(path), origin(Clock::now())
+{
+    if (!this->outStream)
+        throw std::runtime_error("Could not open trace file '" + path + "'");
+
+    this->outStream << "[";
+}
+
+TraceRecorder::~TraceRecorder() { this->close(); }
+
+/* TraceRecorder public class methods */
+
+void TraceRecorder::addSpan(
+    std::string_view const name, std::string_view const category,
+    Clock::time_point const start, Clock::time_point const end,
+    std::string_view const qid)
+{
+    typedef std::chrono::duration<double, std::micro> Microseconds;
+
+    // Trace event timestamps are in microseconds
+    char timeStr[64];
+    std::snprintf(
+        timeStr, sizeof(timeStr), "\"ts\":%.3f,\"dur\":%.3f",
+        Microseconds(start - this->origin).count(),
+        Microseconds(end - start).count());
+
+    std::string const eventStr =
+        "{\"name\":" + TraceRecorder::quoteJson(name) +
+        ",\"cat\":" + TraceRecorder::quoteJson(category) +
+        ",\"ph\":\"X\"," + timeStr + ",\"pid\":1,\"tid\":" +
+        std::to_string(TraceRecorder::getThreadId()) +
+        ",\"args\":{\"qid\":" + TraceRecorder::quoteJson(qid) + "}}";
+
+    std::lock_guard<std::mutex> const lock(this->mutex);
+    if (!this->outStream.is_open()) return;
+
+    this->outStream << (this->hasSpans ? ",\n" : "\n") << eventStr;
+    this->hasSpans = true;
+}
+
+void TraceRecorder::close()
+{
+    std::lock_guard<std::mutex> const lock(this->mutex);
+    if (!this->outStream.is_open()) return;
+
+    this->outStream << "\n]\n";
+    this->outStream.close();
+}
+
+/* TraceRecorder static methods */
+
+std::uint32_t TraceRecorder::getThreadId()
+{
+    static std::atomic<std::uint32_t> nextThreadId{0};
+    thread_local std::uint32_t const threadId = nextThreadId++;
+
+    return threadId;
+}
+
+/* TraceRecorder private static methods */
+
+std::string TraceRecorder::quoteJson(std::string_view const str)
+{
+    std::string outStr = "\"";
+    for (char const c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            outStr += '\\';
+            outStr += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escapeStr[8];
+            std::snprintf(
+                escapeStr, sizeof(escapeStr), "\\u%04x",
+                static_cast<unsigned>(c));
+            outStr += escapeStr;
+        }
+        else
+            outStr += c;
+    }
+    outStr += '"';
+
+    return outStr;
+}
+
+}  // namespace lowletorfeats
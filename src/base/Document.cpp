@@ -7,38 +7,57 @@ namespace lowletorfeats
 
 StructuredDocument::StructuredDocument() {}
 
+StructuredDocument::StructuredDocument(std::pmr::memory_resource * resource)
+    : docLenMaps(resource),
+      termFrequencyMaps(resource),
+      maxTermMaps(resource),
+      featureMap(base::FeatureMap::allocator_type(resource))
+{
+}
+
 StructuredDocument::StructuredDocument(
     std::size_t const & docLen, base::StrSizeMap const & fullTermFrequencyMap,
-    std::string const & sectionKey)
+    std::string const & sectionKey, std::pmr::memory_resource * resource)
+    : StructuredDocument::StructuredDocument(resource)
 {
     this->docLenMaps[sectionKey] = docLen;
-    this->termFrequencyMaps[sectionKey] = fullTermFrequencyMap;
+    this->termFrequencyMaps[sectionKey].insert(
+        fullTermFrequencyMap.begin(), fullTermFrequencyMap.end());
     this->maxTermMaps[sectionKey] =
         utils::findMaxValuePair(fullTermFrequencyMap).second;
 }
 
 StructuredDocument::StructuredDocument(
-    std::size_t const & docLen, base::StrSizeMap const & fullTermFrequencyMap)
+    std::size_t const & docLen, base::StrSizeMap const & fullTermFrequencyMap,
+    std::pmr::memory_resource * resource)
     : StructuredDocument::StructuredDocument(
-          docLen, fullTermFrequencyMap, "full")
+          docLen, fullTermFrequencyMap, "full", resource)
 {
 }
 
 StructuredDocument::StructuredDocument(
     base::StrSizeMap const & docLenMap,
-    base::StructuredTermFrequencyMap const & structuredTermFrequencyMap)
+    base::StructuredTermFrequencyMap const & structuredTermFrequencyMap,
+    std::pmr::memory_resource * resource)
+    : StructuredDocument::StructuredDocument(resource)
 {
     this->docLenMaps = docLenMap;
-    this->termFrequencyMaps = structuredTermFrequencyMap;
+    for (auto const & [sectionKey, tfMap] : structuredTermFrequencyMap)
+        this->termFrequencyMaps[sectionKey].insert(tfMap.begin(), tfMap.end());
 
-    // Fill maxTermMap
-    for (auto const & [sectionKey, tfMap] : this->termFrequencyMaps)
-    {
-        this->maxTermMaps[sectionKey] = utils::findMaxValuePair(tfMap).second;
-    }
+    this->initMaxTermMaps();
+}
 
-    // Ensure "full" exists, else populate
-    if (this->termFrequencyMaps.count("full") == 0) this->fillFullFromOthers();
+StructuredDocument::StructuredDocument(
+    base::StrSizeMap const & docLenMap,
+    base::StructuredFlatTermFrequencyMap const & structuredTermFrequencyMap,
+    std::pmr::memory_resource * resource)
+    : StructuredDocument::StructuredDocument(resource)
+{
+    this->docLenMaps = docLenMap;
+    this->termFrequencyMaps = structuredTermFrequencyMap;
+
+    this->initMaxTermMaps();
 }
 
 StructuredDocument::StructuredDocument(StructuredDocument const & other)
@@ -49,6 +68,26 @@ StructuredDocument::StructuredDocument(StructuredDocument const & other)
     this->featureMap = other.featureMap;
 }
 
+StructuredDocument::StructuredDocument(
+    StructuredDocument const & other, std::pmr::memory_resource * resource)
+    : StructuredDocument::StructuredDocument(resource)
+{
+    this->docLenMaps = other.docLenMaps;
+    this->termFrequencyMaps = other.termFrequencyMaps;
+    this->maxTermMaps = other.maxTermMaps;
+    this->featureMap = other.featureMap;
+}
+
+// Moving with the same allocator only steals the buffers of the maps, the
+//  ordered feature map is not marked as non-throwing but does not throw
+StructuredDocument::StructuredDocument(StructuredDocument && other) noexcept
+    : docLenMaps(std::move(other.docLenMaps)),
+      termFrequencyMaps(std::move(other.termFrequencyMaps)),
+      maxTermMaps(std::move(other.maxTermMaps)),
+      featureMap(std::move(other.featureMap))
+{
+}
+
 /* Public class methods */
 
 std::string StructuredDocument::toString() const
@@ -90,6 +129,31 @@ void StructuredDocument::clearSection(std::string const & section)
 
 void StructuredDocument::clearFeatureMap() { this->featureMap.clear(); }
 
+void StructuredDocument::addMemoryUsage(MemoryStats & stats) const
+{
+    for (auto const & [sectionKey, sectionTfMap] : this->termFrequencyMaps)
+    {
+        MemoryUsage & usage = stats.section(sectionKey);
+        usage.termMaps += MemoryStats::flatMapBytes(sectionTfMap);
+        usage.termStrings += MemoryStats::keyStringBytes(sectionTfMap);
+    }
+
+    for (auto const & mapPair : this->featureMap)
+    {
+        stats.section(mapPair.first.getFSection()).featureMaps +=
+            sizeof(base::FeatureMap::value_type);
+    }
+
+    // The maps over the sections themselves
+    MemoryUsage & usage = stats.unsectioned();
+    usage.termMaps += MemoryStats::hashMapBytes(this->termFrequencyMaps);
+    usage.statsMaps += MemoryStats::hashMapBytes(this->docLenMaps) +
+                       MemoryStats::hashMapBytes(this->maxTermMaps);
+    usage.featureMaps +=
+        MemoryStats::featureMapBytes(this->featureMap) -
+        this->featureMap.size() * sizeof(base::FeatureMap::value_type);
+}
+
 /* Getter methods */
 
 std::size_t StructuredDocument::getDocLen() const
@@ -102,18 +166,18 @@ std::size_t StructuredDocument::getDocLen(std::string const & section) const
     return this->docLenMaps.at(section);
 }
 
-base::StructuredTermFrequencyMap const &
+base::StructuredFlatTermFrequencyMap const &
     StructuredDocument::getStructuredTermFrequencyMap() const
 {
     return this->termFrequencyMaps;
 }
 
-base::StrSizeMap const & StructuredDocument::getTermFrequencyMap() const
+base::FlatStrSizeMap const & StructuredDocument::getTermFrequencyMap() const
 {
     return this->termFrequencyMaps.at("full");
 }
 
-base::StrSizeMap const & StructuredDocument::getTermFrequencyMap(
+base::FlatStrSizeMap const & StructuredDocument::getTermFrequencyMap(
     std::string const & section) const
 {
     return this->termFrequencyMaps.at(section);
@@ -158,8 +222,29 @@ void StructuredDocument::updateFeature(
     this->featureMap[fKey] = fValue;
 }
 
+void StructuredDocument::setStructuredTermFrequencyMap(
+    base::StructuredFlatTermFrequencyMap && structuredTermFrequencyMap)
+{
+    this->termFrequencyMaps = std::move(structuredTermFrequencyMap);
+    this->maxTermMaps.clear();
+
+    this->initMaxTermMaps();
+}
+
 /* Private class methods */
 
+void StructuredDocument::initMaxTermMaps()
+{
+    // Fill maxTermMap
+    for (auto const & [sectionKey, tfMap] : this->termFrequencyMaps)
+    {
+        this->maxTermMaps[sectionKey] = utils::findMaxValuePair(tfMap).second;
+    }
+
+    // Ensure "full" exists, else populate
+    if (this->termFrequencyMaps.count("full") == 0) this->fillFullFromOthers();
+}
+
 void StructuredDocument::fillFullFromOthers()
 {
     // Erase contents of section "full"
@@ -169,14 +254,15 @@ void StructuredDocument::fillFullFromOthers()
     this->docLenMaps["full"] = utils::mapValueSum(this->docLenMaps);
 
     // Calculate `termFrequencyMap["full"]`
-    base::StrSizeMap fullTermFreqMap;
+    base::FlatStrSizeMap fullTermFreqMap(
+        this->termFrequencyMaps.get_allocator().resource());
     for (auto const & mapPair : this->termFrequencyMaps)
         utils::additiveMergeInplace(fullTermFreqMap, mapPair.second);
-    this->termFrequencyMaps["full"] = fullTermFreqMap;
+    this->termFrequencyMaps["full"] = std::move(fullTermFreqMap);
 
     // Calculate `maxTermMap["full"]`
     this->maxTermMaps["full"] =
-        utils::findMaxValuePair(fullTermFreqMap).second;
+        utils::findMaxValuePair(this->termFrequencyMaps.at("full")).second;
 }
 
 }  // namespace lowletorfeats
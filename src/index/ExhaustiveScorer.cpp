@@ -0,0 +1,276 @@
+#include <algorithm>  // find, lower_bound, min
+#include <limits>
+#include <lowletorfeats/ExhaustiveScorer.hpp>
+#include <lowletorfeats/LMIR.hpp>
+#include <lowletorfeats/utils.hpp>
+#include <stdexcept>
+#include <string>  // to_string
+
+namespace lowletorfeats
+{
+/* Constructors */
+
+ExhaustiveScorer::ExhaustiveScorer(
+    InvertedIndex const & index, FeaturePlan const & plan)
+    : index(&index), plan(plan)
+{
+}
+
+ExhaustiveScorer::ExhaustiveScorer(
+    InvertedIndex const & index,
+    std::vector<base::FeatureKey> const & fKeyVect)
+    : ExhaustiveScorer::ExhaustiveScorer(index, FeaturePlan(fKeyVect))
+{
+}
+
+/* Public class methods */
+
+std::size_t ExhaustiveScorer::score(
+    std::string const & queryText, RowSink const & sink) const
+{
+    return this->score(InvertedIndex::analyzeQuery(queryText), sink);
+}
+
+std::size_t ExhaustiveScorer::score(
+    base::StrSizeMap const & queryTfMap, RowSink const & sink) const
+{
+    if (this->index->getNumDocs() == 0 || this->plan.empty()) return 0;
+
+    QueryState state;
+    this->initQueryState(queryTfMap, state);
+    FeaturePlan::Context ctx = this->plan.bind(state.stats);
+
+    std::vector<base::FValType> fValVect(this->plan.size());
+    std::size_t nScored = 0;
+
+    base::DocId const endDocId = std::numeric_limits<base::DocId>::max();
+    while (true)
+    {
+        base::DocId docId = endDocId;
+        for (auto const & cursor : state.cursors)
+            docId = std::min(docId, cursor.docId());
+        if (docId == endDocId) break;  // Every postings list is exhausted
+
+        // Gather the matched query terms of the document, in query order
+        for (auto & mapPair : state.doc.sectionTfMaps) mapPair.second.clear();
+        for (auto & cursor : state.cursors)
+        {
+            if (cursor.docId() != docId) continue;
+
+            state.doc.sectionTfMaps[cursor.sectionIdx].second.insert(
+                {cursor.term, cursor.termPostings->postings[cursor.pos].tf});
+            ++cursor.pos;
+        }
+
+        this->scoreDocument(docId, state, ctx, fValVect, sink);
+        ++nScored;
+    }
+
+    return nScored;
+}
+
+std::size_t ExhaustiveScorer::score(
+    std::string const & queryText, std::vector<base::DocId> const & docIds,
+    RowSink const & sink) const
+{
+    return this->score(InvertedIndex::analyzeQuery(queryText), docIds, sink);
+}
+
+std::size_t ExhaustiveScorer::score(
+    base::StrSizeMap const & queryTfMap,
+    std::vector<base::DocId> const & docIds, RowSink const & sink) const
+{
+    std::size_t const numDocs = this->index->getNumDocs();
+    for (auto const docId : docIds)
+    {
+        if (docId >= numDocs)
+            throw std::runtime_error(
+                "DocId out of the index: " + std::to_string(docId));
+    }
+    if (docIds.empty()) return 0;
+
+    QueryState state;
+    this->initQueryState(queryTfMap, state);
+    FeaturePlan::Context ctx = this->plan.bind(state.stats);
+
+    std::vector<base::FValType> fValVect(this->plan.size());
+
+    for (auto const docId : docIds)
+    {
+        // Look the document up in the postings, in query order
+        for (auto & mapPair : state.doc.sectionTfMaps) mapPair.second.clear();
+        for (auto const & cursor : state.cursors)
+        {
+            auto const & postings = cursor.termPostings->postings;
+            auto const postingIt = std::lower_bound(
+                postings.begin(), postings.end(), docId,
+                [](InvertedIndex::Posting const & posting,
+                   base::DocId const id) { return posting.docId < id; });
+            if (postingIt == postings.end() || postingIt->docId != docId)
+                continue;
+
+            state.doc.sectionTfMaps[cursor.sectionIdx].second.insert(
+                {cursor.term, postingIt->tf});
+        }
+
+        this->scoreDocument(docId, state, ctx, fValVect, sink);
+    }
+
+    return docIds.size();
+}
+
+/* Setter methods */
+
+void ExhaustiveScorer::setSectionWeights(
+    std::unordered_map<std::string, base::WeightType> const & sectionWeights)
+{
+    this->sectionWeights = sectionWeights;
+}
+
+void ExhaustiveScorer::setLMIRParameters(
+    float const lamb, ushort const mu, float const delta)
+{
+    this->lmirLamb = lamb;
+    this->lmirMu = mu;
+    this->lmirDelta = delta;
+}
+
+/* Getter methods */
+
+std::vector<base::FeatureKey> const & ExhaustiveScorer::getFeatureKeys() const
+{
+    return this->plan.getFeatureKeys();
+}
+
+std::size_t ExhaustiveScorer::DocumentView::getDocLen() const
+{
+    return this->fullDocLen;
+}
+
+std::size_t ExhaustiveScorer::DocumentView::getDocLen(
+    std::string const & section) const
+{
+    return this->index->getDocLen(this->docId, section);
+}
+
+std::size_t ExhaustiveScorer::DocumentView::getMaxTF() const
+{
+    return this->maxTF;
+}
+
+ExhaustiveScorer::DocumentView::TermFrequencyMap const &
+    ExhaustiveScorer::DocumentView::getTermFrequencyMap(
+        std::string const & section) const
+{
+    for (auto const & mapPair : this->sectionTfMaps)
+    {
+        if (mapPair.first == section) return mapPair.second;
+    }
+
+    return this->emptyTfMap;
+}
+
+std::vector<std::pair<
+    std::string, ExhaustiveScorer::DocumentView::TermFrequencyMap>> const &
+    ExhaustiveScorer::DocumentView::getStructuredTermFrequencyMap() const
+{
+    return this->sectionTfMaps;
+}
+
+/* Private class methods */
+
+void ExhaustiveScorer::initQueryState(
+    base::StrSizeMap const & queryTfMap, QueryState & state) const
+{
+    state.queryFlatMap =
+        base::FlatStrSizeMap(queryTfMap.begin(), queryTfMap.end());
+
+    // Ids of the indexed query terms, in query term order
+    std::vector<std::pair<std::string_view, base::TermId>> queryTermIds;
+    for (auto const & mapPair : state.queryFlatMap)
+    {
+        base::TermId termId;
+        if (this->index->findTermId(mapPair.first, termId))
+            queryTermIds.emplace_back(mapPair.first, termId);
+    }
+
+    state.doc.index = this->index;
+
+    // Open a cursor on the postings of every query term in every section
+    auto const & lmirSections = this->plan.getLMIRSections();
+    for (auto const & sectionKey : this->index->getSectionKeys())
+    {
+        std::size_t const sectionIdx = state.doc.sectionTfMaps.size();
+        if (sectionKey == "full") state.fullSectionIdx = sectionIdx;
+
+        state.doc.sectionTfMaps.emplace_back(
+            sectionKey, DocumentView::TermFrequencyMap());
+        state.doc.sectionTfMaps.back().second.reserve(queryTermIds.size());
+
+        base::StrSizeMap & nDocsWithTermMap =
+            state.nDocsWithTermPerSection[sectionKey];
+        base::StrSizeMap corpusTfMap;
+        for (auto const & [term, termId] : queryTermIds)
+        {
+            auto const * termPostings =
+                this->index->findPostings(sectionKey, termId);
+            if (termPostings == nullptr) continue;
+
+            std::string const termStr(term);
+            nDocsWithTermMap[termStr] = termPostings->postings.size();
+            corpusTfMap[termStr] = termPostings->tfSum;
+
+            state.cursors.push_back({termPostings, 0, sectionIdx, term});
+        }
+
+        state.avgDocLenPerSection[sectionKey] =
+            this->index->getAvgDocLen(sectionKey);
+        state.nTermsPerSection[sectionKey] =
+            utils::mapValueSum(nDocsWithTermMap);
+
+        if (std::find(lmirSections.begin(), lmirSections.end(), sectionKey) !=
+            lmirSections.end())
+        {
+            LMIR & lime =
+                state.lmirCalculators.try_emplace(sectionKey, corpusTfMap)
+                    .first->second;
+            lime.lamb = this->lmirLamb;
+            lime.mu = this->lmirMu;
+            lime.delta = this->lmirDelta;
+        }
+    }
+
+    state.stats.numDocs = this->index->getNumDocs();
+    state.stats.queryTfMap = &state.queryFlatMap;
+    state.stats.nDocsWithTermPerSection = &state.nDocsWithTermPerSection;
+    state.stats.avgDocLenPerSection = &state.avgDocLenPerSection;
+    state.stats.nTermsPerSection = &state.nTermsPerSection;
+    state.stats.sectionWeights = &this->sectionWeights;
+    state.stats.lmirCalculators = &state.lmirCalculators;
+}
+
+void ExhaustiveScorer::scoreDocument(
+    base::DocId const docId, QueryState & state, FeaturePlan::Context & ctx,
+    std::vector<base::FValType> & fValVect, RowSink const & sink) const
+{
+    DocumentView & doc = state.doc;
+    doc.docId = docId;
+    doc.fullDocLen = this->index->getDocLen(docId, "full");
+    doc.maxTF =
+        utils::findMaxValuePair(doc.sectionTfMaps[state.fullSectionIdx].second)
+            .second;
+
+    this->plan.evaluate(ctx, doc, fValVect.data());
+    sink(docId, fValVect);
+}
+
+base::DocId ExhaustiveScorer::Cursor::docId() const
+{
+    auto const & postings = this->termPostings->postings;
+
+    return (this->pos < postings.size())
+               ? postings[this->pos].docId
+               : std::numeric_limits<base::DocId>::max();
+}
+
+}  // namespace lowletorfeats
@@ -0,0 +1,247 @@
+#include <algorithm>  // max, sort
+#include <limits>
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <lowletorfeats/utils.hpp>
+#include <stdexcept>
+#include <textalyzer/utils.hpp>
+
+namespace lowletorfeats
+{
+/* Constructors */
+
+InvertedIndex::InvertedIndex() {}
+
+InvertedIndex::InvertedIndex(
+    std::vector<base::StrStrMap> const & docTextMapVect)
+{
+    this->addDocs(docTextMapVect);
+}
+
+InvertedIndex::InvertedIndex(
+    std::vector<base::StrSizeMap> const & docLenMapVect,
+    std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect)
+{
+    this->addDocs(docLenMapVect, docTfMapVect);
+}
+
+/* Public class methods */
+
+void InvertedIndex::addDocs(
+    std::vector<base::StrStrMap> const & docTextMapVect)
+{
+    this->docLenMaps.reserve(this->docLenMaps.size() + docTextMapVect.size());
+    this->docTermVects.reserve(
+        this->docTermVects.size() + docTextMapVect.size());
+
+    for (auto const & docTextMap : docTextMapVect)  // for each document
+    {
+        base::StrSizeMap docLenMap;
+        base::StructuredTermFrequencyMap docTfMap;
+
+        // Analyze the text of each section
+        for (auto const & [sectionKey, sectionText] : docTextMap)
+        {
+            auto const & pair = InvertedIndex::analyzerFun(
+                sectionText, InvertedIndex::DEFAULT_NGRAMS);
+            docLenMap[sectionKey] = pair.second;
+
+            auto const sectionFreqMap = textalyzer::asFrequencyMap(pair.first);
+            docTfMap[sectionKey].insert(
+                sectionFreqMap.begin(), sectionFreqMap.end());
+        }
+
+        this->addDoc(docLenMap, docTfMap);
+    }
+}
+
+void InvertedIndex::addDocs(
+    std::vector<base::StrSizeMap> const & docLenMapVect,
+    std::vector<base::StructuredTermFrequencyMap> const & docTfMapVect)
+{
+    this->docLenMaps.reserve(this->docLenMaps.size() + docTfMapVect.size());
+    this->docTermVects.reserve(
+        this->docTermVects.size() + docTfMapVect.size());
+
+    for (std::size_t docIdx = 0; docIdx < docTfMapVect.size(); ++docIdx)
+        this->addDoc(docLenMapVect.at(docIdx), docTfMapVect.at(docIdx));
+}
+
+void InvertedIndex::getDocument(
+    base::DocId const docId, base::StrSizeMap & docLenMap,
+    base::StructuredTermFrequencyMap & docTfMap) const
+{
+    auto const & docLens = this->docLenMaps.at(docId);
+    docLenMap.insert(docLens.begin(), docLens.end());
+
+    for (auto const & [sectionKey, termVect] : this->docTermVects.at(docId))
+    {
+        base::StrSizeMap & sectionTfMap = docTfMap[sectionKey];
+        sectionTfMap.reserve(termVect.size());
+        for (auto const & [termId, count] : termVect)
+            sectionTfMap.emplace(this->terms[termId], count);
+    }
+}
+
+base::StrSizeMap InvertedIndex::analyzeQuery(std::string const & queryText)
+{
+    auto const queryFreqMap = textalyzer::asFrequencyMap(
+        InvertedIndex::analyzerFun(queryText, InvertedIndex::DEFAULT_NGRAMS)
+            .first);
+
+    return base::StrSizeMap(queryFreqMap.begin(), queryFreqMap.end());
+}
+
+/* Getter methods */
+
+std::size_t InvertedIndex::getNumDocs() const
+{
+    return this->docLenMaps.size();
+}
+
+std::size_t InvertedIndex::getNumTerms() const { return this->terms.size(); }
+
+bool InvertedIndex::hasSection(std::string const & sectionKey) const
+{
+    return this->sections.count(sectionKey) != 0;
+}
+
+std::vector<std::string> InvertedIndex::getSectionKeys() const
+{
+    std::vector<std::string> sectionKeys;
+    sectionKeys.reserve(this->sections.size());
+    for (auto const & mapPair : this->sections)
+        sectionKeys.push_back(mapPair.first);
+
+    std::sort(sectionKeys.begin(), sectionKeys.end());
+    return sectionKeys;
+}
+
+float InvertedIndex::getAvgDocLen(std::string const & sectionKey) const
+{
+    return static_cast<float>(this->sections.at(sectionKey).docLenSum) /
+           static_cast<float>(this->getNumDocs());
+}
+
+std::size_t InvertedIndex::getDocLen(
+    base::DocId const docId, std::string const & sectionKey) const
+{
+    auto const & docLens = this->docLenMaps.at(docId);
+
+    auto const lenIt = docLens.find(sectionKey);
+    return (lenIt != docLens.end()) ? lenIt->second : 0;
+}
+
+bool InvertedIndex::findTermId(
+    std::string const & term, base::TermId & termId) const
+{
+    auto const idIt = this->termIds.find(term);
+    if (idIt == this->termIds.end()) return false;
+
+    termId = idIt->second;
+    return true;
+}
+
+std::string const & InvertedIndex::getTerm(base::TermId const termId) const
+{
+    return this->terms.at(termId);
+}
+
+InvertedIndex::TermPostings const * InvertedIndex::findPostings(
+    std::string const & sectionKey, base::TermId const termId) const
+{
+    auto const sectionIt = this->sections.find(sectionKey);
+    if (sectionIt == this->sections.end()) return nullptr;
+
+    auto const & postingsMap = sectionIt->second.postingsMap;
+    auto const postingsIt = postingsMap.find(termId);
+    return (postingsIt != postingsMap.end()) ? &postingsIt->second : nullptr;
+}
+
+/* Private static member variables */
+
+textalyzer::AnlyzerFunType<std::string> InvertedIndex::analyzerFun =
+    textalyzer::Analyzer::medAnalyze;
+
+uint8_t const InvertedIndex::DEFAULT_NGRAMS = 2;
+
+/* Private class methods */
+
+void InvertedIndex::addDoc(
+    base::StrSizeMap const & docLenMap,
+    base::StructuredTermFrequencyMap const & docTfMap)
+{
+    if (this->docLenMaps.size() >= std::numeric_limits<base::DocId>::max())
+        throw std::runtime_error("Too many documents for `base::DocId`");
+    auto const docId = static_cast<base::DocId>(this->docLenMaps.size());
+
+    base::StrSizeMap & docLens = this->docLenMaps.emplace_back(docLenMap);
+
+    // Postings are appended in docId order, so every list stays sorted
+    auto & docTermVect = this->docTermVects.emplace_back();
+    for (auto const & [sectionKey, sectionTfMap] : docTfMap)
+    {
+        base::TermCountVector & termVect = docTermVect[sectionKey];
+        termVect.reserve(sectionTfMap.size());
+
+        this->addSection(docId, sectionKey, sectionTfMap);
+
+        for (auto const & [term, count] : sectionTfMap)
+            termVect.emplace_back(this->internTerm(term), count);
+        std::sort(termVect.begin(), termVect.end());
+    }
+
+    // Merge the other sections into "full" if missing, as done by
+    //  `StructuredDocument`. Only its postings are stored, the document is
+    //  reconstructed without it
+    if (docTfMap.count("full") == 0)
+    {
+        docLens.erase("full");
+        std::size_t const fullLen = utils::mapValueSum(docLens);
+        docLens["full"] = fullLen;
+
+        base::StrSizeMap fullTfMap;
+        for (auto const & mapPair : docTfMap)
+            utils::additiveMergeInplace(fullTfMap, mapPair.second);
+
+        this->addSection(docId, "full", fullTfMap);
+    }
+
+    for (auto const & [sectionKey, sectionLen] : docLens)
+        this->sections[sectionKey].docLenSum += sectionLen;
+}
+
+void InvertedIndex::addSection(
+    base::DocId const docId, std::string const & sectionKey,
+    base::StrSizeMap const & sectionTfMap)
+{
+    Section & section = this->sections[sectionKey];
+
+    for (auto const & [term, count] : sectionTfMap)
+    {
+        auto const tf = static_cast<std::uint32_t>(count);
+        TermPostings & termPostings =
+            section.postingsMap[this->internTerm(term)];
+        termPostings.postings.push_back({docId, tf});
+        termPostings.maxTf = std::max(termPostings.maxTf, tf);
+        termPostings.tfSum += count;
+
+        // Open a new block every `BLOCK_SIZE` postings
+        if (termPostings.postings.size() % InvertedIndex::BLOCK_SIZE == 1)
+            termPostings.blocks.push_back({docId, tf});
+
+        PostingsBlock & block = termPostings.blocks.back();
+        block.lastDocId = docId;
+        block.maxTf = std::max(block.maxTf, tf);
+    }
+}
+
+base::TermId InvertedIndex::internTerm(std::string const & term)
+{
+    auto const [idIt, isNew] = this->termIds.try_emplace(
+        term, static_cast<base::TermId>(this->terms.size()));
+    if (isNew) this->terms.push_back(term);
+
+    return idIt->second;
+}
+
+}  // namespace lowletorfeats
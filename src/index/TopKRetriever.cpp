@@ -0,0 +1,245 @@
+#include <algorithm>  // min, push_heap, pop_heap, sort
+#include <limits>
+#include <lowletorfeats/Okapi.hpp>
+#include <lowletorfeats/Tfidf.hpp>
+#include <lowletorfeats/TopKRetriever.hpp>
+#include <lowletorfeats/utils.hpp>
+
+namespace lowletorfeats
+{
+/* Constructors */
+
+TopKRetriever::TopKRetriever(
+    InvertedIndex const & index, std::string const & sectionKey,
+    Model const model)
+    : index(&index), sectionKey(sectionKey), model(model)
+{
+}
+
+/* Public class methods */
+
+std::vector<ScoredDoc> TopKRetriever::retrieve(
+    std::string const & queryText, std::size_t const k) const
+{
+    return this->retrieve(InvertedIndex::analyzeQuery(queryText), k);
+}
+
+std::vector<ScoredDoc> TopKRetriever::retrieve(
+    base::StrSizeMap const & queryTfMap, std::size_t const k) const
+{
+    std::vector<ScoredDoc> topDocs;
+    if (k == 0 || !this->index->hasSection(this->sectionKey)) return topDocs;
+
+    std::size_t const numDocs = this->index->getNumDocs();
+    float const avgDocLen = this->index->getAvgDocLen(this->sectionKey);
+
+    // Open a cursor on the postings of every query term in the section
+    std::vector<Cursor> cursors;
+    cursors.reserve(queryTfMap.size());
+    for (auto const & mapPair : queryTfMap)
+    {
+        base::TermId termId;
+        if (!this->index->findTermId(mapPair.first, termId)) continue;
+
+        auto const * termPostings =
+            this->index->findPostings(this->sectionKey, termId);
+        if (termPostings == nullptr) continue;
+
+        base::FValType const idf =
+            Tfidf::idfNorm(numDocs, termPostings->postings.size());
+
+        // Term scores grow with tf, a negative idf can only lower a score
+        base::FValType const upperBound =
+            (idf > 0)
+                ? this->termScore(termPostings->maxTf, idf, numDocs, avgDocLen)
+                : 0;
+
+        cursors.push_back({termPostings, 0, 0, idf, upperBound});
+    }
+
+    // Ranking order, ties go to the lowest docId
+    auto const isBetter = [](ScoredDoc const & a, ScoredDoc const & b) {
+        return a.score > b.score || (a.score == b.score && a.docId < b.docId);
+    };
+
+    // Heap of the best documents so far, the k-th best on top
+    topDocs.reserve(k);
+
+    std::vector<Cursor *> cursorOrder;
+    cursorOrder.reserve(cursors.size());
+    for (auto & cursor : cursors) cursorOrder.push_back(&cursor);
+
+    base::DocId const endDocId = std::numeric_limits<base::DocId>::max();
+    while (true)
+    {
+        std::sort(
+            cursorOrder.begin(), cursorOrder.end(),
+            [](Cursor const * a, Cursor const * b) {
+                return a->docId() < b->docId();
+            });
+
+        // Documents are visited in increasing docId, so a later document
+        //  tying the k-th score never enters
+        bool const isFull = topDocs.size() == k;
+        base::FValType const threshold = isFull ? topDocs.front().score : 0;
+
+        // Find the first document whose score may beat the threshold
+        std::size_t pivot = cursorOrder.size();
+        base::FValType boundSum = 0;
+        for (std::size_t i = 0; i < cursorOrder.size(); ++i)
+        {
+            if (cursorOrder[i]->docId() == endDocId) break;
+
+            boundSum += cursorOrder[i]->upperBound;
+            if (!isFull || boundSum > threshold)
+            {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == cursorOrder.size()) break;  // Nothing can enter anymore
+
+        // Every cursor on the pivot document can contribute to it
+        base::DocId const pivotDocId = cursorOrder[pivot]->docId();
+        while (pivot + 1 < cursorOrder.size() &&
+               cursorOrder[pivot + 1]->docId() == pivotDocId)
+            ++pivot;
+
+        // Bound the documents from the pivot on by the current blocks
+        base::FValType blockBoundSum = 0;
+        base::DocId blockEndDocId = endDocId;
+        if (isFull)
+        {
+            for (std::size_t i = 0; i <= pivot; ++i)
+            {
+                Cursor & cursor = *cursorOrder[i];
+
+                auto const * block = cursor.seekBlock(pivotDocId);
+                if (block == nullptr) continue;  // No posting left to score
+
+                if (cursor.idf > 0)
+                    blockBoundSum += this->termScore(
+                        block->maxTf, cursor.idf, numDocs, avgDocLen);
+                blockEndDocId = std::min(blockEndDocId, block->lastDocId);
+            }
+        }
+
+        if (isFull && blockBoundSum <= threshold)
+        {
+            // No document before the end of a current block, or the next
+            //  cursor, can enter: skip past them
+            base::DocId nextDocId = blockEndDocId;
+            if (nextDocId != endDocId) ++nextDocId;
+            if (pivot + 1 < cursorOrder.size())
+                nextDocId =
+                    std::min(nextDocId, cursorOrder[pivot + 1]->docId());
+
+            for (std::size_t i = 0; i <= pivot; ++i)
+                cursorOrder[i]->seek(nextDocId);
+        }
+        else if (cursorOrder.front()->docId() == pivotDocId)
+        {
+            // Score the pivot document, summing in query term order
+            ScoredDoc scoredDoc = {pivotDocId, 0};
+            for (auto & cursor : cursors)
+            {
+                if (cursor.docId() != pivotDocId) continue;
+
+                scoredDoc.score += this->termScore(
+                    cursor.termPostings->postings[cursor.pos].tf, cursor.idf,
+                    numDocs, avgDocLen);
+                ++cursor.pos;
+            }
+
+            if (!isFull)
+            {
+                topDocs.push_back(scoredDoc);
+                std::push_heap(topDocs.begin(), topDocs.end(), isBetter);
+            }
+            else if (scoredDoc.score > threshold)
+            {
+                std::pop_heap(topDocs.begin(), topDocs.end(), isBetter);
+                topDocs.back() = scoredDoc;
+                std::push_heap(topDocs.begin(), topDocs.end(), isBetter);
+            }
+        }
+        else
+        {
+            // No document before the pivot can enter, skip to it
+            for (std::size_t i = 0; i < pivot; ++i)
+                cursorOrder[i]->seek(pivotDocId);
+        }
+    }
+
+    std::sort(topDocs.begin(), topDocs.end(), isBetter);
+    return topDocs;
+}
+
+/* Static getter methods */
+
+std::vector<base::DocId> TopKRetriever::getDocIds(
+    std::vector<ScoredDoc> const & scoredDocVect)
+{
+    std::vector<base::DocId> docIdVect;
+    docIdVect.reserve(scoredDocVect.size());
+    for (auto const & scoredDoc : scoredDocVect)
+        docIdVect.push_back(scoredDoc.docId);
+
+    return docIdVect;
+}
+
+/* Private class methods */
+
+base::DocId TopKRetriever::Cursor::docId() const
+{
+    auto const & postings = this->termPostings->postings;
+
+    return (this->pos < postings.size())
+               ? postings[this->pos].docId
+               : std::numeric_limits<base::DocId>::max();
+}
+
+void TopKRetriever::Cursor::seek(base::DocId const targetDocId)
+{
+    auto const & postings = this->termPostings->postings;
+
+    auto const it = utils::gallopLowerBound(
+        postings.begin() + static_cast<std::ptrdiff_t>(this->pos),
+        postings.end(), targetDocId,
+        [](InvertedIndex::Posting const & posting, base::DocId const docId) {
+            return posting.docId < docId;
+        });
+    this->pos = static_cast<std::size_t>(it - postings.begin());
+}
+
+InvertedIndex::PostingsBlock const * TopKRetriever::Cursor::seekBlock(
+    base::DocId const targetDocId)
+{
+    auto const & blocks = this->termPostings->blocks;
+
+    auto const it = utils::gallopLowerBound(
+        blocks.begin() + static_cast<std::ptrdiff_t>(this->blockIdx),
+        blocks.end(), targetDocId,
+        [](InvertedIndex::PostingsBlock const & block,
+           base::DocId const docId) { return block.lastDocId < docId; });
+    this->blockIdx = static_cast<std::size_t>(it - blocks.begin());
+
+    return (it != blocks.end()) ? &*it : nullptr;
+}
+
+base::FValType TopKRetriever::termScore(
+    std::uint32_t const tf, base::FValType const idf,
+    std::size_t const numDocs, float const avgDocLen) const
+{
+    switch (this->model)
+    {
+        case Model::bm25plus:
+            return idf * Okapi::bm25plusTfNorm(tf, numDocs, avgDocLen);
+
+        case Model::bm25:
+        default:
+            return idf * Okapi::bm25TfNorm(tf, numDocs, avgDocLen);
+    }
+}
+
+}  // namespace lowletorfeats
@@ -0,0 +1,454 @@
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, madvise, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, sysconf
+
+#include <cctype>  // isalpha, isdigit
+#include <cerrno>
+#include <charconv>  // from_chars
+#include <cstring>   // memchr, strerror
+#include <lowletorfeats/DocumentReader.hpp>
+#include <stdexcept>
+
+namespace lowletorfeats
+{
+namespace
+{
+/**
+ * @brief Cursor over the JSON object of a line. Strings without escapes are
+ *  viewed in place, others are unescaped into `unescapedStrs`.
+ *
+ */
+class JsonCursor
+{
+public:
+    JsonCursor(
+        std::string_view const text, std::deque<std::string> & unescapedStrs)
+        : ptr(text.data()),
+          end(text.data() + text.size()),
+          unescapedStrs(unescapedStrs)
+    {
+    }
+
+    void skipWhitespace()
+    {
+        while (this->ptr != this->end &&
+               (*this->ptr == ' ' || *this->ptr == '\t' ||
+                *this->ptr == '\r' || *this->ptr == '\n'))
+            ++this->ptr;
+    }
+
+    char peek()
+    {
+        this->skipWhitespace();
+        if (this->ptr == this->end)
+            throw std::runtime_error("Unexpected end of line");
+
+        return *this->ptr;
+    }
+
+    /**
+     * @brief Consume the given character if it is next.
+     *
+     */
+    bool accept(char const c)
+    {
+        if (this->peek() != c) return false;
+
+        ++this->ptr;
+        return true;
+    }
+
+    void expect(char const c)
+    {
+        if (!this->accept(c))
+            throw std::runtime_error(std::string("Expected '") + c + "'");
+    }
+
+    bool isAtEnd()
+    {
+        this->skipWhitespace();
+        return this->ptr == this->end;
+    }
+
+    std::string_view parseString()
+    {
+        this->expect('"');
+
+        char const * const first = this->ptr;
+        while (this->ptr != this->end && *this->ptr != '"' &&
+               *this->ptr != '\\')
+            ++this->ptr;
+        if (this->ptr == this->end)
+            throw std::runtime_error("Unterminated string");
+        if (*this->ptr == '"')
+            return std::string_view(first, this->ptr++ - first);
+
+        // Unescape from the first escape on
+        std::string & outStr =
+            this->unescapedStrs.emplace_back(first, this->ptr);
+        while (true)
+        {
+            if (this->ptr == this->end)
+                throw std::runtime_error("Unterminated string");
+
+            char const c = *this->ptr++;
+            if (c == '"') break;
+            if (c != '\\')
+            {
+                outStr += c;
+                continue;
+            }
+
+            if (this->ptr == this->end)
+                throw std::runtime_error("Unterminated string");
+            switch (char const escaped = *this->ptr++)
+            {
+                case 'b':
+                    outStr += '\b';
+                    break;
+                case 'f':
+                    outStr += '\f';
+                    break;
+                case 'n':
+                    outStr += '\n';
+                    break;
+                case 'r':
+                    outStr += '\r';
+                    break;
+                case 't':
+                    outStr += '\t';
+                    break;
+                case 'u':
+                    this->appendCodePoint(outStr);
+                    break;
+                case '"':
+                case '\\':
+                case '/':
+                    outStr += escaped;
+                    break;
+                default:
+                    throw std::runtime_error("Invalid string escape");
+            }
+        }
+
+        return outStr;
+    }
+
+    /**
+     * @brief View the characters of a number.
+     *
+     */
+    std::string_view parseNumber()
+    {
+        this->skipWhitespace();
+
+        char const * const first = this->ptr;
+        while (this->ptr != this->end &&
+               (std::isdigit(static_cast<unsigned char>(*this->ptr)) ||
+                *this->ptr == '-' || *this->ptr == '+' || *this->ptr == '.' ||
+                *this->ptr == 'e' || *this->ptr == 'E'))
+            ++this->ptr;
+        if (this->ptr == first) throw std::runtime_error("Expected a value");
+
+        return std::string_view(first, this->ptr - first);
+    }
+
+    /**
+     * @brief Parse a string, or view the characters of a number.
+     *
+     */
+    std::string_view parseId()
+    {
+        return (this->peek() == '"') ? this->parseString()
+                                     : this->parseNumber();
+    }
+
+    void skipValue()
+    {
+        char const c = this->peek();
+        if (c == '"')
+            this->parseString();
+        else if (c == '{' || c == '[')
+        {
+            char const close = (c == '{') ? '}' : ']';
+            ++this->ptr;
+            if (this->accept(close)) return;
+            do
+            {
+                if (c == '{')
+                {
+                    this->parseString();
+                    this->expect(':');
+                }
+                this->skipValue();
+            } while (this->accept(','));
+            this->expect(close);
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)))
+        {
+            // true, false or null
+            while (this->ptr != this->end &&
+                   std::isalpha(static_cast<unsigned char>(*this->ptr)))
+                ++this->ptr;
+        }
+        else
+            this->parseNumber();
+    }
+
+private:
+    char const * ptr;
+    char const * end;
+    std::deque<std::string> & unescapedStrs;
+
+    unsigned parseHex4()
+    {
+        if (this->end - this->ptr < 4)
+            throw std::runtime_error("Invalid unicode escape");
+
+        unsigned codeUnit = 0;
+        auto const [hexEnd, errc] =
+            std::from_chars(this->ptr, this->ptr + 4, codeUnit, 16);
+        if (errc != std::errc() || hexEnd != this->ptr + 4)
+            throw std::runtime_error("Invalid unicode escape");
+        this->ptr += 4;
+
+        return codeUnit;
+    }
+
+    /**
+     * @brief Append the UTF-8 of a `\u` escape, with its surrogate pair.
+     *
+     */
+    void appendCodePoint(std::string & outStr)
+    {
+        unsigned codePoint = this->parseHex4();
+        if (codePoint >= 0xD800 && codePoint < 0xDC00 &&
+            this->end - this->ptr >= 2 && this->ptr[0] == '\\' &&
+            this->ptr[1] == 'u')
+        {
+            this->ptr += 2;
+            unsigned const lowSurrogate = this->parseHex4();
+            if (lowSurrogate < 0xDC00 || lowSurrogate >= 0xE000)
+                throw std::runtime_error("Invalid unicode escape");
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) +
+                        (lowSurrogate - 0xDC00);
+        }
+
+        if (codePoint < 0x80)
+            outStr += static_cast<char>(codePoint);
+        else if (codePoint < 0x800)
+        {
+            outStr += static_cast<char>(0xC0 | (codePoint >> 6));
+            outStr += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            outStr += static_cast<char>(0xE0 | (codePoint >> 12));
+            outStr += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            outStr += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            outStr += static_cast<char>(0xF0 | (codePoint >> 18));
+            outStr += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            outStr += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            outStr += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+};
+
+bool isBlank(std::string_view const line)
+{
+    return line.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+}  // namespace
+
+/* Constructors */
+
+DocumentReader::DocumentReader(std::string const & path)
+{
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error(
+            "Could not open '" + path + "': " + std::strerror(errno));
+
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error(
+            "Could not stat '" + path + "': " + std::strerror(errno));
+    }
+    this->size = static_cast<std::size_t>(fileStat.st_size);
+    if (this->size == 0)  // Nothing to map
+    {
+        ::close(fd);
+        return;
+    }
+
+    void * const fileMap =
+        ::mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (fileMap == MAP_FAILED)
+        throw std::runtime_error(
+            "Could not map '" + path + "': " + std::strerror(errno));
+    ::madvise(fileMap, this->size, MADV_SEQUENTIAL);
+
+    this->data = static_cast<char const *>(fileMap);
+}
+
+DocumentReader::~DocumentReader()
+{
+    if (this->data != nullptr)
+        ::munmap(const_cast<char *>(this->data), this->size);
+}
+
+/* Public class methods */
+
+bool DocumentReader::next(QueryGroup & group)
+{
+    this->releasePages();
+    this->unescapedStrs.clear();
+
+    group.qid = std::string_view();
+    group.query = std::string_view();
+    group.docIds.clear();
+    group.labels.clear();
+
+    std::size_t numDocs = 0;
+    LineFields fields;
+    while (this->pos < this->size)
+    {
+        char const * const first = this->data + this->pos;
+        char const * newline = static_cast<char const *>(
+            std::memchr(first, '\n', this->size - this->pos));
+        char const * const last =
+            (newline != nullptr) ? newline : this->data + this->size;
+        std::size_t const nextPos =
+            static_cast<std::size_t>(last - this->data) + 1;
+
+        std::string_view const line(first, last - first);
+        if (isBlank(line))
+        {
+            this->pos = nextPos;
+            ++this->lineNum;
+            continue;
+        }
+
+        // Parse into a reused document
+        if (numDocs == group.docs.size()) group.docs.emplace_back();
+        base::StrViewPairVector & sections = group.docs[numDocs];
+        sections.clear();
+        try
+        {
+            this->parseLine(line, fields, sections);
+        }
+        catch (std::runtime_error const & e)
+        {
+            // Return the complete group, the line is parsed again by the next
+            //  call and reported then
+            if (numDocs > 0) break;
+
+            throw std::runtime_error(
+                "Line " + std::to_string(this->lineNum + 1) + ": " +
+                e.what());
+        }
+
+        // The line starts the next group
+        if (numDocs > 0 && fields.qid != group.qid) break;
+
+        this->pos = nextPos;
+        ++this->lineNum;
+        ++numDocs;
+
+        if (numDocs == 1) group.qid = fields.qid;
+        if (group.query.empty()) group.query = fields.query;
+        group.docIds.push_back(fields.docId);
+        group.labels.push_back(fields.label);
+    }
+    group.docs.resize(numDocs);
+
+    return numDocs > 0;
+}
+
+/* Private class methods */
+
+void DocumentReader::parseLine(
+    std::string_view const line, LineFields & fields,
+    base::StrViewPairVector & sections)
+{
+    fields = LineFields{{}, {}, {}, 0};
+    bool hasQid = false;
+
+    JsonCursor cursor(line, this->unescapedStrs);
+    cursor.expect('{');
+    if (!cursor.accept('}'))
+    {
+        do
+        {
+            std::string_view const key = cursor.parseString();
+            cursor.expect(':');
+
+            if (key == "qid")
+            {
+                fields.qid = cursor.parseId();
+                hasQid = true;
+            }
+            else if (key == "docid")
+                fields.docId = cursor.parseId();
+            else if (key == "query")
+                fields.query = cursor.parseString();
+            else if (key == "label")
+            {
+                std::string_view const labelStr = cursor.parseNumber();
+                auto const [labelEnd, errc] = std::from_chars(
+                    labelStr.data(), labelStr.data() + labelStr.size(),
+                    fields.label);
+                if (errc != std::errc() ||
+                    labelEnd != labelStr.data() + labelStr.size())
+                    throw std::runtime_error("Invalid label");
+            }
+            else if (key == "sections")
+            {
+                cursor.expect('{');
+                if (!cursor.accept('}'))
+                {
+                    do
+                    {
+                        std::string_view const sectionKey =
+                            cursor.parseString();
+                        cursor.expect(':');
+                        sections.emplace_back(
+                            sectionKey, cursor.parseString());
+                    } while (cursor.accept(','));
+                    cursor.expect('}');
+                }
+            }
+            else
+                cursor.skipValue();
+        } while (cursor.accept(','));
+        cursor.expect('}');
+    }
+
+    if (!cursor.isAtEnd())
+        throw std::runtime_error("Unexpected characters after the document");
+    if (!hasQid) throw std::runtime_error("Missing \"qid\"");
+}
+
+void DocumentReader::releasePages()
+{
+    static std::size_t const pageSize =
+        static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    std::size_t const releaseEnd = this->pos / pageSize * pageSize;
+    if (releaseEnd <= this->releasedPos) return;
+
+    ::madvise(
+        const_cast<char *>(this->data) + this->releasedPos,
+        releaseEnd - this->releasedPos, MADV_DONTNEED);
+    this->releasedPos = releaseEnd;
+}
+
+}  // namespace lowletorfeats
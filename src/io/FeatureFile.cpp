@@ -0,0 +1,633 @@
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // pwrite, close, unlink
+
+#include <algorithm>  // min
+#include <cerrno>
+#include <cstdlib>  // mkstemp
+#include <cstring>  // memcpy, memcmp, strerror
+#include <lowletorfeats/FeatureFile.hpp>
+#include <stdexcept>
+
+namespace lowletorfeats
+{
+namespace featurefile
+{
+char const MAGIC[8] = {'L', 'L', 'T', 'R', 'F', 'E', 'A', 'T'};
+
+}  // namespace featurefile
+
+namespace
+{
+std::runtime_error systemError(std::string const & what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void writeAll(
+    int const fd, char const * src, std::size_t n, std::uint64_t offset)
+{
+    while (n > 0)
+    {
+        ssize_t const nChars =
+            ::pwrite(fd, src, n, static_cast<off_t>(offset));
+        if (nChars < 0)
+        {
+            if (errno == EINTR) continue;
+            throw systemError("Could not write feature file");
+        }
+
+        src += nChars;
+        n -= static_cast<std::size_t>(nChars);
+        offset += static_cast<std::uint64_t>(nChars);
+    }
+}
+
+/**
+ * @brief Buffered sequential writes from a given file offset.
+ *
+ */
+class SectionWriter
+{
+public:
+    SectionWriter(int const fd, std::uint64_t const offset)
+        : fd(fd), offset(offset)
+    {
+    }
+
+    void write(void const * src, std::size_t const n)
+    {
+        char const * const srcChars = static_cast<char const *>(src);
+        this->buffer.insert(this->buffer.end(), srcChars, srcChars + n);
+        if (this->buffer.size() >= (1 << 16)) this->flush();
+    }
+
+    void writeUint64(std::uint64_t const value)
+    {
+        this->write(&value, sizeof(value));
+    }
+
+    void writeValue(
+        base::FValType const value, featurefile::ValueType const valueType)
+    {
+        if (valueType == featurefile::ValueType::float32)
+        {
+            float const fltValue = static_cast<float>(value);
+            this->write(&fltValue, sizeof(fltValue));
+        }
+        else
+            this->write(&value, sizeof(value));
+    }
+
+    /**
+     * @brief Write `n + 1` offsets then the characters of the strings.
+     *
+     */
+    template <class StrVect>
+    void writeStringTable(StrVect const & strVect)
+    {
+        std::uint64_t charOffset = 0;
+        this->writeUint64(charOffset);
+        for (auto const & str : strVect)
+        {
+            charOffset += str.size();
+            this->writeUint64(charOffset);
+        }
+        for (auto const & str : strVect) this->write(str.data(), str.size());
+        this->align();
+    }
+
+    // Pad to a multiple of 8 bytes
+    void align()
+    {
+        while (this->tell() % 8 != 0) this->buffer.push_back('\0');
+    }
+
+    std::uint64_t tell() const { return this->offset + this->buffer.size(); }
+
+    void flush()
+    {
+        writeAll(
+            this->fd, this->buffer.data(), this->buffer.size(), this->offset);
+        this->offset += this->buffer.size();
+        this->buffer.clear();
+    }
+
+private:
+    int fd;
+    std::uint64_t offset;
+    std::vector<char> buffer;
+};
+
+}  // namespace
+
+/* FeatureFileWriter constructors */
+
+FeatureFileWriter::FeatureFileWriter(
+    std::string const & path, std::vector<base::FeatureKey> const & fKeys,
+    featurefile::ValueType const valueType)
+    : path(path), fKeys(fKeys), valueType(valueType), queryOffsets({0})
+{
+    this->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (this->fd < 0) throw systemError("Could not open '" + path + "'");
+
+    // The spool gets a new unique name next to the output, never an existing
+    //  file, and disappears with its descriptor, even on a crash
+    std::size_t const dirEnd = path.rfind('/');
+    std::string spoolPath =
+        ((dirEnd == std::string::npos) ? "." : path.substr(0, dirEnd)) +
+        "/.lowletorfeats-XXXXXX";
+    this->spoolFd = ::mkstemp(spoolPath.data());
+    if (this->spoolFd < 0)
+    {
+        std::runtime_error const error =
+            systemError("Could not create a spool file for '" + path + "'");
+        ::close(this->fd);
+        throw error;
+    }
+    ::unlink(spoolPath.c_str());
+
+    this->rowBuffer.reserve(FeatureFileWriter::BUFFER_SIZE);
+}
+
+FeatureFileWriter::~FeatureFileWriter()
+{
+    try
+    {
+        this->close();
+    }
+    catch (std::runtime_error const &)
+    {
+    }
+}
+
+/* FeatureFileWriter public class methods */
+
+void FeatureFileWriter::writeQuery(
+    FeatureMatrix & fMatrix, std::string_view const qid,
+    std::vector<base::FValType> const & labels,
+    std::vector<std::string> const & docIds)
+{
+    if (this->fd < 0) throw std::runtime_error("Writing to a closed writer");
+    if (fMatrix.getFeatureKeys() != this->fKeys)
+        throw std::runtime_error("Features differ from the file schema");
+
+    std::size_t const numDocs = fMatrix.getNumDocs();
+    if (!labels.empty() && labels.size() != numDocs)
+        throw std::runtime_error("Expected a label for every document");
+    if (!docIds.empty() && docIds.size() != numDocs)
+        throw std::runtime_error("Expected an id for every document");
+
+    this->startQuery(qid);
+    this->rowScratch.resize(this->fKeys.size());
+    for (std::size_t docIdx = 0; docIdx < numDocs; ++docIdx)
+    {
+        fMatrix.copyRow(docIdx, this->rowScratch.data());
+        this->appendRow(
+            labels.empty() ? 0 : labels[docIdx], this->rowScratch.data(),
+            docIds.empty() ? std::string_view() : docIds[docIdx]);
+    }
+}
+
+void FeatureFileWriter::writeRow(
+    base::FValType const label, std::string_view const qid,
+    base::FValType const * fValues, std::string_view const docId)
+{
+    if (this->fd < 0) throw std::runtime_error("Writing to a closed writer");
+
+    if (this->qids.empty() || this->qids.back() != qid)
+        this->startQuery(qid);
+    this->appendRow(label, fValues, docId);
+}
+
+void FeatureFileWriter::close()
+{
+    if (this->fd < 0) return;
+
+    try
+    {
+        this->flushRows();
+        if (!this->qids.empty())
+            this->queryOffsets.push_back(this->getNumDocs());
+
+        featurefile::Header header{};
+        this->writeSections(header);
+        this->writeColumns(header.columnOffset);
+    }
+    catch (std::runtime_error const &)
+    {
+        ::close(this->spoolFd);
+        ::close(this->fd);
+        this->fd = -1;
+        throw;
+    }
+
+    ::close(this->spoolFd);
+    int const closeResult = ::close(this->fd);
+    this->fd = -1;
+    if (closeResult != 0)
+        throw systemError("Could not close '" + this->path + "'");
+}
+
+/* FeatureFileWriter getter methods */
+
+std::size_t FeatureFileWriter::getNumDocs() const
+{
+    return this->docIds.size();
+}
+
+std::size_t FeatureFileWriter::getNumFeatures() const
+{
+    return this->fKeys.size();
+}
+
+/* FeatureFileWriter private static member variables */
+
+std::size_t const FeatureFileWriter::BUFFER_SIZE = 1 << 22;
+
+/* FeatureFileWriter private class methods */
+
+void FeatureFileWriter::startQuery(std::string_view const qid)
+{
+    if (!this->qids.empty()) this->queryOffsets.push_back(this->getNumDocs());
+    this->qids.emplace_back(qid);
+}
+
+void FeatureFileWriter::appendRow(
+    base::FValType const label, base::FValType const * fValues,
+    std::string_view const docId)
+{
+    this->labels.push_back(label);
+    this->docIds.emplace_back(docId);
+
+    if (this->valueType == featurefile::ValueType::float32)
+    {
+        for (std::size_t i = 0; i < this->fKeys.size(); ++i)
+        {
+            float const fltValue = static_cast<float>(fValues[i]);
+            char const * const src = reinterpret_cast<char const *>(&fltValue);
+            this->rowBuffer.insert(
+                this->rowBuffer.end(), src, src + sizeof(fltValue));
+        }
+    }
+    else
+    {
+        char const * const src = reinterpret_cast<char const *>(fValues);
+        this->rowBuffer.insert(
+            this->rowBuffer.end(), src,
+            src + this->fKeys.size() * sizeof(base::FValType));
+    }
+
+    if (this->rowBuffer.size() >= FeatureFileWriter::BUFFER_SIZE)
+        this->flushRows();
+}
+
+void FeatureFileWriter::flushRows()
+{
+    // The spool is only appended to
+    off_t const spoolSize = ::lseek(this->spoolFd, 0, SEEK_END);
+    if (spoolSize < 0) throw systemError("Could not seek the row spool");
+
+    writeAll(
+        this->spoolFd, this->rowBuffer.data(), this->rowBuffer.size(),
+        static_cast<std::uint64_t>(spoolSize));
+    this->rowBuffer.clear();
+}
+
+void FeatureFileWriter::writeSections(featurefile::Header & header)
+{
+    std::memcpy(header.magic, featurefile::MAGIC, sizeof(header.magic));
+    header.byteOrder = featurefile::BYTE_ORDER_MARK;
+    header.version = featurefile::VERSION;
+    header.valueType = this->valueType;
+    header.numFeatures = this->fKeys.size();
+    header.numDocs = this->getNumDocs();
+    header.numQueries = this->qids.size();
+
+    SectionWriter sectionWriter(this->fd, sizeof(header));
+    sectionWriter.align();
+
+    header.schemaOffset = sectionWriter.tell();
+    std::vector<std::string> fKeyStrs;
+    for (auto const & fKey : this->fKeys) fKeyStrs.push_back(fKey.toString());
+    sectionWriter.writeStringTable(fKeyStrs);
+
+    header.queryOffset = sectionWriter.tell();
+    for (std::uint64_t const docOffset : this->queryOffsets)
+        sectionWriter.writeUint64(docOffset);
+    sectionWriter.writeStringTable(this->qids);
+
+    header.docIdOffset = sectionWriter.tell();
+    sectionWriter.writeStringTable(this->docIds);
+
+    header.labelOffset = sectionWriter.tell();
+    for (base::FValType const label : this->labels)
+        sectionWriter.writeValue(label, this->valueType);
+    sectionWriter.align();
+
+    header.columnOffset = sectionWriter.tell();
+    sectionWriter.flush();
+
+    writeAll(
+        this->fd, reinterpret_cast<char const *>(&header), sizeof(header), 0);
+}
+
+void FeatureFileWriter::writeColumns(std::uint64_t const columnOffset)
+{
+    std::size_t const numDocs = this->getNumDocs();
+    std::size_t const numFeatures = this->getNumFeatures();
+    std::size_t const valueSize = static_cast<std::size_t>(this->valueType);
+    std::size_t const rowSize = numFeatures * valueSize;
+    if (numDocs == 0 || numFeatures == 0) return;
+
+    std::size_t const spoolSize = numDocs * rowSize;
+    void * const spoolMap =
+        ::mmap(nullptr, spoolSize, PROT_READ, MAP_PRIVATE, this->spoolFd, 0);
+    if (spoolMap == MAP_FAILED) throw systemError("Could not map row spool");
+    char const * const rows = static_cast<char const *>(spoolMap);
+
+    // Transpose blocks of rows, in a single pass over the rows of a block,
+    // then write the part of every column the block holds
+    std::size_t const blockDocs =
+        std::max<std::size_t>(1, FeatureFileWriter::BUFFER_SIZE / rowSize);
+    std::vector<char> blockBuffer(blockDocs * rowSize);
+
+    try
+    {
+        for (std::size_t firstDoc = 0; firstDoc < numDocs;
+             firstDoc += blockDocs)
+        {
+            std::size_t const nDocs = std::min(blockDocs, numDocs - firstDoc);
+
+            for (std::size_t i = 0; i < nDocs; ++i)
+            {
+                char const * const row = rows + (firstDoc + i) * rowSize;
+                for (std::size_t j = 0; j < numFeatures; ++j)
+                    std::memcpy(
+                        blockBuffer.data() + (j * nDocs + i) * valueSize,
+                        row + j * valueSize, valueSize);
+            }
+
+            for (std::size_t j = 0; j < numFeatures; ++j)
+                writeAll(
+                    this->fd, blockBuffer.data() + j * nDocs * valueSize,
+                    nDocs * valueSize,
+                    columnOffset + (j * numDocs + firstDoc) * valueSize);
+        }
+    }
+    catch (std::runtime_error const &)
+    {
+        ::munmap(spoolMap, spoolSize);
+        throw;
+    }
+
+    ::munmap(spoolMap, spoolSize);
+}
+
+/* FeatureFileReader constructors */
+
+FeatureFileReader::FeatureFileReader(std::string const & path)
+{
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw systemError("Could not open '" + path + "'");
+
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        throw systemError("Could not stat '" + path + "'");
+    }
+    this->size = static_cast<std::size_t>(fileStat.st_size);
+    if (this->size < sizeof(this->header))
+    {
+        ::close(fd);
+        throw std::runtime_error("'" + path + "' is not a feature file");
+    }
+
+    void * const fileMap =
+        ::mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (fileMap == MAP_FAILED)
+        throw systemError("Could not map '" + path + "'");
+    this->data = static_cast<char const *>(fileMap);
+
+    try
+    {
+        std::memcpy(&this->header, this->data, sizeof(this->header));
+        if (std::memcmp(
+                this->header.magic, featurefile::MAGIC,
+                sizeof(this->header.magic)) != 0)
+            throw std::runtime_error("Not a feature file");
+        if (this->header.byteOrder != featurefile::BYTE_ORDER_MARK)
+            throw std::runtime_error("Feature file of another byte order");
+        if (this->header.version != featurefile::VERSION)
+            throw std::runtime_error("Unsupported feature file version");
+        if (this->header.valueType != featurefile::ValueType::float32 &&
+            this->header.valueType != featurefile::ValueType::float64)
+            throw std::runtime_error("Unsupported feature value type");
+
+        std::size_t const numQueries = this->getNumQueries();
+        std::size_t const numDocs = this->getNumDocs();
+        std::size_t const numFeatures = this->getNumFeatures();
+        std::size_t const valueSize =
+            static_cast<std::size_t>(this->header.valueType);
+
+        // Every count has a string table of 8 bytes per string
+        if (numQueries > this->size / 8 || numDocs > this->size / 8 ||
+            numFeatures > this->size / 8)
+            throw std::runtime_error("Truncated feature file");
+
+        this->checkStringTable(this->header.schemaOffset, numFeatures);
+        this->checkRange(this->header.queryOffset, (numQueries + 1) * 8);
+        this->checkStringTable(
+            this->header.queryOffset + (numQueries + 1) * 8, numQueries);
+        this->checkStringTable(this->header.docIdOffset, numDocs);
+        this->checkRange(this->header.labelOffset, numDocs * valueSize);
+        this->checkRange(this->header.columnOffset, 0);
+        if (numDocs > 0 &&
+            numFeatures > (this->size - this->header.columnOffset) /
+                              (numDocs * valueSize))
+            throw std::runtime_error("Truncated feature file");
+
+        this->queryOffsets = reinterpret_cast<std::uint64_t const *>(
+            this->data + this->header.queryOffset);
+        if (this->queryOffsets[numQueries] != (numQueries > 0 ? numDocs : 0))
+            throw std::runtime_error("Corrupt feature file query offsets");
+
+        for (std::size_t i = 0; i < numFeatures; ++i)
+            this->fKeys.emplace_back(std::string(
+                this->getString(this->header.schemaOffset, numFeatures, i)));
+    }
+    catch (std::runtime_error const &)
+    {
+        ::munmap(fileMap, this->size);
+        throw;
+    }
+}
+
+FeatureFileReader::~FeatureFileReader()
+{
+    ::munmap(const_cast<char *>(this->data), this->size);
+}
+
+/* FeatureFileReader public class methods */
+
+base::FValType FeatureFileReader::at(
+    std::size_t const docIdx, std::size_t const featureIdx) const
+{
+    if (docIdx >= this->getNumDocs() || featureIdx >= this->getNumFeatures())
+        throw std::out_of_range("Feature file cell out of range");
+
+    return this->getValue(
+        this->header.columnOffset, featureIdx * this->getNumDocs() + docIdx);
+}
+
+template <typename T>
+T const * FeatureFileReader::getColumnData(std::size_t const featureIdx) const
+{
+    if (featureIdx >= this->getNumFeatures())
+        throw std::out_of_range("Feature file column out of range");
+
+    return this->getValueData<T>(
+        this->header.columnOffset, featureIdx * this->getNumDocs());
+}
+
+template <typename T>
+T const * FeatureFileReader::getLabelData() const
+{
+    return this->getValueData<T>(this->header.labelOffset, 0);
+}
+
+/* FeatureFileReader getter methods */
+
+std::size_t FeatureFileReader::getNumDocs() const
+{
+    return static_cast<std::size_t>(this->header.numDocs);
+}
+
+std::size_t FeatureFileReader::getNumFeatures() const
+{
+    return static_cast<std::size_t>(this->header.numFeatures);
+}
+
+std::size_t FeatureFileReader::getNumQueries() const
+{
+    return static_cast<std::size_t>(this->header.numQueries);
+}
+
+featurefile::ValueType FeatureFileReader::getValueType() const
+{
+    return this->header.valueType;
+}
+
+std::vector<base::FeatureKey> const & FeatureFileReader::getFeatureKeys()
+    const
+{
+    return this->fKeys;
+}
+
+FeatureFileReader::QueryGroup FeatureFileReader::getQueryGroup(
+    std::size_t const queryIdx) const
+{
+    std::size_t const numQueries = this->getNumQueries();
+    if (queryIdx >= numQueries)
+        throw std::out_of_range("Feature file query out of range");
+
+    std::uint64_t const firstDoc = this->queryOffsets[queryIdx];
+    std::uint64_t const lastDoc = this->queryOffsets[queryIdx + 1];
+    if (firstDoc > lastDoc || lastDoc > this->header.numDocs)
+        throw std::runtime_error("Corrupt feature file query offsets");
+
+    QueryGroup queryGroup;
+    queryGroup.qid = this->getString(
+        this->header.queryOffset + (numQueries + 1) * 8, numQueries,
+        queryIdx);
+    queryGroup.firstDoc = static_cast<std::size_t>(firstDoc);
+    queryGroup.numDocs = static_cast<std::size_t>(lastDoc - firstDoc);
+
+    return queryGroup;
+}
+
+std::string_view FeatureFileReader::getDocId(std::size_t const docIdx) const
+{
+    return this->getString(
+        this->header.docIdOffset, this->getNumDocs(), docIdx);
+}
+
+base::FValType FeatureFileReader::getLabel(std::size_t const docIdx) const
+{
+    if (docIdx >= this->getNumDocs())
+        throw std::out_of_range("Feature file document out of range");
+
+    return this->getValue(this->header.labelOffset, docIdx);
+}
+
+/* FeatureFileReader private class methods */
+
+void FeatureFileReader::checkRange(
+    std::uint64_t const offset, std::uint64_t const nBytes) const
+{
+    if (offset % 8 != 0 || offset > this->size ||
+        nBytes > this->size - offset)
+        throw std::runtime_error("Truncated feature file");
+}
+
+void FeatureFileReader::checkStringTable(
+    std::uint64_t const offset, std::size_t const n) const
+{
+    this->checkRange(offset, (n + 1) * 8);
+
+    std::uint64_t numChars;
+    std::memcpy(&numChars, this->data + offset + n * 8, sizeof(numChars));
+    if (numChars > this->size - (offset + (n + 1) * 8))
+        throw std::runtime_error("Truncated feature file");
+}
+
+std::string_view FeatureFileReader::getString(
+    std::uint64_t const tableOffset, std::size_t const n,
+    std::size_t const idx) const
+{
+    if (idx >= n) throw std::out_of_range("Feature file string out of range");
+
+    std::uint64_t const * const charOffsets =
+        reinterpret_cast<std::uint64_t const *>(this->data + tableOffset);
+    std::uint64_t const first = charOffsets[idx];
+    std::uint64_t const last = charOffsets[idx + 1];
+    if (first > last || last > charOffsets[n])
+        throw std::runtime_error("Corrupt feature file string table");
+
+    char const * const chars = this->data + tableOffset + (n + 1) * 8;
+    return std::string_view(chars + first, last - first);
+}
+
+base::FValType FeatureFileReader::getValue(
+    std::uint64_t const offset, std::size_t const valueIdx) const
+{
+    if (this->header.valueType == featurefile::ValueType::float32)
+        return this->getValueData<float>(offset, valueIdx)[0];
+
+    return this->getValueData<double>(offset, valueIdx)[0];
+}
+
+template <typename T>
+T const * FeatureFileReader::getValueData(
+    std::uint64_t const offset, std::size_t const valueIdx) const
+{
+    if (sizeof(T) != static_cast<std::size_t>(this->header.valueType))
+        throw std::runtime_error("Feature file values are of another type");
+
+    return reinterpret_cast<T const *>(this->data + offset) + valueIdx;
+}
+
+/* Explicit template instantiations */
+
+template float const * FeatureFileReader::getColumnData<float>(
+    std::size_t const featureIdx) const;
+template double const * FeatureFileReader::getColumnData<double>(
+    std::size_t const featureIdx) const;
+
+template float const * FeatureFileReader::getLabelData<float>() const;
+template double const * FeatureFileReader::getLabelData<double>() const;
+
+}  // namespace lowletorfeats
@@ -0,0 +1,185 @@
+#include <fcntl.h>   // open
+#include <unistd.h>  // write, close
+
+#include <algorithm>  // copy
+#include <cerrno>
+#include <charconv>  // to_chars
+#include <cstring>   // strerror
+#include <lowletorfeats/LetorWriter.hpp>
+#include <stdexcept>
+
+namespace lowletorfeats
+{
+/* Constructors */
+
+LetorWriter::LetorWriter(std::string const & path)
+    : fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+      ownsFd(true),
+      buffer(LetorWriter::BUFFER_SIZE)
+{
+    if (this->fd < 0)
+        throw std::runtime_error(
+            "Could not open '" + path + "': " + std::strerror(errno));
+}
+
+LetorWriter::LetorWriter(int const fd)
+    : fd(fd), ownsFd(false), buffer(LetorWriter::BUFFER_SIZE)
+{
+}
+
+LetorWriter::~LetorWriter()
+{
+    try
+    {
+        this->close();
+    }
+    catch (std::runtime_error const &)
+    {
+    }
+}
+
+/* Public class methods */
+
+void LetorWriter::writeQuery(
+    FeatureMatrix & fMatrix, std::string_view const qid,
+    std::vector<base::FValType> const & labels,
+    std::vector<std::string> const & docIds)
+{
+    std::size_t const numDocs = fMatrix.getNumDocs();
+    if (!labels.empty() && labels.size() != numDocs)
+        throw std::runtime_error("Expected a label for every document");
+    if (!docIds.empty() && docIds.size() != numDocs)
+        throw std::runtime_error("Expected an id for every document");
+
+    // Rows are copied into the scratch row, reusing its capacity
+    this->rowScratch.resize(fMatrix.getNumFeatures());
+    for (std::size_t docIdx = 0; docIdx < numDocs; ++docIdx)
+    {
+        fMatrix.copyRow(docIdx, this->rowScratch.data());
+        this->writeRow(
+            labels.empty() ? 0 : labels[docIdx], qid, this->rowScratch.data(),
+            this->rowScratch.size(),
+            docIds.empty() ? std::string_view() : docIds[docIdx]);
+    }
+}
+
+void LetorWriter::writeRow(
+    base::FValType const label, std::string_view const qid,
+    base::FValType const * fValues, std::size_t const numFeatures,
+    std::string_view const docId)
+{
+    if (this->fd < 0) throw std::runtime_error("Writing to a closed writer");
+
+    this->appendValue(label);
+    this->append(" qid:");
+    this->append(qid);
+
+    for (std::size_t i = 0; i < numFeatures; ++i)
+    {
+        // " <index>:<value>"
+        this->reserve(2 + 20 + LetorWriter::MAX_VALUE_CHARS);
+        char * const first = this->buffer.data() + this->bufferLen;
+        char * const last = this->buffer.data() + this->buffer.size();
+
+        *first = ' ';
+        char * ptr = std::to_chars(first + 1, last, i + 1).ptr;
+        *ptr++ = ':';
+        ptr = std::to_chars(ptr, last, fValues[i]).ptr;
+
+        this->bufferLen += static_cast<std::size_t>(ptr - first);
+    }
+
+    if (!docId.empty())
+    {
+        this->append(" #");
+        this->append(docId);
+    }
+    this->append("\n");
+}
+
+void LetorWriter::flush()
+{
+    if (this->fd < 0) throw std::runtime_error("Writing to a closed writer");
+
+    std::size_t nWritten = 0;
+    while (nWritten < this->bufferLen)
+    {
+        ssize_t const nChars = ::write(
+            this->fd, this->buffer.data() + nWritten,
+            this->bufferLen - nWritten);
+        if (nChars < 0)
+        {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(
+                std::string("Could not write features: ") +
+                std::strerror(errno));
+        }
+
+        nWritten += static_cast<std::size_t>(nChars);
+    }
+
+    this->bufferLen = 0;
+}
+
+void LetorWriter::close()
+{
+    if (this->fd < 0) return;
+
+    this->flush();
+
+    if (this->ownsFd && ::close(this->fd) != 0)
+    {
+        this->fd = -1;
+        throw std::runtime_error(
+            std::string("Could not close features: ") + std::strerror(errno));
+    }
+    this->fd = -1;
+}
+
+/* Private static member variables */
+
+std::size_t const LetorWriter::BUFFER_SIZE = 1 << 16;
+
+std::size_t const LetorWriter::MAX_VALUE_CHARS = 32;
+
+/* Private class methods */
+
+void LetorWriter::append(std::string_view const str)
+{
+    // Strings longer than the buffer are written out in chunks
+    if (str.size() > this->buffer.size())
+    {
+        this->flush();
+        for (std::size_t pos = 0; pos < str.size();
+             pos += this->buffer.size())
+        {
+            std::string_view const chunk =
+                str.substr(pos, this->buffer.size());
+            std::copy(chunk.begin(), chunk.end(), this->buffer.data());
+            this->bufferLen = chunk.size();
+            this->flush();
+        }
+        return;
+    }
+
+    this->reserve(str.size());
+    std::copy(str.begin(), str.end(), this->buffer.data() + this->bufferLen);
+    this->bufferLen += str.size();
+}
+
+void LetorWriter::appendValue(base::FValType const value)
+{
+    this->reserve(LetorWriter::MAX_VALUE_CHARS);
+    char * const first = this->buffer.data() + this->bufferLen;
+    char * const last = this->buffer.data() + this->buffer.size();
+
+    char * const ptr = std::to_chars(first, last, value).ptr;
+    this->bufferLen += static_cast<std::size_t>(ptr - first);
+}
+
+void LetorWriter::reserve(std::size_t const nChars)
+{
+    if (this->bufferLen + nChars > this->buffer.size()) this->flush();
+}
+
+}  // namespace lowletorfeats
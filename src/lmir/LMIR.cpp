@@ -25,9 +25,48 @@ LMIR::LMIR(LMIR const & other)
 
 /* Public class methods */
 
+base::FValType LMIR::absoluteDiscountTerm(
+    std::size_t const docTermFrequency, std::size_t const docLen,
+    std::size_t const nUniqueTerms, double const termProb) const
+{
+    double c = static_cast<double>(docTermFrequency) - this->delta;
+    if (!(c > 0)) c = 0;
+
+    return log(
+        c / static_cast<float>(docLen) + this->delta *
+                                             static_cast<float>(nUniqueTerms) /
+                                             static_cast<float>(docLen) *
+                                             termProb);
+}
+
+base::FValType LMIR::dirichletTerm(
+    std::size_t const docTermFrequency, std::size_t const docLen,
+    double const termProb) const
+{
+    return log(
+        (static_cast<double>(docTermFrequency) + this->mu * termProb) /
+        static_cast<double>(docLen + this->mu));
+}
+
+base::FValType LMIR::jelinekMercerTerm(
+    std::size_t const docTermFrequency, std::size_t const docLen,
+    double const termProb) const
+{
+    double const pMl =
+        static_cast<double>(docTermFrequency) / static_cast<double>(docLen);
+
+    return log((1 - this->lamb) * pMl + this->lamb * termProb);
+}
+
+base::StrDblMap const & LMIR::getTermProbabilityMap() const
+{
+    return this->termProbabilityMap;
+}
+
+template <class TfMap>
 base::FValType LMIR::absolute_discount(
-    base::StrSizeMap const & docTermFreqMap, std::size_t const docLen,
-    base::StrSizeMap const & queryTermFreqMap) const
+    TfMap const & docTermFreqMap, std::size_t const docLen,
+    TfMap const & queryTermFreqMap) const
 {
     std::size_t const nUniqueTerms = docTermFreqMap.size();
     base::FValType score = 0;
@@ -35,82 +74,79 @@ base::FValType LMIR::absolute_discount(
     {
         auto const & term = mapPair.first;
 
-        if (docTermFreqMap.count(term) != 0)
+        auto const docIt = docTermFreqMap.find(term);
+        if (docIt != docTermFreqMap.end())
         {
-            std::size_t const docTermFrequency = docTermFreqMap.at(term);
-
-            double c = static_cast<double>(docTermFrequency) - this->delta;
-            if (!(c > 0)) c = 0;
-
-            score +=
-                log(c / static_cast<float>(docLen) +
-                    this->delta * static_cast<float>(nUniqueTerms) /
-                        static_cast<float>(docLen) *
-                        this->termProbabilityMap.at(term));
+            score += this->absoluteDiscountTerm(
+                docIt->second, docLen, nUniqueTerms,
+                this->termProbabilityMap.at(term));
         }
     }
 
     return score;
 }
 
+template <class TfMap>
 base::FValType LMIR::dirichlet(
-    base::StrSizeMap const & docTermFreqMap, std::size_t const docLen,
-    base::StrSizeMap const & queryTermFreqMap) const
+    TfMap const & docTermFreqMap, std::size_t const docLen,
+    TfMap const & queryTermFreqMap) const
 {
     base::FValType score = 0;
     for (auto const & mapPair : queryTermFreqMap)
     {
         auto const & term = mapPair.first;
 
-        if (docTermFreqMap.count(term) != 0)
+        auto const docIt = docTermFreqMap.find(term);
+        if (docIt != docTermFreqMap.end())
         {
-            double const & docTermFrequency =
-                static_cast<double>(docTermFreqMap.at(term));
-            double const & termProb =
-                static_cast<double>(this->termProbabilityMap.at(term));
-
-            score +=
-                log((docTermFrequency + this->mu * termProb) /
-                    static_cast<double>(docLen + this->mu));
+            score += this->dirichletTerm(
+                docIt->second, docLen, this->termProbabilityMap.at(term));
         }
     }
 
     return score;
 }
 
+template <class TfMap>
 base::FValType LMIR::jelinek_mercer(
-    base::StrSizeMap const & docTermFreqMap, std::size_t const docLen,
-    base::StrSizeMap const & queryTermFreqMap) const
+    TfMap const & docTermFreqMap, std::size_t const docLen,
+    TfMap const & queryTermFreqMap) const
 {
-    auto const docPml = this->calcDocPml(docTermFreqMap, docLen);
-
     base::FValType score = 0;
     for (auto const & mapPair : queryTermFreqMap)
     {
         auto const & term = mapPair.first;
 
-        if (docTermFreqMap.count(term) != 0)
+        auto const docIt = docTermFreqMap.find(term);
+        if (docIt != docTermFreqMap.end())
         {
-            score +=
-                log((1 - this->lamb) * docPml.at(term) +
-                    this->lamb * this->termProbabilityMap.at(term));
+            score += this->jelinekMercerTerm(
+                docIt->second, docLen, this->termProbabilityMap.at(term));
         }
     }
 
     return score;
 }
 
-/* Private class methods */
-
-base::StrDblMap LMIR::calcDocPml(
-    base::StrSizeMap const & docTermFreqMap, std::size_t const docLen) const
-{
-    base::StrDblMap pMl;
-    for (auto const & mapPair : docTermFreqMap)
-        pMl[mapPair.first] =
-            static_cast<double>(mapPair.second) / static_cast<double>(docLen);
-
-    return pMl;
-}
+template base::FValType LMIR::absolute_discount<base::StrSizeMap>(
+    base::StrSizeMap const &, std::size_t const,
+    base::StrSizeMap const &) const;
+template base::FValType LMIR::absolute_discount<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &, std::size_t const,
+    base::FlatStrSizeMap const &) const;
+
+template base::FValType LMIR::dirichlet<base::StrSizeMap>(
+    base::StrSizeMap const &, std::size_t const,
+    base::StrSizeMap const &) const;
+template base::FValType LMIR::dirichlet<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &, std::size_t const,
+    base::FlatStrSizeMap const &) const;
+
+template base::FValType LMIR::jelinek_mercer<base::StrSizeMap>(
+    base::StrSizeMap const &, std::size_t const,
+    base::StrSizeMap const &) const;
+template base::FValType LMIR::jelinek_mercer<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &, std::size_t const,
+    base::FlatStrSizeMap const &) const;
 
 }  // namespace lowletorfeats
@@ -4,23 +4,20 @@
 namespace lowletorfeats
 {
 /**
- * @brief Calculate Okapi Best Match 25 (BM25) for a single term.
+ * @brief Calculate the term frequency component of BM25 for a single term,
+ *  the factor applied to the term's idf.
  *
  * @param docTermFrequency The term's term frequency in the given document.
  * @param numDocs Number of documents in the collection.
- * @param numDocsWithTerm Number of documents in the collection with the term.
  * @param avgDocLen Average document length of the collection.
  * @param b
  * @param k1
  * @return double
  */
-base::FValType Okapi::bm25(
+base::FValType Okapi::bm25TfNorm(
     std::size_t const & docTermFrequency, std::size_t const & numDocs,
-    std::size_t const & numDocsWithTerm, float const & avgDocLen,
-    float const & b, float const & k1)
+    float const & avgDocLen, float const & b, float const & k1)
 {
-    base::FValType const idf = Tfidf::idfNorm(numDocs, numDocsWithTerm);
-
     base::FValType const numer =
         static_cast<float>(docTermFrequency) * (k1 + 1);
     base::FValType const denom =
@@ -29,7 +26,47 @@ base::FValType Okapi::bm25(
                (b * (static_cast<base::FValType>(numDocs) /
                      static_cast<base::FValType>(avgDocLen)))));
 
-    return idf * (numer / denom);
+    return numer / denom;
+}
+
+/**
+ * @brief Calculate the term frequency component of BM25 for a single term.
+ *
+ * @param docTermFrequency The term's term frequency in the given document.
+ * @param numDocs Number of documents in the collection.
+ * @param avgDocLen Average document length of the collection.
+ * @return double
+ */
+base::FValType Okapi::bm25TfNorm(
+    std::size_t const & docTermFrequency, std::size_t const & numDocs,
+    float const & avgDocLen)
+{
+    float const k1 = 1.2f;
+    float const b = 0.74f;
+
+    return Okapi::bm25TfNorm(docTermFrequency, numDocs, avgDocLen, b, k1);
+}
+
+/**
+ * @brief Calculate Okapi Best Match 25 (BM25) for a single term.
+ *
+ * @param docTermFrequency The term's term frequency in the given document.
+ * @param numDocs Number of documents in the collection.
+ * @param numDocsWithTerm Number of documents in the collection with the term.
+ * @param avgDocLen Average document length of the collection.
+ * @param b
+ * @param k1
+ * @return double
+ */
+base::FValType Okapi::bm25(
+    std::size_t const & docTermFrequency, std::size_t const & numDocs,
+    std::size_t const & numDocsWithTerm, float const & avgDocLen,
+    float const & b, float const & k1)
+{
+    base::FValType const idf = Tfidf::idfNorm(numDocs, numDocsWithTerm);
+
+    return idf *
+           Okapi::bm25TfNorm(docTermFrequency, numDocs, avgDocLen, b, k1);
 }
 
 /**
@@ -45,11 +82,9 @@ base::FValType Okapi::bm25(
     std::size_t const & docTermFrequency, std::size_t const & numDocs,
     std::size_t const & numDocsWithTerm, float const & avgDocLen)
 {
-    float const k1 = 1.2f;
-    float const b = 0.74f;
+    base::FValType const idf = Tfidf::idfNorm(numDocs, numDocsWithTerm);
 
-    return Okapi::bm25(
-        docTermFrequency, numDocs, numDocsWithTerm, avgDocLen, b, k1);
+    return idf * Okapi::bm25TfNorm(docTermFrequency, numDocs, avgDocLen);
 }
 
 /**
@@ -64,10 +99,11 @@ base::FValType Okapi::bm25(
  * @param queryTermFreqMap `TermFrequencyMap` for the query.
  * @return double
  */
+template <class TfMap>
 base::FValType Okapi::queryBm25(
-    base::StrSizeMap const & docTermFreqMap, std::size_t const & numDocs,
+    TfMap const & docTermFreqMap, std::size_t const & numDocs,
     base::StrSizeMap const & docsWithTermFreqMap, float const & avgDocLen,
-    base::StrSizeMap const & queryTermFreqMap)
+    TfMap const & queryTermFreqMap)
 {
     // Sum the scores for each term
     base::FValType score = 0;
@@ -75,18 +111,22 @@ base::FValType Okapi::queryBm25(
     {
         auto const & term = mapPair.first;
 
-        if (!(docTermFreqMap.count(term) == 0 ||
-              docsWithTermFreqMap.count(term) == 0))
-        {
-            auto const docTermFrequency = docTermFreqMap.at(term);
-            auto const numDocsWithTerm = docsWithTermFreqMap.at(term);
+        auto const docIt = docTermFreqMap.find(term);
+        if (docIt == docTermFreqMap.end()) continue;
+        auto const dfIt = docsWithTermFreqMap.find(term);
+        if (dfIt == docsWithTermFreqMap.end()) continue;
 
-            score += Okapi::bm25(
-                docTermFrequency, numDocs, numDocsWithTerm, avgDocLen);
-        }
+        score += Okapi::bm25(docIt->second, numDocs, dfIt->second, avgDocLen);
     }
 
     return score;
 }
 
+template base::FValType Okapi::queryBm25<base::StrSizeMap>(
+    base::StrSizeMap const &, std::size_t const &, base::StrSizeMap const &,
+    float const &, base::StrSizeMap const &);
+template base::FValType Okapi::queryBm25<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &, std::size_t const &,
+    base::StrSizeMap const &, float const &, base::FlatStrSizeMap const &);
+
 }  // namespace lowletorfeats
@@ -14,12 +14,12 @@ namespace lowletorfeats
  * @param sectionWeights
  * @return base::FValType
  */
+template <class StructuredTfMap>
 base::FValType Okapi::queryBm25f(
-    base::StructuredTermFrequencyMap const & structDocTermFreqMap,
-    std::size_t const & numDocs,
+    StructuredTfMap const & structDocTermFreqMap, std::size_t const & numDocs,
     base::StructuredTermFrequencyMap const & structDocsWithTermFreqMap,
     base::StrFltMap const & avgDocLenMap,
-    base::StrSizeMap const & queryTermFreqMap,
+    typename StructuredTfMap::mapped_type const & queryTermFreqMap,
     std::unordered_map<std::string, base::WeightType> const & sectionWeights)
 {
     // Calculate full idf
@@ -64,12 +64,12 @@ base::FValType Okapi::queryBm25f(
  * @param sectionWeights
  * @return base::FValType
  */
+template <class StructuredTfMap>
 base::FValType Okapi::queryBm25fplus(
-    base::StructuredTermFrequencyMap const & structDocTermFreqMap,
-    std::size_t const & numDocs,
+    StructuredTfMap const & structDocTermFreqMap, std::size_t const & numDocs,
     base::StructuredTermFrequencyMap const & structDocsWithTermFreqMap,
     base::StrFltMap const & avgDocLenMap,
-    base::StrSizeMap const & queryTermFreqMap,
+    typename StructuredTfMap::mapped_type const & queryTermFreqMap,
     std::unordered_map<std::string, base::WeightType> const & sectionWeights)
 {
     // Calculate full idf
@@ -103,4 +103,29 @@ base::FValType Okapi::queryBm25fplus(
     return fullIdf * totalBm25plus;
 }
 
+template base::FValType Okapi::queryBm25f<base::StructuredTermFrequencyMap>(
+    base::StructuredTermFrequencyMap const &, std::size_t const &,
+    base::StructuredTermFrequencyMap const &, base::StrFltMap const &,
+    base::StrSizeMap const &,
+    std::unordered_map<std::string, base::WeightType> const &);
+template base::FValType
+    Okapi::queryBm25f<base::StructuredFlatTermFrequencyMap>(
+        base::StructuredFlatTermFrequencyMap const &, std::size_t const &,
+        base::StructuredTermFrequencyMap const &, base::StrFltMap const &,
+        base::FlatStrSizeMap const &,
+        std::unordered_map<std::string, base::WeightType> const &);
+
+template base::FValType
+    Okapi::queryBm25fplus<base::StructuredTermFrequencyMap>(
+        base::StructuredTermFrequencyMap const &, std::size_t const &,
+        base::StructuredTermFrequencyMap const &, base::StrFltMap const &,
+        base::StrSizeMap const &,
+        std::unordered_map<std::string, base::WeightType> const &);
+template base::FValType
+    Okapi::queryBm25fplus<base::StructuredFlatTermFrequencyMap>(
+        base::StructuredFlatTermFrequencyMap const &, std::size_t const &,
+        base::StructuredTermFrequencyMap const &, base::StrFltMap const &,
+        base::FlatStrSizeMap const &,
+        std::unordered_map<std::string, base::WeightType> const &);
+
 }  // namespace lowletorfeats
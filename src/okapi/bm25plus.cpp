@@ -3,6 +3,47 @@
 
 namespace lowletorfeats
 {
+/**
+ * @brief Calculate the term frequency component of BM25+ for a single term,
+ *  the factor applied to the term's idf.
+ *
+ * @param docTermFrequency The term's term frequency in the given document.
+ * @param numDocs Number of documents in the collection.
+ * @param avgDocLen Average document length of the collection.
+ * @param b
+ * @param k1
+ * @param delta
+ * @return double
+ */
+base::FValType Okapi::bm25plusTfNorm(
+    std::size_t const & docTermFrequency, std::size_t const & numDocs,
+    float const & avgDocLen, float const & b, float const & k1,
+    float const & delta)
+{
+    return Okapi::bm25TfNorm(docTermFrequency, numDocs, avgDocLen, b, k1) +
+           delta;
+}
+
+/**
+ * @brief Calculate the term frequency component of BM25+ for a single term.
+ *
+ * @param docTermFrequency The term's term frequency in the given document.
+ * @param numDocs Number of documents in the collection.
+ * @param avgDocLen Average document length of the collection.
+ * @return double
+ */
+base::FValType Okapi::bm25plusTfNorm(
+    std::size_t const & docTermFrequency, std::size_t const & numDocs,
+    float const & avgDocLen)
+{
+    float const k1 = 1.2f;
+    float const b = 0.74f;
+    float const delta = 1.0f;
+
+    return Okapi::bm25plusTfNorm(
+        docTermFrequency, numDocs, avgDocLen, b, k1, delta);
+}
+
 /**
  * @brief Calculate Okapi Best Match 25 plus (BM25+) for a single term.
  *
@@ -22,15 +63,8 @@ base::FValType Okapi::bm25plus(
 {
     base::FValType const idf = Tfidf::idfNorm(numDocs, numDocsWithTerm);
 
-    base::FValType const numer =
-        static_cast<float>(docTermFrequency) * (k1 + 1);
-    base::FValType const denom =
-        static_cast<base::FValType>(docTermFrequency) +
-        (k1 * (1 - b +
-               (b * (static_cast<base::FValType>(numDocs) /
-                     static_cast<base::FValType>(avgDocLen)))));
-
-    return idf * ((numer / denom) + delta);
+    return idf * Okapi::bm25plusTfNorm(
+                     docTermFrequency, numDocs, avgDocLen, b, k1, delta);
 }
 
 /**
@@ -46,12 +80,9 @@ base::FValType Okapi::bm25plus(
     std::size_t const & docTermFrequency, std::size_t const & numDocs,
     std::size_t const & numDocsWithTerm, float const & avgDocLen)
 {
-    float const k1 = 1.2f;
-    float const b = 0.74f;
-    float const delta = 1.0f;
+    base::FValType const idf = Tfidf::idfNorm(numDocs, numDocsWithTerm);
 
-    return bm25plus(
-        docTermFrequency, numDocs, numDocsWithTerm, avgDocLen, b, k1, delta);
+    return idf * Okapi::bm25plusTfNorm(docTermFrequency, numDocs, avgDocLen);
 }
 
 /**
@@ -66,10 +97,11 @@ base::FValType Okapi::bm25plus(
  * @param queryTermFreqMap `StrUintMap` for the query.
  * @return double
  */
+template <class TfMap>
 base::FValType Okapi::queryBm25plus(
-    base::StrSizeMap const & docTermFreqMap, std::size_t const & numDocs,
+    TfMap const & docTermFreqMap, std::size_t const & numDocs,
     base::StrSizeMap const & docsWithTermFreqMap, float const & avgDocLen,
-    base::StrSizeMap const & queryTermFreqMap)
+    TfMap const & queryTermFreqMap)
 {
     // Sum the scores for each term
     base::FValType score = 0;
@@ -77,18 +109,23 @@ base::FValType Okapi::queryBm25plus(
     {
         auto const & term = mapPair.first;
 
-        if (!(docTermFreqMap.count(term) == 0 ||
-              docsWithTermFreqMap.count(term) == 0))
-        {
-            auto const docTermFrequency = docTermFreqMap.at(term);
-            auto const numDocsWithTerm = docsWithTermFreqMap.at(term);
+        auto const docIt = docTermFreqMap.find(term);
+        if (docIt == docTermFreqMap.end()) continue;
+        auto const dfIt = docsWithTermFreqMap.find(term);
+        if (dfIt == docsWithTermFreqMap.end()) continue;
 
-            score += Okapi::bm25plus(
-                docTermFrequency, numDocs, numDocsWithTerm, avgDocLen);
-        }
+        score +=
+            Okapi::bm25plus(docIt->second, numDocs, dfIt->second, avgDocLen);
     }
 
     return score;
 }
 
+template base::FValType Okapi::queryBm25plus<base::StrSizeMap>(
+    base::StrSizeMap const &, std::size_t const &, base::StrSizeMap const &,
+    float const &, base::StrSizeMap const &);
+template base::FValType Okapi::queryBm25plus<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &, std::size_t const &,
+    base::StrSizeMap const &, float const &, base::FlatStrSizeMap const &);
+
 }  // namespace lowletorfeats
@@ -25,18 +25,28 @@ base::FValType Tfidf::tfDoubleNorm(
     return tfDoubleNorm(docTermFrequency, docMaxTermFrequency, 0.5);
 }
 
-base::FValType Tfidf::sumTfLogNorm(base::StrSizeMap const & docTermFreqMap)
+template <class TfMap>
+base::FValType Tfidf::sumTfLogNorm(TfMap const & docTermFreqMap)
 {
     return Tfidf::tfLogNorm(utils::mapValueSum(docTermFreqMap));
-    ;
 }
 
+template <class TfMap>
 base::FValType Tfidf::sumTfDoubleNorm(
-    base::StrSizeMap const & docTermFreqMap,
-    std::size_t const & docMaxTermFrequency)
+    TfMap const & docTermFreqMap, std::size_t const & docMaxTermFrequency)
 {
     return tfDoubleNorm(
         utils::mapValueSum(docTermFreqMap), docMaxTermFrequency);
 }
 
+template base::FValType Tfidf::sumTfLogNorm<base::StrSizeMap>(
+    base::StrSizeMap const &);
+template base::FValType Tfidf::sumTfLogNorm<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &);
+
+template base::FValType Tfidf::sumTfDoubleNorm<base::StrSizeMap>(
+    base::StrSizeMap const &, std::size_t const &);
+template base::FValType Tfidf::sumTfDoubleNorm<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &, std::size_t const &);
+
 }  // namespace lowletorfeats
@@ -77,11 +77,11 @@ base::FValType Tfidf::tfidf(
  * @param queryTermFreqMap `TermFrequencyMap` for the query.
  * @return double
  */
+template <class TfMap>
 base::FValType Tfidf::queryTfidf(
-    base::StrSizeMap const & docTermFreqMap,
-    std::size_t const & docMaxTermFrequency, std::size_t const & numDocs,
-    base::StrSizeMap const & docsWithTermFreqMap,
-    base::StrSizeMap const & queryTermFreqMap)
+    TfMap const & docTermFreqMap, std::size_t const & docMaxTermFrequency,
+    std::size_t const & numDocs, base::StrSizeMap const & docsWithTermFreqMap,
+    TfMap const & queryTermFreqMap)
 {
     // Sum the scores for each term
     base::FValType score = 0;
@@ -89,19 +89,22 @@ base::FValType Tfidf::queryTfidf(
     {
         auto const & term = mapPair.first;
 
-        if (!(docTermFreqMap.count(term) == 0 ||
-              docsWithTermFreqMap.count(term) == 0))
-        {
-            std::size_t const docTermFrequency = docTermFreqMap.at(term);
-            std::size_t const numDocsWithTerm = docsWithTermFreqMap.at(term);
+        auto const docIt = docTermFreqMap.find(term);
+        if (docIt == docTermFreqMap.end()) continue;
+        auto const dfIt = docsWithTermFreqMap.find(term);
+        if (dfIt == docsWithTermFreqMap.end()) continue;
 
-            score += tfidf(
-                docTermFrequency, docMaxTermFrequency, numDocs,
-                numDocsWithTerm);
-        }
+        score += tfidf(docIt->second, docMaxTermFrequency, numDocs, dfIt->second);
     }
 
     return score;
 }
 
+template base::FValType Tfidf::queryTfidf<base::StrSizeMap>(
+    base::StrSizeMap const &, std::size_t const &, std::size_t const &,
+    base::StrSizeMap const &, base::StrSizeMap const &);
+template base::FValType Tfidf::queryTfidf<base::FlatStrSizeMap>(
+    base::FlatStrSizeMap const &, std::size_t const &, std::size_t const &,
+    base::StrSizeMap const &, base::FlatStrSizeMap const &);
+
 }  // namespace lowletorfeats
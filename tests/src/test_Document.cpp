@@ -1,4 +1,5 @@
 #include <lowletorfeats/base/Document.hpp>
+#include <memory_resource>
 
 int main()
 {
@@ -7,6 +8,10 @@ int main()
         lowletorfeats::StructuredDocument();
     doc = lowletorfeats::StructuredDocument(doc);
 
+    std::pmr::monotonic_buffer_resource arena;
+    lowletorfeats::StructuredDocument arenaDoc(&arena);
+    doc = lowletorfeats::StructuredDocument(arenaDoc, &arena);
+
     // Test public methods
     doc.toString();
     doc.clear();
@@ -0,0 +1,117 @@
+#include <lowletorfeats/ExtractionPipeline.hpp>
+#include <lowletorfeats/FeatureCollector.hpp>
+
+#include "testData.hpp"
+
+int main()
+{
+    // Get test data
+    auto const testData = getTestData();
+    auto const queryStr = testData.first;
+    auto const structDocMap = testData.second;
+
+    std::vector<lowletorfeats::base::StrViewPairVector> docViews;
+    for (auto const & docTextMap : structDocMap)
+        docViews.emplace_back(docTextMap.begin(), docTextMap.end());
+
+    std::vector<std::string> const queries = {
+        queryStr, "helsing", "october week", "white purple turns"};
+    std::size_t const numQueries = 24;
+
+    lowletorfeats::FeaturePlan const plan(
+        {lowletorfeats::base::FeatureKey("okapi.bm25.body"),
+         lowletorfeats::base::FeatureKey("tfidf.tfidf.full"),
+         lowletorfeats::base::FeatureKey("lmir.dir.title")});
+
+    // Test the pipeline, with several threads per stage
+    lowletorfeats::ExtractionPipeline::Options options;
+    options.analyzeThreads = 2;
+    options.scoreThreads = 3;
+    options.queueCapacity = 2;
+    lowletorfeats::ExtractionPipeline pipeline(plan, options);
+
+    std::size_t queryIdx = 0;
+    std::vector<std::vector<std::vector<lowletorfeats::base::FValType>>>
+        writtenVects;
+    pipeline.run(
+        [&](lowletorfeats::ExtractionPipeline::QueryTask & task) {
+            if (queryIdx == numQueries) return false;
+
+            task.qid = std::to_string(queryIdx);
+            task.query = queries[queryIdx % queries.size()];
+            task.docs = docViews;
+            ++queryIdx;
+
+            return true;
+        },
+        [&](lowletorfeats::ExtractionPipeline::QueryTask & task) {
+            if (task.qid != std::to_string(writtenVects.size()))
+                throw std::runtime_error("Written out of order");
+            writtenVects.push_back(task.fc->getFeatureVects());
+        });
+
+    // Test against a sequential collection
+    for (std::size_t i = 0; i < numQueries; ++i)
+    {
+        lowletorfeats::FeatureCollector fc(
+            structDocMap, queries[i % queries.size()]);
+        fc.collectFeatures(plan);
+        if (fc.getFeatureVects() != writtenVects.at(i)) return 1;
+    }
+
+    // The end of the input is not counted as a read
+    if (pipeline
+            .getStageTiming(lowletorfeats::ExtractionPipeline::Stage::read)
+            .calls != numQueries)
+        return 1;
+
+    // Getter methods
+    pipeline.getNumQueries();
+    pipeline.getNumDocs();
+    pipeline.getSeconds();
+    pipeline.getStageTiming(
+        lowletorfeats::ExtractionPipeline::Stage::analyze);
+    pipeline.toJson();
+
+    // Test that a stage error is rethrown
+    try
+    {
+        pipeline.run(
+            [](lowletorfeats::ExtractionPipeline::QueryTask &) -> bool {
+                throw std::runtime_error("Read error");
+            },
+            [](lowletorfeats::ExtractionPipeline::QueryTask &) {});
+        return 1;
+    }
+    catch (std::runtime_error const &)
+    {
+    }
+
+    // Test that a read error keeps the queries read before it counted
+    try
+    {
+        std::size_t numRead = 0;
+        pipeline.run(
+            [&](lowletorfeats::ExtractionPipeline::QueryTask & task) {
+                if (numRead == 2) throw std::runtime_error("Read error");
+
+                task.qid = std::to_string(numRead++);
+                task.query = queryStr;
+                task.docs = docViews;
+
+                return true;
+            },
+            [](lowletorfeats::ExtractionPipeline::QueryTask &) {});
+        return 1;
+    }
+    catch (std::runtime_error const &)
+    {
+    }
+    // Both queries and the failed read
+    if (pipeline
+            .getStageTiming(lowletorfeats::ExtractionPipeline::Stage::read)
+            .calls != 3)
+        return 1;
+
+    return 0;
+}
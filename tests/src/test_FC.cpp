@@ -1,7 +1,87 @@
+#include <cmath>  // isnan
 #include <lowletorfeats/FeatureCollector.hpp>
+#include <memory_resource>
 
 #include "testData.hpp"
 
+namespace
+{
+typedef std::vector<std::vector<lowletorfeats::base::FValType>> FeatureVects;
+
+/**
+ * @brief Whether two sets of feature vectors hold the same values. Features
+ *  undefined for a document, e.g. normalized by a zero, are NaN in both.
+ *
+ */
+bool isSameFeatureVects(FeatureVects const & lhs, FeatureVects const & rhs)
+{
+    if (lhs.size() != rhs.size()) return false;
+
+    for (std::size_t docIdx = 0; docIdx < lhs.size(); ++docIdx)
+    {
+        if (lhs[docIdx].size() != rhs[docIdx].size()) return false;
+
+        for (std::size_t i = 0; i < lhs[docIdx].size(); ++i)
+        {
+            auto const lhsVal = lhs[docIdx][i];
+            auto const rhsVal = rhs[docIdx][i];
+            if (lhsVal != rhsVal &&
+                !(std::isnan(lhsVal) && std::isnan(rhsVal)))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get the feature vectors of a new, eagerly evaluated collector.
+ *
+ */
+FeatureVects getEagerFeatureVects(
+    std::vector<std::unordered_map<std::string, std::string>> const & docs,
+    std::string const & queryStr,
+    std::vector<lowletorfeats::base::FeatureKey> const & fKeys)
+{
+    lowletorfeats::FeatureCollector eagerFc(docs, queryStr);
+    eagerFc.collectFeatures(fKeys);
+
+    return eagerFc.getFeatureVects();
+}
+
+/**
+ * @brief Counts the allocations made from another memory resource.
+ *
+ */
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    std::size_t numAllocs = 0;
+
+private:
+    std::pmr::memory_resource * upstream = std::pmr::new_delete_resource();
+
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++this->numAllocs;
+        return this->upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(
+        void * p, std::size_t bytes, std::size_t alignment) override
+    {
+        this->upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(
+        std::pmr::memory_resource const & other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+}  // namespace
+
 int main()
 {
     // Get test data
@@ -17,6 +97,62 @@ int main()
     //
     //
 
+    // Test construction from a per-query arena
+    std::pmr::monotonic_buffer_resource arena;
+    {
+        lowletorfeats::FeatureCollector arenaFc(
+            structDocMap, queryStr, &arena);
+        arenaFc.collectPresetFeatures();
+        arenaFc.getFeatureVects();
+
+        // Assignment keeps the arena of the assigned collector
+        lowletorfeats::FeatureCollector defaultFc(structDocMap, queryStr);
+        defaultFc.collectPresetFeatures();
+        lowletorfeats::FeatureCollector arenaCopyFc(&arena);
+        arenaCopyFc = defaultFc;
+        if (arenaCopyFc.getFeatureString() != defaultFc.getFeatureString())
+            return 1;
+        arenaCopyFc = lowletorfeats::FeatureCollector(defaultFc);
+        arenaCopyFc.reCollectFeatures();
+        if (arenaCopyFc.getFeatureString() != defaultFc.getFeatureString())
+            return 1;
+    }
+    arena.release();
+
+    // Appending to an arena collector keeps its documents in the arena, they
+    //  are moved and not copied out of it when the collector grows
+    {
+        lowletorfeats::FeatureCollector arenaFc(&arena);
+        arenaFc.setQuery(queryStr);
+        arenaFc.addDocs(structDocMap);
+
+        CountingResource countingResource;
+        std::pmr::memory_resource * const defaultResource =
+            std::pmr::set_default_resource(&countingResource);
+        for (std::size_t i = 0; i < 8; ++i) arenaFc.addDocs(structDocMap);
+        std::pmr::set_default_resource(defaultResource);
+
+        if (countingResource.numAllocs != 0) return 1;
+    }
+    arena.release();
+
+    // Test query swap over retained term vectors
+    {
+        lowletorfeats::FeatureCollector retainFc;
+        retainFc.setRetainTermVectors(true);
+        retainFc.isRetainTermVectors();
+        retainFc.setQuery(queryStr);
+        retainFc.addDocs(structDocMap);
+        retainFc.collectPresetFeatures();
+        retainFc.setQuery("white purple");
+        if (!isSameFeatureVects(
+                retainFc.getFeatureVects(),
+                getEagerFeatureVects(
+                    structDocMap, "white purple",
+                    lowletorfeats::FeatureCollector::getPresetFeatureKeys())))
+            return 1;
+    }
+
     // Test public methods
     fc.toString();
     fc.getFeatureString();
@@ -24,18 +160,269 @@ int main()
     fc.collectPresetFeatures();
     fc.reCollectFeatures();
     fc.collectFeatures(lowletorfeats::base::FeatureKey("tfidf.tfidf.full"));
+    fc.addDocs(structDocMap);
+
+    // Appending documents equals collecting over all of them at once
+    {
+        std::vector<std::unordered_map<std::string, std::string>> const
+            firstDocs(structDocMap.begin(), structDocMap.begin() + 1);
+        std::vector<std::unordered_map<std::string, std::string>> const
+            restDocs(structDocMap.begin() + 1, structDocMap.end());
+
+        lowletorfeats::FeatureCollector appendFc(firstDocs, queryStr);
+        appendFc.collectPresetFeatures();
+        appendFc.addDocs(restDocs);
+        appendFc.addDocs(restDocs);
+
+        auto allDocs = structDocMap;
+        allDocs.insert(allDocs.end(), restDocs.begin(), restDocs.end());
+        if (!isSameFeatureVects(
+                appendFc.getFeatureVects(),
+                getEagerFeatureVects(
+                    allDocs, queryStr,
+                    lowletorfeats::FeatureCollector::getPresetFeatureKeys())))
+            return 1;
+    }
 
     // Getter methods
     fc.getNumDocs();
     fc.getNumFeatures();
+    fc.getFeatureKeys();
     fc.getDocVect();
     fc.getFeatureVects();
+    fc.getFeatureValue(0, lowletorfeats::base::FeatureKey("okapi.bm25.body"));
+    fc.getFeatureVector(0);
+    fc.getFeatureColumn(lowletorfeats::base::FeatureKey("lmir.dir.title"));
+    fc.getConstantFeatureMap();
+    lowletorfeats::FeatureCollector::isConstantFeature(
+        lowletorfeats::base::FeatureKey("tfidf.idfdefault.body"));
+
+    // Constant features are stored once and broadcast to every document
+    {
+        std::vector<lowletorfeats::base::FeatureKey> const fKeys = {
+            lowletorfeats::base::FeatureKey("tfidf.idfdefault.body"),
+            lowletorfeats::base::FeatureKey("okapi.bm25.body"),
+            lowletorfeats::base::FeatureKey("tfidf.idfsmooth.title")};
+
+        lowletorfeats::FeatureCollector constFc(structDocMap, queryStr);
+        for (auto const & fKey : fKeys) constFc.collectFeatures(fKey);
+
+        auto const featureVects = constFc.getFeatureVects();
+        auto const & constantFeatureMap = constFc.getConstantFeatureMap();
+        for (std::size_t i = 0; i < fKeys.size(); ++i)
+        {
+            if (!lowletorfeats::FeatureCollector::isConstantFeature(fKeys[i]))
+                continue;
+
+            for (std::size_t docIdx = 0; docIdx < featureVects.size();
+                 ++docIdx)
+            {
+                if (constFc.getDocVect()[docIdx].getFeatureMap().count(
+                        fKeys[i]) != 0 ||
+                    featureVects[docIdx][i] !=
+                        constantFeatureMap.at(fKeys[i]))
+                    return 1;
+            }
+        }
+        if (!isSameFeatureVects(
+                featureVects,
+                getEagerFeatureVects(structDocMap, queryStr, fKeys)))
+            return 1;
+    }
+
+    // Test a feature cascade
+    fc.collectCascadeFeatures(
+        {lowletorfeats::base::FeatureKey("okapi.bm25.full"),
+         lowletorfeats::base::FeatureKey("other.dl.full")},
+        {lowletorfeats::base::FeatureKey("lmir.dir.full"),
+         lowletorfeats::base::FeatureKey("okapi.bm25f.full")},
+        [](std::vector<lowletorfeats::base::FValType> const & fValVect) {
+            return fValVect[0] + fValVect[1];
+        },
+        1);
+    fc.isPruned(0);
+    fc.getPrunedDocs();
+
+    // Pruned documents hold 0 for the expensive features and the surviving
+    //  ones the eagerly computed values, until the expensive features are
+    //  computed for every document again
+    {
+        std::vector<lowletorfeats::base::FeatureKey> const cheapKeys = {
+            lowletorfeats::base::FeatureKey("okapi.bm25.full"),
+            lowletorfeats::base::FeatureKey("other.dl.full")};
+        std::vector<lowletorfeats::base::FeatureKey> const expensiveKeys = {
+            lowletorfeats::base::FeatureKey("lmir.dir.full"),
+            lowletorfeats::base::FeatureKey("okapi.bm25f.full")};
+        auto fKeys = cheapKeys;
+        fKeys.insert(fKeys.end(), expensiveKeys.begin(), expensiveKeys.end());
+        auto const eagerVects =
+            getEagerFeatureVects(structDocMap, queryStr, fKeys);
+
+        lowletorfeats::FeatureCollector cascadeFc(structDocMap, queryStr);
+        auto const survivors = cascadeFc.collectCascadeFeatures(
+            cheapKeys, expensiveKeys,
+            [](std::vector<lowletorfeats::base::FValType> const & fValVect) {
+                return fValVect[1];
+            },
+            1);
+        std::vector<bool> prunedDocs(eagerVects.size(), true);
+        prunedDocs.at(survivors.at(0)) = false;
+        if (survivors.size() != 1 || cascadeFc.getPrunedDocs() != prunedDocs)
+            return 1;
+
+        // Whether pruned documents hold 0 for the first expensive features
+        auto const isCascaded = [&](std::size_t const numPrunedKeys) {
+            auto const cascadeVects = cascadeFc.getFeatureVects();
+            for (std::size_t docIdx = 0; docIdx < eagerVects.size(); ++docIdx)
+            {
+                auto expectedRow = eagerVects[docIdx];
+                if (cascadeFc.isPruned(docIdx))
+                {
+                    for (std::size_t i = 0; i < numPrunedKeys; ++i)
+                        expectedRow[cheapKeys.size() + i] = 0;
+                }
+                if (!isSameFeatureVects(
+                        {cascadeVects[docIdx]}, {expectedRow}))
+                    return false;
+            }
+            return true;
+        };
+        if (!isCascaded(expensiveKeys.size())) return 1;
+
+        // Only "okapi.bm25f.full" is recomputed, the documents stay pruned
+        //  for "lmir.dir.full"
+        cascadeFc.setSectionWeights(
+            {{"full", 0.3},
+             {"title", 1},
+             {"body", 0.4},
+             {"author", 0.9},
+             {"anchor", 0.5},
+             {"url", 0.7}});
+        cascadeFc.reCollectFeatures();
+        if (cascadeFc.getPrunedDocs() != prunedDocs || !isCascaded(1))
+            return 1;
+
+        // Every expensive feature is recomputed, nothing is pruned
+        cascadeFc.setLMIRParameters(0.1f, 2000, 0.7f);
+        cascadeFc.reCollectFeatures();
+        if (cascadeFc.getPrunedDocs() !=
+                std::vector<bool>(eagerVects.size(), false) ||
+            !isSameFeatureVects(cascadeFc.getFeatureVects(), eagerVects))
+            return 1;
+    }
+
+    // Test lazy evaluation
+    fc.setLazyEvaluation(true);
+    fc.isLazyEvaluation();
+    fc.collectPresetFeatures();
+    lowletorfeats::FeatureMatrix fMatrix = fc.getFeatureMatrix();
+    fMatrix.at(0, 0);
+    fMatrix.getColumn(1);
+    fMatrix.getRow(0);
+    fMatrix.getNumDocs();
+    fMatrix.getNumFeatures();
+    fMatrix.getFeatureKeys();
+    fc.reCollectFeatures();
+    lowletorfeats::FeatureCollector const & constFc = fc;
+    constFc.getFeatureString();
+    constFc.getFeatureVects();
+    fc.setLazyEvaluation(false);
+
+    // Lazily computed columns equal eagerly computed ones
+    {
+        lowletorfeats::FeatureCollector lazyFc(structDocMap, queryStr);
+        lazyFc.setLazyEvaluation(true);
+        lazyFc.collectPresetFeatures();
+        lazyFc.getFeatureColumn(
+            lowletorfeats::base::FeatureKey("okapi.bm25.body"));
+        auto const eagerFVects = getEagerFeatureVects(
+            structDocMap, queryStr,
+            lowletorfeats::FeatureCollector::getPresetFeatureKeys());
+        if (!isSameFeatureVects(lazyFc.getFeatureVects(), eagerFVects))
+            return 1;
+
+        // Rows copied in place follow the keys, not the stored order
+        lowletorfeats::FeatureMatrix fMatrix = lazyFc.getFeatureMatrix();
+        FeatureVects copiedFVects(
+            fMatrix.getNumDocs(),
+            std::vector<lowletorfeats::base::FValType>(
+                fMatrix.getNumFeatures()));
+        for (std::size_t docIdx = 0; docIdx < copiedFVects.size(); ++docIdx)
+            fMatrix.copyRow(docIdx, copiedFVects[docIdx].data());
+        if (!isSameFeatureVects(copiedFVects, eagerFVects)) return 1;
+    }
 
     // Setter methods
     std::unordered_map<std::string, float> newSectionWeights = {
         {"full", 0.3},   {"title", 1},    {"body", 0.4},
         {"author", 0.9}, {"anchor", 0.5}, {"url", 0.7}};
     fc.setSectionWeights(newSectionWeights);
+    fc.setLMIRParameters(0.2f, 1500, 0.5f);
+    fc.reCollectFeatures();
+
+    // Recomputing the invalidated features equals collecting them anew
+    {
+        lowletorfeats::FeatureCollector reFc(structDocMap, queryStr);
+        reFc.collectPresetFeatures();
+        newSectionWeights["title"] = 2;
+        reFc.setSectionWeights(newSectionWeights);
+        reFc.setLMIRParameters(0.2f, 1500, 0.5f);
+        reFc.reCollectFeatures();
+
+        lowletorfeats::FeatureCollector eagerFc(structDocMap, queryStr);
+        eagerFc.setSectionWeights(newSectionWeights);
+        eagerFc.setLMIRParameters(0.2f, 1500, 0.5f);
+        eagerFc.collectPresetFeatures();
+        if (!isSameFeatureVects(
+                reFc.getFeatureVects(), eagerFc.getFeatureVects()))
+            return 1;
+    }
+
+    // Dependency tracking
+    lowletorfeats::FeatureCollector::getDependencies(
+        lowletorfeats::base::FeatureKey("okapi.bm25f.full"));
+    fc.invalidateFeatures(lowletorfeats::FeatureCollector::Dependency::all);
+    fc.reCollectFeatures();
+
+    // Compiled feature plans
+    lowletorfeats::FeaturePlan const plan({
+        lowletorfeats::base::FeatureKey("okapi.bm25.body"),
+        lowletorfeats::base::FeatureKey("okapi.bm25plus.body"),
+        lowletorfeats::base::FeatureKey("okapi.bm25f.full"),
+        lowletorfeats::base::FeatureKey("tfidf.idfnorm.title"),
+        lowletorfeats::base::FeatureKey("lmir.jm.body"),
+        lowletorfeats::base::FeatureKey("okapi.bm25.body")});
+    plan.size();
+    plan.isConstant(3);
+    plan.getLMIRSections();
+    fc.collectFeatures(plan);
+    lowletorfeats::FeatureCollector(structDocMap, queryStr)
+        .collectFeatures(plan);
+
+    // Pipeline statistics
+    lowletorfeats::PipelineStats stats = fc.getStats();
+    stats.merge(fc.getStats());
+    stats.getStage(lowletorfeats::PipelineStats::Stage::computeFeatures);
+    stats.getFeatureTimings();
+    stats.toJson();
+    fc.resetStats();
+
+    // Memory accounting
+    lowletorfeats::MemoryStats memStats = fc.getMemoryStats();
+    memStats.merge(fc.getMemoryStats());
+    memStats.getSections();
+    memStats.getTotal().total();
+    memStats.toJson();
+
+    // Tracing
+    {
+        lowletorfeats::TraceRecorder traceRecorder("test_FC.trace.json");
+        fc.setTrace(&traceRecorder, "q1");
+        fc.reCollectFeatures();
+        fc.getFeatureVects();
+        fc.setTrace(nullptr, "");
+    }
+
     // fc.setAnalyzerFunction(lowletorfeats::FeatureCollector::analyzerFun);
 
     return 0;
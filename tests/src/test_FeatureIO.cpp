@@ -0,0 +1,216 @@
+#include <charconv>  // from_chars
+#include <cmath>     // isnan
+#include <fstream>
+#include <lowletorfeats/DocumentReader.hpp>
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/FeatureFile.hpp>
+#include <lowletorfeats/LetorWriter.hpp>
+#include <sstream>
+
+#include "testData.hpp"
+
+namespace
+{
+/**
+ * @brief Whether a token parses back to the value, NaN included.
+ *
+ */
+bool isValueToken(
+    std::string const & token, lowletorfeats::base::FValType const value)
+{
+    lowletorfeats::base::FValType parsedValue;
+    auto const result = std::from_chars(
+        token.data(), token.data() + token.size(), parsedValue);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size())
+        return false;
+
+    return parsedValue == value ||
+           (std::isnan(parsedValue) && std::isnan(value));
+}
+
+/**
+ * @brief Whether a line is the LETOR line of the given document,
+ *  `label qid:<qid> 1:<value> ... #<docid>`.
+ *
+ */
+bool isLetorLine(
+    std::string const & line, lowletorfeats::base::FValType const label,
+    std::string const & qid,
+    std::vector<lowletorfeats::base::FValType> const & row,
+    std::string const & docId)
+{
+    std::istringstream lineStream(line);
+    std::string token;
+
+    if (!(lineStream >> token) || !isValueToken(token, label)) return false;
+    if (!(lineStream >> token) || token != "qid:" + qid) return false;
+
+    for (std::size_t i = 0; i < row.size(); ++i)
+    {
+        std::string const prefix = std::to_string(i + 1) + ":";
+        if (!(lineStream >> token) ||
+            token.compare(0, prefix.size(), prefix) != 0)
+            return false;
+        if (!isValueToken(token.substr(prefix.size()), row[i])) return false;
+    }
+
+    if (!docId.empty() && (!(lineStream >> token) || token != "#" + docId))
+        return false;
+
+    return !(lineStream >> token);
+}
+
+}  // namespace
+
+int main()
+{
+    // Get test data
+    auto const testData = getTestData();
+    auto const queryStr = testData.first;
+    auto const structDocMap = testData.second;
+
+    lowletorfeats::FeatureCollector fc(structDocMap, queryStr);
+    fc.collectPresetFeatures();
+    lowletorfeats::FeatureMatrix fMatrix = fc.getFeatureMatrix();
+
+    std::vector<lowletorfeats::base::FValType> labels;
+    std::vector<std::string> docIds;
+    for (std::size_t docIdx = 0; docIdx < fMatrix.getNumDocs(); ++docIdx)
+    {
+        labels.push_back(static_cast<lowletorfeats::base::FValType>(docIdx));
+        docIds.push_back("doc" + std::to_string(docIdx));
+    }
+
+    // Test LETOR output
+    {
+        lowletorfeats::LetorWriter writer("test_FeatureIO.letor.txt");
+        writer.writeQuery(fMatrix, "1", labels, docIds);
+        writer.writeQuery(fMatrix, "2");
+        auto const row = fMatrix.getRow(0);
+        writer.writeRow(1, "3", row.data(), row.size(), "doc0");
+        writer.flush();
+        writer.close();
+    }
+    {
+        std::ifstream inStream("test_FeatureIO.letor.txt");
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(inStream, line);)
+            lines.push_back(line);
+        if (lines.size() != 2 * fMatrix.getNumDocs() + 1) return 1;
+
+        std::size_t const numDocs = fMatrix.getNumDocs();
+        for (std::size_t docIdx = 0; docIdx < numDocs; ++docIdx)
+        {
+            auto const row = fMatrix.getRow(docIdx);
+            if (!isLetorLine(
+                    lines[docIdx], labels[docIdx], "1", row, docIds[docIdx]) ||
+                !isLetorLine(lines[numDocs + docIdx], 0, "2", row, ""))
+                return 1;
+        }
+        if (!isLetorLine(lines.back(), 1, "3", fMatrix.getRow(0), "doc0"))
+            return 1;
+    }
+
+    // Test the binary feature file, next to a file its spool must not touch
+    {
+        std::ofstream("test_FeatureIO.feats.rows") << "user data\n";
+    }
+    {
+        lowletorfeats::FeatureFileWriter writer(
+            "test_FeatureIO.feats", fMatrix.getFeatureKeys());
+        writer.writeQuery(fMatrix, "1", labels, docIds);
+        writer.writeQuery(fMatrix, "2");
+        writer.close();
+    }
+    {
+        lowletorfeats::FeatureFileReader reader("test_FeatureIO.feats");
+        auto const queryGroup = reader.getQueryGroup(1);
+        double const * column = reader.getColumnData<double>(0);
+        if (reader.getNumDocs() != 2 * fMatrix.getNumDocs() ||
+            reader.getFeatureKeys() != fMatrix.getFeatureKeys() ||
+            queryGroup.qid != "2" ||
+            column[queryGroup.firstDoc] != fMatrix.at(0, 0) ||
+            reader.getDocId(0) != "doc0" || reader.getLabel(1) != 1)
+            return 1;
+
+        std::ifstream inStream("test_FeatureIO.feats.rows");
+        std::string line;
+        if (!std::getline(inStream, line) || line != "user data") return 1;
+    }
+
+    // Test streaming documents
+    {
+        std::ofstream outStream("test_FeatureIO.jsonl");
+        outStream
+            << "{\"qid\": \"1\", \"docid\": \"a\", \"label\": 2,"
+               " \"query\": \"hello world\", \"sections\":"
+               " {\"title\": \"hello\", \"body\": \"hello \\\"world\\\"\"}}\n"
+            << "{\"qid\": \"1\", \"docid\": \"b\", \"extra\": [1, {}],"
+               " \"sections\": {\"title\": \"\", \"body\": \"world\"}}\n"
+            << "\n"
+            << "{\"qid\": 2, \"sections\": {\"body\": \"hello\"}}\n";
+    }
+    {
+        lowletorfeats::DocumentReader reader("test_FeatureIO.jsonl");
+        lowletorfeats::DocumentReader::QueryGroup group;
+        std::size_t numGroups = 0;
+        while (reader.next(group))
+        {
+            lowletorfeats::FeatureCollector groupFc;
+            groupFc.setQuery(std::string(group.query));
+            groupFc.addDocs(group.docs);
+            groupFc.collectPresetFeatures();
+            ++numGroups;
+
+            if (numGroups == 1 &&
+                (group.qid != "1" || group.query != "hello world" ||
+                 group.docIds !=
+                     std::vector<std::string_view>{"a", "b"} ||
+                 group.labels !=
+                     std::vector<lowletorfeats::base::FValType>{2, 0} ||
+                 group.docs[0] !=
+                     lowletorfeats::base::StrViewPairVector{
+                         {"title", "hello"}, {"body", "hello \"world\""}} ||
+                 group.docs[1] !=
+                     lowletorfeats::base::StrViewPairVector{
+                         {"title", ""}, {"body", "world"}}))
+                return 1;
+            if (numGroups == 2 &&
+                (group.qid != "2" ||
+                 group.docIds != std::vector<std::string_view>{""} ||
+                 group.labels !=
+                     std::vector<lowletorfeats::base::FValType>{0}))
+                return 1;
+        }
+        if (numGroups != 2) return 1;
+    }
+
+    // A malformed line is reported after the group before it
+    {
+        std::ofstream outStream("test_FeatureIO.malformed.jsonl");
+        outStream << "{\"qid\": \"1\", \"docid\": \"a\"}\n"
+                  << "{\"qid\": \"1\", \"docid\": \"b\"}\n"
+                  << "{\"qid\": \"2\", \"docid\": }\n";
+    }
+    {
+        lowletorfeats::DocumentReader reader(
+            "test_FeatureIO.malformed.jsonl");
+        lowletorfeats::DocumentReader::QueryGroup group;
+        if (!reader.next(group) ||
+            group.docIds != std::vector<std::string_view>{"a", "b"})
+            return 1;
+
+        bool isReported = false;
+        try
+        {
+            reader.next(group);
+        }
+        catch (std::runtime_error const & e)
+        {
+            isReported = std::string(e.what()).compare(0, 7, "Line 3:") == 0;
+        }
+        if (!isReported) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <sys/socket.h>  // socket, connect
+#include <sys/un.h>      // sockaddr_un
+#include <unistd.h>      // getpid, read, write, close
+
+#include <algorithm>  // equal
+#include <cstring>    // memcpy
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/FeatureServer.hpp>
+#include <thread>
+
+#include "testData.hpp"
+
+int main()
+{
+    // Get test data
+    auto const testData = getTestData();
+    auto const queryStr = testData.first;
+    auto const structDocMap = testData.second;
+
+    std::vector<lowletorfeats::base::StrViewPairVector> docViews;
+    for (auto const & docTextMap : structDocMap)
+        docViews.emplace_back(docTextMap.begin(), docTextMap.end());
+
+    lowletorfeats::InvertedIndex const index(structDocMap);
+    std::vector<std::string> docIds;
+    for (std::size_t i = 0; i < structDocMap.size(); ++i)
+        docIds.push_back("d" + std::to_string(i));
+
+    lowletorfeats::FeaturePlan const plan(
+        {lowletorfeats::base::FeatureKey("okapi.bm25.body"),
+         lowletorfeats::base::FeatureKey("tfidf.tfidf.full"),
+         lowletorfeats::base::FeatureKey("lmir.dir.title")});
+
+    std::string const socketPath =
+        "/tmp/lowletorfeats.test_" + std::to_string(::getpid()) + ".sock";
+
+    lowletorfeats::FeatureServer::Options options;
+    options.numWorkers = 2;
+    lowletorfeats::FeatureServer server(plan, options);
+    server.setIndex(index, docIds);
+    server.listen(socketPath);
+    std::thread serverThread([&server]() { server.run(); });
+
+    int status = 0;
+    try
+    {
+        lowletorfeats::FeatureClient client(socketPath);
+        if (client.getFeatureKeys() != plan.getFeatureKeys()) status = 1;
+
+        // Test against a local collection
+        lowletorfeats::FeatureCollector fc(structDocMap, queryStr);
+        fc.collectFeatures(plan);
+        auto const fVects = fc.getFeatureVects();
+
+        lowletorfeats::FeatureClient::FeatureRows rows;
+        client.getFeatures(queryStr, docViews, rows);
+        for (std::size_t docIdx = 0; docIdx < rows.numDocs; ++docIdx)
+            if (std::vector<lowletorfeats::base::FValType>(
+                    rows.getRow(docIdx),
+                    rows.getRow(docIdx) + rows.numFeatures) !=
+                fVects.at(docIdx))
+                status = 1;
+        if (rows.numDocs != structDocMap.size()) status = 1;
+
+        // Indexed documents are scored against the whole index, as by a
+        //  collection of every indexed document
+        std::vector<lowletorfeats::base::DocId> allIds(index.getNumDocs());
+        for (std::size_t docId = 0; docId < allIds.size(); ++docId)
+            allIds[docId] = static_cast<lowletorfeats::base::DocId>(docId);
+        lowletorfeats::FeatureCollector allFc;
+        allFc.setQuery(queryStr);
+        allFc.addDocs(index, allIds);
+        allFc.collectFeatures(plan);
+
+        std::vector<std::string_view> const requestIds = {"d1", "d0"};
+        client.getFeatures(queryStr, requestIds, rows);
+        if (rows.numDocs != 2 || rows.numFeatures != 3) status = 1;
+        for (std::size_t docIdx = 0; docIdx < rows.numDocs; ++docIdx)
+        {
+            auto const expectedRow = allFc.getFeatureVector(1 - docIdx);
+            if (!std::equal(
+                    expectedRow.begin(), expectedRow.end(),
+                    rows.getRow(docIdx)))
+                status = 1;
+        }
+
+        // Test that an invalid request fails without closing the connection
+        try
+        {
+            client.getFeatures(queryStr, {"unknown"}, rows);
+            status = 1;
+        }
+        catch (std::runtime_error const &)
+        {
+        }
+        client.getFeatures(queryStr, requestIds, rows);
+
+        // Test that a request announcing more documents than it holds is
+        //  rejected
+        {
+            std::string message;
+            auto const appendUint32 = [&message](std::uint32_t const value) {
+                message.append(
+                    reinterpret_cast<char const *>(&value), sizeof(value));
+            };
+            appendUint32(1 + 2 * sizeof(std::uint32_t));  // Payload size
+            message += static_cast<char>(
+                lowletorfeats::featureserver::RequestType::docIds);
+            appendUint32(0);           // Empty query
+            appendUint32(0xFFFFFFFF);  // Number of documents
+
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            std::memcpy(
+                address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+            int const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            char response[5] = {};
+            if (::connect(
+                    fd, reinterpret_cast<sockaddr const *>(&address),
+                    sizeof(address)) != 0 ||
+                ::write(fd, message.data(), message.size()) !=
+                    static_cast<ssize_t>(message.size()) ||
+                ::read(fd, response, sizeof(response)) !=
+                    static_cast<ssize_t>(sizeof(response)) ||
+                response[4] !=
+                    static_cast<char>(
+                        lowletorfeats::featureserver::Status::error))
+                status = 1;
+            ::close(fd);
+        }
+
+        // Test concurrent clients
+        lowletorfeats::FeatureClient otherClient(socketPath);
+        otherClient.getFeatures(queryStr, requestIds, rows);
+    }
+    catch (std::exception const &)
+    {
+        status = 1;
+    }
+
+    server.stop();
+    serverThread.join();
+    server.getRequestTiming();
+
+    // Test that a request whose response could not be sent fails without
+    //  closing the connection
+    {
+        auto const & wideFKeys =
+            lowletorfeats::FeatureCollector::getPresetFeatureKeys();
+        lowletorfeats::FeatureServer wideServer(
+            lowletorfeats::FeaturePlan(wideFKeys), options);
+        std::string const wideSocketPath = socketPath + ".wide";
+        wideServer.listen(wideSocketPath);
+        std::thread wideThread([&wideServer]() { wideServer.run(); });
+
+        try
+        {
+            lowletorfeats::FeatureClient client(wideSocketPath);
+            lowletorfeats::FeatureClient::FeatureRows rows;
+
+            // Documents without sections take 4 bytes of the request
+            std::vector<lowletorfeats::base::StrViewPairVector> const
+                emptyDocs(
+                    lowletorfeats::featureserver::MAX_MESSAGE_SIZE /
+                        (wideFKeys.size() *
+                         sizeof(lowletorfeats::base::FValType)) +
+                    1);
+            try
+            {
+                client.getFeatures(queryStr, emptyDocs, rows);
+                status = 1;
+            }
+            catch (std::runtime_error const &)
+            {
+            }
+            if (client.getFeatureKeys() != wideFKeys) status = 1;
+        }
+        catch (std::exception const &)
+        {
+            status = 1;
+        }
+
+        wideServer.stop();
+        wideThread.join();
+    }
+
+    return status;
+}
@@ -0,0 +1,38 @@
+#include <lowletorfeats/base/stdDef.hpp>
+#include <lowletorfeats/utils.hpp>
+#include <memory_resource>
+
+int main()
+{
+    // Test constructors
+    lowletorfeats::base::FlatStrSizeMap flatMap;
+    flatMap = lowletorfeats::base::FlatStrSizeMap({{"van", 1}, {"face", 2}});
+
+    lowletorfeats::base::StrSizeMap const hashMap = {
+        {"helsing", 3}, {"white", 1}};
+    flatMap = lowletorfeats::base::FlatStrSizeMap(
+        hashMap.begin(), hashMap.end());
+
+    std::pmr::monotonic_buffer_resource arena;
+    lowletorfeats::base::FlatStrSizeMap arenaMap(&arena);
+    arenaMap = flatMap;
+
+    // Test public methods
+    flatMap["purple"] += 2;
+    flatMap.insert({"grow", 1});
+    flatMap.insert(hashMap.begin(), hashMap.end());
+    flatMap.find("helsing");
+    flatMap.count("turns");
+    flatMap.at("white");
+    flatMap.erase("grow");
+    flatMap.size();
+    flatMap.empty();
+    flatMap.clear();
+
+    // Test sorted intersection
+    lowletorfeats::base::FlatStrSizeMap const otherMap = {
+        {"face", 4}, {"helsing", 1}, {"purple", 2}};
+    arenaMap = lowletorfeats::utils::getIntersection(arenaMap, otherMap);
+
+    return 0;
+}
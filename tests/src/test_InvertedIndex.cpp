@@ -0,0 +1,265 @@
+#include <algorithm>  // max, sort
+#include <cmath>      // fabs, isnan
+#include <lowletorfeats/ExhaustiveScorer.hpp>
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <lowletorfeats/Okapi.hpp>
+#include <lowletorfeats/TopKRetriever.hpp>
+
+#include "testData.hpp"
+
+namespace
+{
+/**
+ * @brief Whether top-k retrieval over a section matches scoring every
+ *  document containing a query term.
+ *
+ */
+bool isSameAsBruteForce(
+    lowletorfeats::InvertedIndex const & index,
+    std::vector<lowletorfeats::base::StructuredTermFrequencyMap> const &
+        docTfMapVect,
+    lowletorfeats::base::StrSizeMap const & queryTfMap,
+    lowletorfeats::TopKRetriever::Model const model, std::size_t const k)
+{
+    std::string const sectionKey = "body";
+    std::size_t const numDocs = docTfMapVect.size();
+    float const avgDocLen = index.getAvgDocLen(sectionKey);
+
+    lowletorfeats::base::StrSizeMap numDocsWithTerm;
+    for (auto const & docTfMap : docTfMapVect)
+    {
+        for (auto const & mapPair : docTfMap.at(sectionKey))
+            ++numDocsWithTerm[mapPair.first];
+    }
+
+    // Sum in query term order, as the retriever does
+    std::vector<lowletorfeats::ScoredDoc> scoredDocs;
+    for (std::size_t docId = 0; docId < numDocs; ++docId)
+    {
+        auto const & sectionTfMap = docTfMapVect[docId].at(sectionKey);
+
+        bool hasTerm = false;
+        lowletorfeats::base::FValType score = 0;
+        for (auto const & mapPair : queryTfMap)
+        {
+            auto const tfIt = sectionTfMap.find(mapPair.first);
+            if (tfIt == sectionTfMap.end()) continue;
+
+            hasTerm = true;
+            auto const df = numDocsWithTerm.at(mapPair.first);
+            score +=
+                (model == lowletorfeats::TopKRetriever::Model::bm25plus)
+                    ? lowletorfeats::Okapi::bm25plus(
+                          tfIt->second, numDocs, df, avgDocLen)
+                    : lowletorfeats::Okapi::bm25(
+                          tfIt->second, numDocs, df, avgDocLen);
+        }
+        if (hasTerm)
+            scoredDocs.push_back(
+                {static_cast<lowletorfeats::base::DocId>(docId), score});
+    }
+
+    std::sort(
+        scoredDocs.begin(), scoredDocs.end(),
+        [](lowletorfeats::ScoredDoc const & a,
+           lowletorfeats::ScoredDoc const & b) {
+            return a.score > b.score ||
+                   (a.score == b.score && a.docId < b.docId);
+        });
+    if (scoredDocs.size() > k) scoredDocs.resize(k);
+
+    auto const topDocs =
+        lowletorfeats::TopKRetriever(index, sectionKey, model)
+            .retrieve(queryTfMap, k);
+    if (topDocs.size() != scoredDocs.size()) return false;
+    for (std::size_t i = 0; i < topDocs.size(); ++i)
+    {
+        if (topDocs[i].docId != scoredDocs[i].docId ||
+            topDocs[i].score != scoredDocs[i].score)
+            return false;
+    }
+
+    return true;
+}
+
+}  // namespace
+
+int main()
+{
+    // Get test data
+    auto const testData = getTestData();
+    auto const queryStr = testData.first;
+    auto const structDocMap = testData.second;
+
+    // Test constructors
+    lowletorfeats::InvertedIndex index;
+    index = lowletorfeats::InvertedIndex(structDocMap);
+
+    // Test public methods
+    index.addDocs(structDocMap);
+    lowletorfeats::base::StrSizeMap docLenMap;
+    lowletorfeats::base::StructuredTermFrequencyMap docTfMap;
+    index.getDocument(0, docLenMap, docTfMap);
+    auto const queryTfMap =
+        lowletorfeats::InvertedIndex::analyzeQuery(queryStr);
+
+    // Getter methods
+    index.getNumDocs();
+    index.getNumTerms();
+    index.hasSection("body");
+    index.getAvgDocLen("body");
+    index.getDocLen(0, "body");
+    lowletorfeats::base::TermId termId;
+    if (index.findTermId("helsing", termId))
+    {
+        index.getTerm(termId);
+        index.findPostings("body", termId);
+    }
+
+    // Test top-k retrieval
+    lowletorfeats::TopKRetriever retriever(index);
+    auto const topDocs = retriever.retrieve(queryStr, 2);
+    retriever.retrieve(queryTfMap, 10);
+    lowletorfeats::TopKRetriever(
+        index, "body", lowletorfeats::TopKRetriever::Model::bm25plus)
+        .retrieve(queryStr, 3);
+
+    // Top-k retrieval equals brute-force scoring over several blocks of
+    //  postings, with a term in most documents having a negative idf
+    {
+        std::size_t const numDocs =
+            lowletorfeats::InvertedIndex::BLOCK_SIZE * 5 + 17;
+        std::vector<lowletorfeats::base::StrSizeMap> docLenMapVect;
+        std::vector<lowletorfeats::base::StructuredTermFrequencyMap>
+            docTfMapVect;
+        std::size_t seed = 7;
+        auto const nextRand = [&seed](std::size_t const bound) {
+            seed = (seed * 1103515245 + 12345) % 2147483648;
+            return (seed / 65536) % bound;
+        };
+        for (std::size_t docId = 0; docId < numDocs; ++docId)
+        {
+            lowletorfeats::base::StrSizeMap bodyTfMap;
+            if (nextRand(10) < 9) bodyTfMap["common"] = 1 + nextRand(4);
+            if (nextRand(3) == 0) bodyTfMap["middle"] = 1 + nextRand(6);
+            if (nextRand(40) == 0) bodyTfMap["rare"] = 1 + nextRand(20);
+            bodyTfMap["filler"] = 1 + nextRand(50);
+
+            std::size_t docLen = 0;
+            for (auto const & mapPair : bodyTfMap) docLen += mapPair.second;
+            docLenMapVect.push_back({{"body", docLen}});
+            docTfMapVect.push_back({{"body", bodyTfMap}});
+        }
+        lowletorfeats::InvertedIndex const blockIndex(
+            docLenMapVect, docTfMapVect);
+
+        for (auto const model :
+             {lowletorfeats::TopKRetriever::Model::bm25,
+              lowletorfeats::TopKRetriever::Model::bm25plus})
+        {
+            for (std::size_t const k : {1, 3, 10, 50, 400})
+            {
+                if (!isSameAsBruteForce(
+                        blockIndex, docTfMapVect,
+                        {{"common", 1}, {"middle", 1}, {"rare", 1}}, model,
+                        k) ||
+                    !isSameAsBruteForce(
+                        blockIndex, docTfMapVect,
+                        {{"common", 1}, {"unknown", 1}}, model, k))
+                    return 1;
+            }
+        }
+    }
+
+    // Test exhaustive scoring
+    lowletorfeats::ExhaustiveScorer scorer(
+        index, {lowletorfeats::base::FeatureKey("okapi.bm25.full"),
+                lowletorfeats::base::FeatureKey("lmir.dir.body"),
+                lowletorfeats::base::FeatureKey("okapi.bm25f.full")});
+    scorer.setSectionWeights({{"title", 1}, {"body", 0.5}});
+    scorer.setLMIRParameters(0.1f, 2000, 0.7f);
+    scorer.getFeatureKeys();
+    scorer.score(
+        queryStr,
+        [](lowletorfeats::base::DocId const,
+           std::vector<lowletorfeats::base::FValType> const &) {});
+
+    // Streamed rows equal the features of a collector over every document
+    {
+        std::unordered_map<std::string, lowletorfeats::base::WeightType> const
+            sectionWeights = {{"title", 1}, {"body", 0.5}};
+        lowletorfeats::ExhaustiveScorer presetScorer(
+            index, lowletorfeats::FeatureCollector::getPresetFeatureKeys());
+        presetScorer.setSectionWeights(sectionWeights);
+        presetScorer.setLMIRParameters(0.2f, 1500, 0.5f);
+
+        std::vector<lowletorfeats::base::DocId> allIds(index.getNumDocs());
+        for (std::size_t docId = 0; docId < allIds.size(); ++docId)
+            allIds[docId] = static_cast<lowletorfeats::base::DocId>(docId);
+        lowletorfeats::FeatureCollector allFc;
+        allFc.setQuery(queryStr);
+        allFc.addDocs(index, allIds);
+        allFc.setSectionWeights(sectionWeights);
+        allFc.setLMIRParameters(0.2f, 1500, 0.5f);
+        allFc.collectPresetFeatures();
+
+        // `bm25f` sums over the sections in another order, some features
+        //  are NaN or infinite
+        auto const isNear = [](lowletorfeats::base::FValType const a,
+                               lowletorfeats::base::FValType const b) {
+            return a == b || (std::isnan(a) && std::isnan(b)) ||
+                   std::fabs(a - b) <=
+                       1e-5 * std::max<lowletorfeats::base::FValType>(
+                                  1, std::fabs(b));
+        };
+
+        bool isSame = true;
+        std::size_t const numScored = presetScorer.score(
+            queryStr,
+            [&](lowletorfeats::base::DocId const docId,
+                std::vector<lowletorfeats::base::FValType> const & row) {
+                auto const expectedRow = allFc.getFeatureVector(docId);
+                for (std::size_t i = 0; i < row.size(); ++i)
+                    isSame = isSame && isNear(row[i], expectedRow[i]);
+            });
+        if (!isSame || numScored != allIds.size()) return 1;
+
+        // Selected documents are streamed in the given order against the
+        //  same statistics
+        std::vector<lowletorfeats::base::DocId> const selectedIds(
+            allIds.rbegin(), allIds.rend());
+        std::size_t rowIdx = 0;
+        presetScorer.score(
+            queryStr, selectedIds,
+            [&](lowletorfeats::base::DocId const docId,
+                std::vector<lowletorfeats::base::FValType> const & row) {
+                isSame = isSame && docId == selectedIds[rowIdx++];
+                auto const expectedRow = allFc.getFeatureVector(docId);
+                for (std::size_t i = 0; i < row.size(); ++i)
+                    isSame = isSame && isNear(row[i], expectedRow[i]);
+            });
+        if (!isSame || rowIdx != selectedIds.size()) return 1;
+
+        try
+        {
+            presetScorer.score(
+                queryStr,
+                {static_cast<lowletorfeats::base::DocId>(allIds.size())},
+                [](lowletorfeats::base::DocId const,
+                   std::vector<lowletorfeats::base::FValType> const &) {});
+            return 1;
+        }
+        catch (std::runtime_error const &)
+        {
+        }
+    }
+
+    // Collect features for the retrieved documents
+    lowletorfeats::FeatureCollector fc;
+    fc.setQuery(queryStr);
+    fc.addDocs(index, lowletorfeats::TopKRetriever::getDocIds(topDocs));
+    fc.collectPresetFeatures();
+
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include <unistd.h>  // STDOUT_FILENO
+
+#include <algorithm>  // max
+#include <chrono>
+#include <cstdio>   // fprintf
+#include <cstdlib>  // EXIT_SUCCESS, EXIT_FAILURE
+#include <fstream>
+#include <lowletorfeats/DocumentReader.hpp>
+#include <lowletorfeats/ExtractionPipeline.hpp>
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/FeatureFile.hpp>
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <lowletorfeats/LetorWriter.hpp>
+#include <lowletorfeats/TopKRetriever.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "toolUtils.hpp"
+
+using namespace lowletorfeats;
+
+namespace
+{
+char const USAGE[] =
+    "Usage:\n"
+    "  lowletorfeats-extract --docs=<docs.jsonl> [options]\n"
+    "  lowletorfeats-extract --index=<corpus.jsonl> --queries=<queries.tsv>"
+    " [options]\n"
+    "\n"
+    "Sources:\n"
+    "  --docs=<file>      Query groups of candidate documents, JSON Lines\n"
+    "  --index=<file>     Corpus indexed in memory, JSON Lines, the top\n"
+    "                     documents of every query are retrieved from it\n"
+    "  --queries=<file>   Lines of \"qid<TAB>query\", required with --index,\n"
+    "                     overrides the query texts of --docs otherwise\n"
+    "  --top-k=<n>        Documents retrieved per query (100)\n"
+    "\n"
+    "Options:\n"
+    "  --features=<spec>  \"preset\", comma separated keys, or @file with\n"
+    "                     a key per line (preset)\n"
+    "  --threads=<n>      Analysis and scoring threads (hardware threads)\n"
+    "  --queue=<n>        Queries waiting between two stages (4)\n"
+    "  --format=<format>  \"letor\" or \"binary\" (letor)\n"
+    "  --float32          Store binary values in single precision\n"
+    "  --output=<file>    Output path, standard output for letor if omitted\n"
+    "  --trace=<file>     Write a Chrome trace of every query\n"
+    "  --help             Print this help\n"
+    "\n"
+    "Throughput and per-stage timings are printed to standard error as "
+    "JSON.\n";
+
+struct ExtractOptions
+{
+    std::string docsPath;
+    std::string indexPath;
+    std::string queriesPath;
+    std::size_t topK = 100;
+
+    std::string featureSpec = "preset";
+    std::size_t numThreads = 1;
+    std::size_t queueCapacity = 4;
+    std::string format = "letor";
+    bool float32 = false;
+    std::string outputPath;
+    std::string tracePath;
+};
+
+/**
+ * @brief Parse the command line. Returns false if the help was requested.
+ *
+ */
+bool parseOptions(int const argc, char ** argv, ExtractOptions & options)
+{
+    options.numThreads =
+        std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (arg == "--float32")
+        {
+            options.float32 = true;
+            continue;
+        }
+
+        std::size_t const eqPos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eqPos == std::string::npos)
+            throw std::runtime_error("Unknown argument '" + arg + "'");
+        std::string const name = arg.substr(2, eqPos - 2);
+        std::string const value = arg.substr(eqPos + 1);
+
+        if (name == "docs")
+            options.docsPath = value;
+        else if (name == "index")
+            options.indexPath = value;
+        else if (name == "queries")
+            options.queriesPath = value;
+        else if (name == "top-k")
+            options.topK = tools::parseCount(name, value);
+        else if (name == "features")
+            options.featureSpec = value;
+        else if (name == "threads")
+            options.numThreads = tools::parseCount(name, value);
+        else if (name == "queue")
+            options.queueCapacity = tools::parseCount(name, value);
+        else if (name == "format")
+            options.format = value;
+        else if (name == "output")
+            options.outputPath = value;
+        else if (name == "trace")
+            options.tracePath = value;
+        else
+            throw std::runtime_error("Unknown option '--" + name + "'");
+    }
+
+    if (options.docsPath.empty() == options.indexPath.empty())
+        throw std::runtime_error("Expected exactly one of --docs and --index");
+    if (!options.indexPath.empty() && options.queriesPath.empty())
+        throw std::runtime_error("--index requires --queries");
+    if (options.format != "letor" && options.format != "binary")
+        throw std::runtime_error(
+            "Unknown format '" + options.format + "'");
+    if (options.format == "binary" && options.outputPath.empty())
+        throw std::runtime_error("The binary format requires --output");
+
+    return true;
+}
+
+/**
+ * @brief Read the "qid<TAB>query" lines of a file, in order.
+ *
+ */
+std::vector<std::pair<std::string, std::string>> readQueries(
+    std::string const & path)
+{
+    std::ifstream inFile(path);
+    if (!inFile) throw std::runtime_error("Could not open '" + path + "'");
+
+    std::vector<std::pair<std::string, std::string>> queries;
+    std::string line;
+    for (std::size_t lineNum = 1; std::getline(inFile, line); ++lineNum)
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        std::size_t const tabPos = line.find('\t');
+        if (tabPos == std::string::npos)
+            throw std::runtime_error(
+                path + ": Line " + std::to_string(lineNum) +
+                ": Expected \"qid<TAB>query\"");
+        queries.emplace_back(line.substr(0, tabPos), line.substr(tabPos + 1));
+    }
+
+    return queries;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    ExtractOptions options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+        {
+            std::fputs(USAGE, stdout);
+            return EXIT_SUCCESS;
+        }
+
+        FeaturePlan const plan(tools::parseFeatureSpec(options.featureSpec));
+
+        std::unique_ptr<TraceRecorder> traceRecorder;
+        if (!options.tracePath.empty())
+            traceRecorder = std::make_unique<TraceRecorder>(options.tracePath);
+
+        ExtractionPipeline::Options pipelineOptions;
+        pipelineOptions.analyzeThreads = options.numThreads;
+        pipelineOptions.scoreThreads = options.numThreads;
+        pipelineOptions.queueCapacity = options.queueCapacity;
+        pipelineOptions.traceRecorder = traceRecorder.get();
+        ExtractionPipeline pipeline(plan, pipelineOptions);
+
+        /* Output */
+
+        std::unique_ptr<LetorWriter> letorWriter;
+        std::unique_ptr<FeatureFileWriter> fileWriter;
+        if (options.format == "binary")
+            fileWriter = std::make_unique<FeatureFileWriter>(
+                options.outputPath, plan.getFeatureKeys(),
+                options.float32 ? featurefile::ValueType::float32
+                                : featurefile::ValueType::float64);
+        else if (options.outputPath.empty() || options.outputPath == "-")
+            letorWriter = std::make_unique<LetorWriter>(STDOUT_FILENO);
+        else
+            letorWriter = std::make_unique<LetorWriter>(options.outputPath);
+
+        auto const writeFun = [&](ExtractionPipeline::QueryTask & task) {
+            if (task.fc->getNumDocs() == 0) return;
+
+            FeatureMatrix fMatrix = task.fc->getFeatureMatrix();
+            if (fileWriter)
+                fileWriter->writeQuery(
+                    fMatrix, task.qid, task.labels, task.docIds);
+            else
+                letorWriter->writeQuery(
+                    fMatrix, task.qid, task.labels, task.docIds);
+        };
+
+        /* Input */
+
+        std::vector<std::pair<std::string, std::string>> queries;
+        if (!options.queriesPath.empty())
+            queries = readQueries(options.queriesPath);
+
+        std::unique_ptr<DocumentReader> reader;
+        InvertedIndex index;
+        std::vector<std::string> indexDocIds;
+        std::unique_ptr<TopKRetriever> retriever;
+        ExtractionPipeline::ReadFunction readFun;
+
+        if (!options.docsPath.empty())
+        {
+            reader = std::make_unique<DocumentReader>(options.docsPath);
+            readFun = ExtractionPipeline::readDocuments(*reader);
+
+            if (!queries.empty())
+            {
+                // Replace the query texts of the listed queries
+                auto queryMap = std::make_shared<
+                    std::unordered_map<std::string, std::string>>(
+                    queries.begin(), queries.end());
+                readFun = [readDocs = std::move(readFun),
+                           queryMap](ExtractionPipeline::QueryTask & task) {
+                    if (!readDocs(task)) return false;
+
+                    auto const queryIt = queryMap->find(task.qid);
+                    if (queryIt != queryMap->end())
+                        task.query = queryIt->second;
+
+                    return true;
+                };
+            }
+        }
+        else
+        {
+            auto const start = std::chrono::steady_clock::now();
+            tools::buildIndex(options.indexPath, index, indexDocIds);
+            retriever = std::make_unique<TopKRetriever>(index);
+            std::fprintf(
+                stderr, "{\"index_docs\":%zu,\"index_seconds\":%f}\n",
+                index.getNumDocs(),
+                std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+
+            // Queries are taken in order, the retrieved documents are read
+            //  from the index during the analysis
+            std::size_t queryIdx = 0;
+            readFun = [&](ExtractionPipeline::QueryTask & task) {
+                if (queryIdx == queries.size()) return false;
+
+                task.qid = queries[queryIdx].first;
+                task.query = queries[queryIdx].second;
+                ++queryIdx;
+
+                return true;
+            };
+            pipeline.setAnalyzeFunction(
+                [&](ExtractionPipeline::QueryTask & task) {
+                    std::vector<base::DocId> const topDocIds =
+                        TopKRetriever::getDocIds(
+                            retriever->retrieve(task.query, options.topK));
+
+                    task.fc->setQuery(task.query);
+                    task.fc->addDocs(index, topDocIds);
+
+                    task.labels.clear();
+                    task.docIds.clear();
+                    for (base::DocId const docId : topDocIds)
+                        task.docIds.push_back(indexDocIds[docId]);
+                });
+        }
+
+        pipeline.run(readFun, writeFun);
+
+        if (fileWriter) fileWriter->close();
+        if (letorWriter) letorWriter->close();
+
+        std::fprintf(stderr, "%s\n", pipeline.toJson().c_str());
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "lowletorfeats-extract: %s\n", e.what());
+        if (argc <= 1) std::fputs(USAGE, stderr);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,274 @@
+#include <algorithm>  // max, sort
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>   // fprintf, printf
+#include <cstdlib>  // EXIT_SUCCESS, EXIT_FAILURE
+#include <deque>
+#include <lowletorfeats/DocumentReader.hpp>
+#include <lowletorfeats/ExtractionPipeline.hpp>
+#include <lowletorfeats/FeatureServer.hpp>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "toolUtils.hpp"
+
+using namespace lowletorfeats;
+
+namespace
+{
+char const USAGE[] =
+    "Usage:\n"
+    "  lowletorfeats-loadtest --socket=<path> --docs=<docs.jsonl> [options]\n"
+    "\n"
+    "Replays the query groups of a JSON Lines file against a running\n"
+    "lowletorfeats-server and prints throughput and latency percentiles as\n"
+    "JSON.\n"
+    "\n"
+    "Options:\n"
+    "  --mode=<mode>        \"texts\" sends the document texts, \"ids\"\n"
+    "                       their ids to a server with an index (texts)\n"
+    "  --connections=<n>    Concurrent clients (4)\n"
+    "  --requests=<n>       Measured requests over all clients (1000)\n"
+    "  --warmup=<n>         Unmeasured requests per client first (10)\n"
+    "  --help               Print this help\n";
+
+struct LoadTestOptions
+{
+    std::string socketPath;
+    std::string docsPath;
+    bool sendIds = false;
+    std::size_t numConnections = 4;
+    std::size_t numRequests = 1000;
+    std::size_t numWarmup = 10;
+};
+
+/**
+ * @brief Parse the command line. Returns false if the help was requested.
+ *
+ */
+bool parseOptions(int const argc, char ** argv, LoadTestOptions & options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+
+        std::size_t const eqPos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eqPos == std::string::npos)
+            throw std::runtime_error("Unknown argument '" + arg + "'");
+        std::string const name = arg.substr(2, eqPos - 2);
+        std::string const value = arg.substr(eqPos + 1);
+
+        if (name == "socket")
+            options.socketPath = value;
+        else if (name == "docs")
+            options.docsPath = value;
+        else if (name == "mode")
+        {
+            if (value != "texts" && value != "ids")
+                throw std::runtime_error("Unknown mode '" + value + "'");
+            options.sendIds = (value == "ids");
+        }
+        else if (name == "connections")
+            options.numConnections = tools::parseCount(name, value);
+        else if (name == "requests")
+            options.numRequests = tools::parseCount(name, value);
+        else if (name == "warmup")
+            options.numWarmup =
+                (value == "0") ? 0 : tools::parseCount(name, value);
+        else
+            throw std::runtime_error("Unknown option '--" + name + "'");
+    }
+
+    if (options.socketPath.empty() || options.docsPath.empty())
+        throw std::runtime_error("--socket and --docs are required");
+
+    return true;
+}
+
+/**
+ * @brief Get a percentile of sorted latencies, by the nearest rank.
+ *
+ */
+double getPercentile(
+    std::vector<double> const & sortedLatencies, double const percentile)
+{
+    if (sortedLatencies.empty()) return 0;
+
+    std::size_t const rank = static_cast<std::size_t>(
+        percentile / 100 * static_cast<double>(sortedLatencies.size()) +
+        0.999999);
+    return sortedLatencies[std::max<std::size_t>(1, rank) - 1];
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    LoadTestOptions options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+        {
+            std::fputs(USAGE, stdout);
+            return EXIT_SUCCESS;
+        }
+
+        // Load every query group, tasks view their own texts so they are
+        //  kept in place
+        std::deque<ExtractionPipeline::QueryTask> groups;
+        {
+            DocumentReader reader(options.docsPath);
+            auto const readFun = ExtractionPipeline::readDocuments(reader);
+            while (readFun(groups.emplace_back())) {}
+            groups.pop_back();
+        }
+        if (groups.empty())
+            throw std::runtime_error(
+                "No documents in '" + options.docsPath + "'");
+
+        std::vector<std::vector<std::string_view>> groupDocIds;
+        for (auto const & group : groups)
+            groupDocIds.emplace_back(group.docIds.begin(), group.docIds.end());
+
+        std::atomic<std::size_t> nextRequest{0};
+        std::mutex resultMutex;
+        std::vector<double> latencies;  // Microseconds
+        std::size_t numDocs = 0;
+        std::size_t numErrors = 0;
+        std::string firstError;
+
+        auto const sendRequest = [&](
+                                     FeatureClient & client,
+                                     FeatureClient::FeatureRows & rows,
+                                     std::size_t const requestIdx) {
+            auto const & group = groups[requestIdx % groups.size()];
+            if (options.sendIds)
+                client.getFeatures(
+                    group.query, groupDocIds[requestIdx % groups.size()],
+                    rows);
+            else
+                client.getFeatures(group.query, group.docs, rows);
+        };
+
+        // The clock starts once every client is warm. Warmup runs on a
+        //  connection of its own, closed before waiting, so that waiting
+        //  clients do not hold the workers queued clients need to warm up
+        std::mutex warmMutex;
+        std::condition_variable warmCond;
+        std::size_t numWarm = 0;
+        std::chrono::steady_clock::time_point start;
+        auto const waitForWarmup = [&]() {
+            std::unique_lock<std::mutex> lock(warmMutex);
+            if (++numWarm == options.numConnections)
+            {
+                start = std::chrono::steady_clock::now();
+                warmCond.notify_all();
+            }
+            else
+                warmCond.wait(lock, [&]() {
+                    return numWarm == options.numConnections;
+                });
+        };
+
+        auto const connection = [&](std::size_t const connIdx) {
+            std::vector<double> connLatencies;
+            std::size_t connDocs = 0;
+            std::size_t connErrors = 0;
+            std::string connError;
+            bool isWarm = false;
+
+            try
+            {
+                FeatureClient::FeatureRows rows;
+                if (options.numWarmup > 0)
+                {
+                    FeatureClient warmupClient(options.socketPath);
+                    for (std::size_t i = 0; i < options.numWarmup; ++i)
+                        sendRequest(warmupClient, rows, connIdx + i);
+                }
+                isWarm = true;
+                waitForWarmup();
+
+                FeatureClient client(options.socketPath);
+                std::size_t requestIdx;
+                while ((requestIdx = nextRequest++) < options.numRequests)
+                {
+                    auto const requestStart = std::chrono::steady_clock::now();
+                    try
+                    {
+                        sendRequest(client, rows, requestIdx);
+                    }
+                    catch (std::runtime_error const & e)
+                    {
+                        if (connErrors++ == 0) connError = e.what();
+                        continue;
+                    }
+                    connLatencies.push_back(
+                        std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - requestStart)
+                            .count());
+                    connDocs += rows.numDocs;
+                }
+            }
+            catch (std::exception const & e)
+            {
+                // The connection failed
+                ++connErrors;
+                connError = e.what();
+                if (!isWarm) waitForWarmup();
+            }
+
+            std::lock_guard<std::mutex> const lock(resultMutex);
+            latencies.insert(
+                latencies.end(), connLatencies.begin(), connLatencies.end());
+            numDocs += connDocs;
+            numErrors += connErrors;
+            if (firstError.empty()) firstError = connError;
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < options.numConnections; ++i)
+            threads.emplace_back(connection, i);
+        for (auto & thread : threads) thread.join();
+        double const seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+
+        if (!firstError.empty())
+            std::fprintf(
+                stderr, "lowletorfeats-loadtest: %s\n", firstError.c_str());
+
+        std::sort(latencies.begin(), latencies.end());
+        double latencySum = 0;
+        for (double const latency : latencies) latencySum += latency;
+        double const numMeasured = static_cast<double>(latencies.size());
+
+        std::printf(
+            "{\"connections\":%zu,\"requests\":%zu,\"errors\":%zu,"
+            "\"seconds\":%f,\"requests_per_sec\":%f,\"docs_per_sec\":%f,"
+            "\"latency_us\":{\"mean\":%.1f,\"p50\":%.1f,\"p90\":%.1f,"
+            "\"p99\":%.1f,\"max\":%.1f}}\n",
+            options.numConnections, latencies.size(), numErrors, seconds,
+            (seconds > 0) ? numMeasured / seconds : 0,
+            (seconds > 0) ? static_cast<double>(numDocs) / seconds : 0,
+            latencies.empty() ? 0 : latencySum / numMeasured,
+            getPercentile(latencies, 50), getPercentile(latencies, 90),
+            getPercentile(latencies, 99),
+            latencies.empty() ? 0 : latencies.back());
+
+        if (numErrors > 0) return EXIT_FAILURE;
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "lowletorfeats-loadtest: %s\n", e.what());
+        if (argc <= 1) std::fputs(USAGE, stderr);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+#include <pthread.h>  // pthread_sigmask
+#include <signal.h>   // sigwait, kill
+#include <unistd.h>   // getpid
+
+#include <algorithm>  // max
+#include <chrono>
+#include <cstdio>   // fprintf
+#include <cstdlib>  // EXIT_SUCCESS, EXIT_FAILURE
+#include <lowletorfeats/FeatureServer.hpp>
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "toolUtils.hpp"
+
+using namespace lowletorfeats;
+
+namespace
+{
+char const USAGE[] =
+    "Usage:\n"
+    "  lowletorfeats-server --socket=<path> [options]\n"
+    "\n"
+    "Serves feature requests over a Unix domain socket until interrupted.\n"
+    "\n"
+    "Options:\n"
+    "  --index=<file>     Corpus indexed at startup, JSON Lines, to serve\n"
+    "                     requests by document id\n"
+    "  --features=<spec>  \"preset\", comma separated keys, or @file with\n"
+    "                     a key per line (preset)\n"
+    "  --workers=<n>      Connections served concurrently (hardware threads)\n"
+    "  --backlog=<n>      Accepted connections waiting for a worker (64)\n"
+    "  --help             Print this help\n";
+
+struct ServerOptions
+{
+    std::string socketPath;
+    std::string indexPath;
+    std::string featureSpec = "preset";
+    FeatureServer::Options serverOptions;
+};
+
+/**
+ * @brief Parse the command line. Returns false if the help was requested.
+ *
+ */
+bool parseOptions(int const argc, char ** argv, ServerOptions & options)
+{
+    options.serverOptions.numWorkers =
+        std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+
+        std::size_t const eqPos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eqPos == std::string::npos)
+            throw std::runtime_error("Unknown argument '" + arg + "'");
+        std::string const name = arg.substr(2, eqPos - 2);
+        std::string const value = arg.substr(eqPos + 1);
+
+        if (name == "socket")
+            options.socketPath = value;
+        else if (name == "index")
+            options.indexPath = value;
+        else if (name == "features")
+            options.featureSpec = value;
+        else if (name == "workers")
+            options.serverOptions.numWorkers = tools::parseCount(name, value);
+        else if (name == "backlog")
+            options.serverOptions.backlog = tools::parseCount(name, value);
+        else
+            throw std::runtime_error("Unknown option '--" + name + "'");
+    }
+
+    if (options.socketPath.empty())
+        throw std::runtime_error("--socket is required");
+
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    ServerOptions options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+        {
+            std::fputs(USAGE, stdout);
+            return EXIT_SUCCESS;
+        }
+
+        // Everything a request needs is loaded once, here
+        auto const start = std::chrono::steady_clock::now();
+
+        FeaturePlan const plan(tools::parseFeatureSpec(options.featureSpec));
+        FeatureServer server(plan, options.serverOptions);
+
+        InvertedIndex index;
+        std::vector<std::string> docIds;
+        if (!options.indexPath.empty())
+        {
+            tools::buildIndex(options.indexPath, index, docIds);
+            server.setIndex(index, docIds);
+        }
+
+        server.listen(options.socketPath);
+        std::fprintf(
+            stderr,
+            "{\"socket\":\"%s\",\"index_docs\":%zu,\"features\":%zu,"
+            "\"workers\":%zu,\"load_seconds\":%f}\n",
+            options.socketPath.c_str(), index.getNumDocs(),
+            plan.getFeatureKeys().size(), options.serverOptions.numWorkers,
+            std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start)
+                .count());
+
+        // Handle SIGINT and SIGTERM on a thread of their own, blocked in the
+        //  other threads, so that `stop` is not called from a handler
+        sigset_t stopSignals;
+        sigemptyset(&stopSignals);
+        sigaddset(&stopSignals, SIGINT);
+        sigaddset(&stopSignals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+        std::thread signalThread([&server, &stopSignals]() {
+            int signalNum;
+            sigwait(&stopSignals, &signalNum);
+            server.stop();
+        });
+
+        try
+        {
+            server.run();
+        }
+        catch (...)
+        {
+            ::kill(::getpid(), SIGTERM);
+            signalThread.join();
+            throw;
+        }
+        signalThread.join();
+
+        TimingStat const requestTiming = server.getRequestTiming();
+        std::fprintf(
+            stderr, "{\"requests\":%llu,\"request_seconds\":%f}\n",
+            static_cast<unsigned long long>(requestTiming.calls),
+            static_cast<double>(requestTiming.nanoseconds) / 1e9);
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "lowletorfeats-server: %s\n", e.what());
+        if (argc <= 1) std::fputs(USAGE, stderr);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>  // min
+#include <exception>
+#include <fstream>
+#include <lowletorfeats/DocumentReader.hpp>
+#include <lowletorfeats/FeatureCollector.hpp>
+#include <lowletorfeats/InvertedIndex.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Helpers shared by the command-line tools
+namespace lowletorfeats::tools
+{
+/**
+ * @brief Parse the positive integer value of an option.
+ *
+ */
+inline std::size_t parseCount(
+    std::string const & name, std::string const & value)
+{
+    std::size_t pos = 0;
+    unsigned long count = 0;
+    try
+    {
+        count = std::stoul(value, &pos);
+    }
+    catch (std::exception const &)
+    {
+        pos = 0;
+    }
+    if (pos == 0 || pos != value.size() || count == 0)
+        throw std::runtime_error(
+            "Expected a positive integer for --" + name + ", got '" + value +
+            "'");
+
+    return count;
+}
+
+/**
+ * @brief Get the feature keys of a "preset", "key,key" or "@file" spec.
+ *
+ */
+inline std::vector<base::FeatureKey> parseFeatureSpec(std::string const & spec)
+{
+    if (spec == "preset") return FeatureCollector::getPresetFeatureKeys();
+
+    std::vector<base::FeatureKey> fKeys;
+    auto const addKey = [&fKeys](std::string keyStr) {
+        // Trim whitespace
+        keyStr.erase(0, keyStr.find_first_not_of(" \t\r"));
+        keyStr.erase(keyStr.find_last_not_of(" \t\r") + 1);
+        if (!keyStr.empty()) fKeys.emplace_back(keyStr);
+    };
+
+    if (!spec.empty() && spec[0] == '@')
+    {
+        std::ifstream inFile(spec.substr(1));
+        if (!inFile)
+            throw std::runtime_error(
+                "Could not open '" + spec.substr(1) + "'");
+        std::string line;
+        while (std::getline(inFile, line)) addKey(line);
+    }
+    else
+    {
+        std::size_t pos = 0;
+        while (pos <= spec.size())
+        {
+            std::size_t const commaPos =
+                std::min(spec.find(',', pos), spec.size());
+            addKey(spec.substr(pos, commaPos - pos));
+            pos = commaPos + 1;
+        }
+    }
+
+    if (fKeys.empty()) throw std::runtime_error("No features to extract");
+
+    return fKeys;
+}
+
+/**
+ * @brief Index every document of a JSON Lines corpus, keeping their ids in
+ *  index order.
+ *
+ */
+inline void buildIndex(
+    std::string const & path, InvertedIndex & index,
+    std::vector<std::string> & docIds)
+{
+    DocumentReader reader(path);
+    DocumentReader::QueryGroup group;
+    std::vector<base::StrStrMap> docTextMapVect;
+    while (reader.next(group))
+    {
+        docTextMapVect.clear();
+        for (std::size_t docIdx = 0; docIdx < group.getNumDocs(); ++docIdx)
+        {
+            base::StrStrMap & docTextMap = docTextMapVect.emplace_back();
+            for (auto const & [sectionKey, sectionText] : group.docs[docIdx])
+                docTextMap[std::string(sectionKey)] = sectionText;
+
+            // Documents without an id are numbered
+            docIds.emplace_back(
+                group.docIds[docIdx].empty()
+                    ? std::to_string(docIds.size())
+                    : std::string(group.docIds[docIdx]));
+        }
+        index.addDocs(docTextMapVect);
+    }
+}
+
+}  // namespace lowletorfeats::tools